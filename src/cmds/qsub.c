@@ -211,6 +211,7 @@ static int recv_attrl(void *s, struct attrl **attrib);
 static int send_string(void *s, char *str);
 static int recv_string(void *s, char *str);
 
+static int prep_submit(char *retmsg);
 static int do_submit(char *retmsg);
 static int do_submit2(char *rmsg);
 static void get_comm_filename(char *fl);
@@ -4583,7 +4584,8 @@ print_usage()
 	"\t[-R o|e|oe] [-S path] [-u user_list] [-W otherattributes=value...]\n"
 	"\t[-v variable_list] [-V ] [-z] [script | -- command [arg1 ...]]\n";
 #else
-	static char usag2[]="       qsub --version\n";
+	static char usag2[]="       qsub --batch file\n"
+		"       qsub --version\n";
 	static char usage[]=
 		"usage: qsub [-a date_time] [-A account_string] [-c interval]\n"
 	"\t[-C directive_prefix] [-e path] [-f ] [-h ] [-I [-X]] [-j oe|eo] [-J X-Y[:Z]]\n"
@@ -4698,6 +4700,296 @@ handle_attribute_errors(struct ecl_attribute_errors *err_list,
 	return 0;
 }
 
+#ifndef WIN32
+#define QSUB_BATCH_LINE	4096	/* longest line make_argv() can take */
+
+static int batch_sock = -1;	/* to the parent, in a child of "qsub --batch" */
+
+/**
+ * @brief
+ *	Check whether two job script files have the same contents.
+ *
+ * @param[in]	path1 - first script file
+ * @param[in]	path2 - second script file
+ *
+ * @return	int
+ * @retval	1 - the files are the same
+ * @retval	0 - the files differ or cannot be read
+ *
+ */
+static int
+same_script(char *path1, char *path2)
+{
+	char b1[BUFSIZ];
+	char b2[BUFSIZ];
+	FILE *f1;
+	FILE *f2;
+	size_t n1;
+	size_t n2;
+	int same = 0;
+
+	if ((f1 = fopen(path1, "r")) == NULL)
+		return 0;
+	if ((f2 = fopen(path2, "r")) == NULL) {
+		(void)fclose(f1);
+		return 0;
+	}
+	for (;;) {
+		n1 = fread(b1, 1, sizeof(b1), f1);
+		n2 = fread(b2, 1, sizeof(b2), f2);
+		if ((n1 != n2) || (memcmp(b1, b2, n1) != 0))
+			break;
+		if (n1 == 0) {
+			same = 1;
+			break;
+		}
+	}
+	(void)fclose(f1);
+	(void)fclose(f2);
+	return same;
+}
+
+/**
+ * @brief
+ *	Hand the job of one batch line to the parent "qsub --batch" instead
+ *	of submitting it, then exit.
+ *
+ * @par
+ *	The attributes, destination and script file name of the job are
+ *	sent over 'sock'; the script file is left for the parent to remove.
+ *
+ * @param[in]	sock - socket to the parent qsub
+ *
+ * @return	void
+ *	Does not return; exits with 0 on success, 1 otherwise.
+ */
+static void
+batch_send(int sock)
+{
+	char rmsg[MAXPATHLEN];
+
+	rmsg[0] = '\0';
+	if (server_out[0] != '\0')
+		snprintf(rmsg, sizeof(rmsg),
+			"qsub: --batch jobs cannot name a server\n");
+	else if (Interact_opt || block_opt)
+		snprintf(rmsg, sizeof(rmsg),
+			"qsub: --batch jobs cannot be interactive or blocking\n");
+	else if (cred_name[0] != '\0')
+		snprintf(rmsg, sizeof(rmsg),
+			"qsub: --batch jobs cannot carry credentials\n");
+	else if (prep_submit(rmsg) == 0) {
+		if ((send_attrl(&sock, attrib) == 0) &&
+			(send_string(&sock, destination) == 0) &&
+			(send_string(&sock, script_tmp) == 0))
+			exit_qsub(0);
+		snprintf(rmsg, sizeof(rmsg),
+			"qsub: cannot pass the job to the parent qsub\n");
+	}
+	(void)unlink(script_tmp);
+	fprintf(stderr, "%s", rmsg);
+	exit_qsub(1);
+}
+
+/**
+ * @brief
+ *	Submit one job for each line of a batch file ("qsub --batch file").
+ *
+ * @par
+ *	Each line holds the qsub options and script (or "-- command") of one
+ *	job; blank lines and lines starting with '#' are skipped.  A child
+ *	qsub is forked for every line and returns from this function with
+ *	the line's arguments, so that it parses them with the normal qsub
+ *	code; batch_send() then passes the job back here.  Once every line
+ *	has been parsed, all of the jobs are sent to the server in a single
+ *	pbs_submit_batch() request, with the script shared if the jobs have
+ *	the same one.  If any line fails, no job is submitted.
+ *
+ * @param[in]	file  - the batch file, "-" for standard input
+ * @param[out]	pargc - set to the argument count of the line, in the child
+ * @param[out]	pargv - set to the arguments of the line, in the child
+ *
+ * @return	void
+ *	Returns only in the child; the parent exits with 0 if the jobs
+ *	were submitted, 1 otherwise.
+ */
+static void
+batch_submit(char *file, int *pargc, char ***pargv)
+{
+	static char *vect[QSUB_BATCH_LINE / 2 + 2];
+	char line[QSUB_BATCH_LINE];
+	char rmsg[MAXPATHLEN];
+	struct batch_job *jobs = NULL;
+	struct batch_job **tail = &jobs;
+	struct batch_job *pj;
+	struct attrl *pattr;
+	struct ecl_attribute_errors *err_list;
+	char *shared = NULL;
+	char **jobids;
+	char *errmsg;
+	FILE *fp;
+	char *pc;
+	int lineno = 0;
+	int nerr = 0;
+	int sv[2];
+	int rc;
+	int i;
+	int status;
+	pid_t pid;
+
+	if (strcmp(file, "-") == 0)
+		fp = stdin;
+	else if ((fp = fopen(file, "r")) == NULL) {
+		fprintf(stderr, "qsub: cannot open batch file %s: %s\n",
+			file, strerror(errno));
+		exit_qsub(1);
+	}
+
+	/* the children inherit the connection and default_qsub_arguments */
+	rmsg[0] = '\0';
+	if (do_connect(server_out, rmsg) != 0) {
+		fprintf(stderr, "%s", rmsg);
+		exit_qsub(1);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		lineno++;
+		if ((pc = strchr(line, '\n')) != NULL) {
+			*pc = '\0';
+		} else if (!feof(fp)) {
+			fprintf(stderr, "qsub: batch line %d too long\n", lineno);
+			nerr++;
+			while ((fgets(line, sizeof(line), fp) != NULL) &&
+				(strchr(line, '\n') == NULL))
+				;
+			continue;
+		}
+		for (pc = line; isspace((int)*pc); pc++)
+			;
+		if ((*pc == '\0') || (*pc == '#'))
+			continue;
+
+		if ((pj = calloc(1, sizeof(struct batch_job))) == NULL) {
+			fprintf(stderr, "qsub: out of memory\n");
+			nerr++;
+			break;
+		}
+		*tail = pj;
+		tail = &pj->next;
+
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+			perror("qsub: socketpair");
+			nerr++;
+			break;
+		}
+		(void)fflush(stdout);
+		(void)fflush(stderr);
+		pid = fork();
+		if (pid == -1) {
+			perror("qsub: fork");
+			(void)close(sv[0]);
+			(void)close(sv[1]);
+			nerr++;
+			break;
+		}
+		if (pid == 0) {
+			(void)close(sv[0]);
+			batch_sock = sv[1];
+			/* the script must come from the line, not our input */
+			if (fp != stdin)
+				(void)fclose(fp);
+			if (freopen("/dev/null", "r", stdin) == NULL) {
+				perror("qsub: /dev/null");
+				exit_qsub(1);
+			}
+			make_argv(pargc, vect, pc);
+			*pargv = vect;
+			return;
+		}
+
+		(void)close(sv[1]);
+		pattr = NULL;
+		rc = recv_attrl(&sv[0], &pattr);
+		pj->attribs = (struct attropl *)pattr;
+		if (rc == 0)
+			rc = recv_dyn_string(&sv[0], &pj->destination);
+		if (rc == 0)
+			rc = recv_dyn_string(&sv[0], &pj->script);
+		(void)close(sv[0]);
+		while ((waitpid(pid, &status, 0) == -1) && (errno == EINTR))
+			;
+		if ((rc != 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+			fprintf(stderr, "qsub: batch line %d not submitted\n",
+				lineno);
+			nerr++;
+		}
+	}
+	if (fp != stdin)
+		(void)fclose(fp);
+
+	if ((nerr == 0) && (jobs != NULL)) {
+		/*
+		 * Send the script once when every job has one: the jobs
+		 * whose script matches the first job's use the shared copy
+		 */
+		for (pj = jobs; pj; pj = pj->next) {
+			if (pj->script[0] == '\0')
+				break;
+		}
+		if (pj == NULL) {
+			shared = jobs->script;
+			jobs->script = NULL;
+			for (pj = jobs->next; pj; pj = pj->next) {
+				if (same_script(shared, pj->script)) {
+					(void)unlink(pj->script);
+					free(pj->script);
+					pj->script = NULL;
+				}
+			}
+		}
+
+		pbs_errno = 0;
+		jobids = pbs_submit_batch(sd_svr, jobs, shared, NULL);
+		if (jobids == NULL) {
+			rmsg[0] = '\0';
+			if (((err_list = pbs_get_attributes_in_error(sd_svr)) == NULL) ||
+				(handle_attribute_errors(err_list, rmsg) == 0)) {
+				if ((errmsg = pbs_geterrmsg(sd_svr)) != NULL)
+					snprintf(rmsg, sizeof(rmsg), "qsub: %s\n", errmsg);
+				else
+					snprintf(rmsg, sizeof(rmsg),
+						"qsub: Error (%d) submitting jobs\n", pbs_errno);
+			}
+			fprintf(stderr, "%s", rmsg);
+			nerr++;
+		} else {
+			for (i = 0; jobids[i] != NULL; i++)
+				printf("%s\n", jobids[i]);
+			free(jobids);
+		}
+	} else if (nerr != 0) {
+		fprintf(stderr, "qsub: no job submitted\n");
+	}
+
+	if (shared != NULL) {
+		(void)unlink(shared);
+		free(shared);
+	}
+	while (jobs != NULL) {
+		pj = jobs;
+		jobs = jobs->next;
+		if ((pj->script != NULL) && (pj->script[0] != '\0'))
+			(void)unlink(pj->script);
+		free(pj->script);
+		free(pj->destination);
+		free_attrl((struct attrl *)pj->attribs);
+		free(pj);
+	}
+	(void)pbs_disconnect(sd_svr);
+	exit_qsub(nerr ? 1 : 0);
+}
+#endif
+
 
 int
 main(int argc, char **argv, char **envp)   /* qsub */
@@ -4783,6 +5075,12 @@ main(int argc, char **argv, char **envp)   /* qsub */
 #endif
 	strcpy(qsub_exe, argv[0]); /* note the name of the qsub executable */
 
+#ifndef WIN32
+	/* returns in a child qsub with the arguments of one batch line */
+	if ((argc == 3) && (strcmp(argv[1], "--batch") == 0))
+		batch_submit(argv[2], &argc, &argv);
+#endif
+
 	/*
 	 * If qsub command is submitted with arguments, then capture them and
 	 * encode in XML format using encode_xml_arg_list() and set the
@@ -4949,6 +5247,12 @@ main(int argc, char **argv, char **envp)   /* qsub */
 		qsub_envlist = env_array_to_varlist(envp);
         }
 
+#ifndef WIN32
+	/* a child of "qsub --batch" hands its job to the parent qsub */
+	if (batch_sock != -1)
+		batch_send(batch_sock);
+#endif
+
 	/*
 	 * Disable backgrounding if we are inside another qsub
 	 */
@@ -5850,23 +6154,20 @@ do_connect(char *server_out, char *retmsg)
 
 /**
  * @brief
- *	This functions does a job submission ot the server using the global
- *	connected server socket sd_svr.
+ *	Completes the job attributes before submission: applies the server's
+ *	default qsub arguments and sets the job environment.
  *
  * @param[out] retmsg	 - Any error string is returned in this parameter
  *
  * @return int
  * @retval 0 - Success
- * @retval 1/-1/pbs_errno - Failure, retmsg paramter is set
+ * @retval !0 - Failure, retmsg paramter is set
  *
  */
 static int
-do_submit(char *retmsg)
+prep_submit(char *retmsg)
 {
-	struct ecl_attribute_errors *err_list;
-	char *new_jobname = NULL;
 	int rc;
-	char *errmsg;
 	int retries;
 
 	if (dfltqsubargs != NULL) {
@@ -5905,6 +6206,31 @@ do_submit(char *retmsg)
 #endif
 		return 1;
 	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	This functions does a job submission ot the server using the global
+ *	connected server socket sd_svr.
+ *
+ * @param[out] retmsg	 - Any error string is returned in this parameter
+ *
+ * @return int
+ * @retval 0 - Success
+ * @retval 1/-1/pbs_errno - Failure, retmsg paramter is set
+ *
+ */
+static int
+do_submit(char *retmsg)
+{
+	struct ecl_attribute_errors *err_list;
+	char *new_jobname = NULL;
+	int rc;
+	char *errmsg;
+
+	if ((rc = prep_submit(retmsg)) != 0)
+		return (rc);
 
 	if (cred_name[0]) {
 		if (strcmp(cred_name, PBS_CREDNAME_DCE_KRB5) == 0 ||
@@ -80,6 +80,7 @@ extern "C" {
 
 extern int  acct_open(char *filename);
 extern void acct_close(void);
+extern void acct_sync(void);
 extern void account_record(int acctype, job *pjob, char *text);
 extern void write_account_record(int acctype, char *jobid, char *text);
 
@@ -296,6 +296,24 @@ struct array_strings {
 	char   *as_string[1];	/* first string pointer */
 };
 
+/*
+ * case-insensitive hash index over the names in a definition table,
+ * used by find_attr() and find_resc_def()
+ */
+
+struct name_idx {
+	void	*ni_owner;	/* definition table indexed, NULL if unused */
+	int	 ni_count;	/* number of names indexed */
+	int	 ni_nbucket;	/* number of hash buckets, a power of 2 */
+	int	*ni_bucket;	/* first position in each bucket, -1 if empty */
+	int	*ni_chain;	/* next position in the same bucket, -1 at end */
+	char   **ni_name;	/* name at each position */
+};
+
+extern int  name_idx_build(struct name_idx *pidx, void *owner, char **names, int count);
+extern int  name_idx_find(struct name_idx *pidx, char *name, int limit);
+extern void name_idx_free(struct name_idx *pidx);
+
 /*
  * specific attribute value function prototypes
  */
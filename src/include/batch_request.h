@@ -84,6 +84,25 @@ struct rq_queuejob {
 	pbs_list_head	   rq_attr;	/* svrattrlist */
 };
 
+/* SubmitJobs, one job of the request */
+
+struct rq_submitjob {
+	pbs_list_link	   rq_link;
+	char		   rq_destin[PBS_MAXDEST+1];
+	pbs_list_head	   rq_attr;	/* svrattrlist */
+	size_t		   rq_scriptsz;
+	char		  *rq_script;	/* NULL for the shared script */
+};
+
+/* SubmitJobs */
+
+struct rq_submitjobs {
+	int		   rq_numjobs;
+	size_t		   rq_scriptsz;
+	char		  *rq_script;	/* shared script */
+	pbs_list_head	   rq_jobs;	/* list of rq_submitjob */
+};
+
 /* JobCredential */
 
 struct rq_jobcred {
@@ -341,6 +360,7 @@ struct batch_request {
 		struct rq_authen_external	rq_authen_external;
 		int			rq_connect;
 		struct rq_queuejob	rq_queuejob;
+		struct rq_submitjobs	rq_submitjobs;
 		struct rq_jobcred       rq_jobcred;
 		struct rq_gssdata	rq_gssdata;
 		struct rq_jobfile	rq_jobfile;
@@ -455,6 +475,7 @@ extern int decode_DIS_Run(int socket, struct batch_request *);
 extern int decode_DIS_ShutDown(int socket, struct batch_request *);
 extern int decode_DIS_SignalJob(int socket, struct batch_request *);
 extern int decode_DIS_Status(int socket, struct batch_request *);
+extern int decode_DIS_SubmitJobs(int socket, struct batch_request *);
 extern int decode_DIS_TrackJob(int socket, struct batch_request *);
 extern int decode_DIS_replySvr(int socket, struct batch_reply *);
 extern int decode_DIS_svrattrl(int socket, pbs_list_head *);
@@ -102,6 +102,24 @@ typedef enum hook_user hook_user;
 #define MOM_EVENTS	(HOOK_EVENT_EXECJOB_BEGIN|HOOK_EVENT_EXECJOB_PROLOGUE|HOOK_EVENT_EXECJOB_EPILOGUE|HOOK_EVENT_EXECJOB_END|HOOK_EVENT_EXECJOB_PRETERM|HOOK_EVENT_EXECHOST_PERIODIC|HOOK_EVENT_EXECJOB_LAUNCH|HOOK_EVENT_EXECHOST_STARTUP|HOOK_EVENT_EXECJOB_ATTACH)
 #define USER_MOM_EVENTS	(HOOK_EVENT_EXECJOB_PROLOGUE|HOOK_EVENT_EXECJOB_EPILOGUE|HOOK_EVENT_EXECJOB_PRETERM)
 #define FAIL_ACTION_EVENTS (HOOK_EVENT_EXECJOB_BEGIN|HOOK_EVENT_EXECHOST_STARTUP|HOOK_EVENT_EXECJOB_PROLOGUE)
+
+/*
+ * Execution statistics kept by the server for each event a hook runs on,
+ * indexed by the bit number of the HOOK_EVENT_* flag. Times are in seconds.
+ * 'setup' is time spent populating the pbs.event() objects and 'run' is
+ * time spent in the hook script itself.
+ */
+#define HOOK_STATS_NEVENTS	16
+struct hook_stats {
+	unsigned long	count;		/* # of times the hook ran */
+	unsigned long	accepts;	/* # of times the event was accepted */
+	unsigned long	rejects;	/* # of times the event was rejected */
+	double		total;		/* total wall time */
+	double		max;		/* longest single execution */
+	double		setup;		/* wall time populating objects */
+	double		run;		/* wall time running the script */
+};
+
 struct hook {
 	char 		*hook_name;	/* unique name of the hook */
 	hook_type	type;		/* site-defined or pbs builtin */
@@ -141,6 +159,7 @@ struct hook {
 	pbs_list_link 	hi_exechost_startup_hooks;
 	pbs_list_link	hi_execjob_attach_hooks;
 	struct work_task *ptask;		    /* work task pointer, used in periodic hooks */
+	struct hook_stats *stats;	/* HOOK_STATS_NEVENTS entries, or NULL */
 };
 
 typedef struct hook hook;
@@ -191,6 +210,7 @@ typedef struct hook hook;
 #define	HOOKATT_FREQ		"freq"
 #define	HOOKATT_FAIL_ACTION	"fail_action"
 #define	HOOKATT_PENDING_DELETE  "pending_delete"
+#define	HOOKATT_STATS		"stats"	/* read-only, server only */
 
 #define	HOOK_PBS_PREFIX		"PBS"  /* valid Hook name prefix for PBS hook */
 
@@ -277,6 +297,18 @@ typedef struct hook hook;
 #define	FMT_HOOK_RESCDEF_COPY "%s" FMT_HOOK_PREFIX "resourcedef.%s"
 #define	FMT_HOOK_LOG "%s" FMT_HOOK_PREFIX "log%d"
 
+/*
+ * pbs_python --hook-pool <socket> runs hooks for MoM from one started
+ * interpreter.  A request is an int length followed by that many bytes of
+ * nul terminated strings: the working directory, the hook config file ("" if
+ * none), then the arguments of pbs_python --hook.  The reply is the hook's
+ * wait status as an int.  The socket name does not start with
+ * FMT_HOOK_PREFIX so hook workdir cleanup leaves it alone.
+ */
+#define	HOOK_POOL_MODE "--hook-pool"
+#define	FMT_HOOK_POOL_SOCK "%spbs_python_pool"
+#define	HOOK_POOL_MAXREQ 65536
+
 /* Special log levels  - values must not intersect PBS_EVENT* values in log.h */
 
 #define SEVERITY_LOG_DEBUG		0x0005		/* syslog DEBUG */
@@ -359,6 +391,7 @@ extern char *hook_freq_as_string(int);
 extern char *hook_order_as_string(short);
 extern char *hook_user_as_string(hook_user);
 extern char *hook_fail_action_as_string(unsigned int);
+extern char *hook_stats_as_string(hook *);
 
 #ifdef	_WORK_TASK_H
 extern void cleanup_hooks_workdir(struct work_task *);
@@ -425,6 +425,7 @@ typedef struct	noderes {
 
 
 #define PBS_MAX_POLL_DOWNTIME 300 /* 5 minutes by default */
+#define PBS_RESC_UPDATE_FULL 10 /* every 10th resources_used update is sent in full */
 #endif	/* MOM */
 
 /*
@@ -455,6 +456,22 @@ struct ajtrkhd {
 	/* of tkm_tbl entries (ct-1) will be included			   */
 };
 
+/*
+ * runs of consecutive subjob table offsets which are queued, sorted by
+ * offset; lets array_indices_remaining be encoded without walking the
+ * whole subjob index table.  Not saved, rebuilt from the table as needed.
+ */
+struct ajrun {
+	int	ar_first;	/* first table offset in the run */
+	int	ar_last;	/* last table offset in the run  */
+};
+
+struct ajqueued {
+	int	aq_nruns;	   /* number of runs in use	     */
+	int	aq_size;	   /* number of runs allocated	     */
+	struct ajrun aq_runs[1];   /* room for aq_size runs follows  */
+};
+
 /*
  * Discard Job Structure,  see Server's discard_job function
  *	Used to record which Mom has responded to when we need to tell them
@@ -538,6 +555,9 @@ struct job {
 	int		ji_mjspipe2;	/* pipe for parent mom to ack special request from child starter process */
 	int		ji_updated;	/* set to 1 if job's node assignment was updated */
 	time_t		ji_walltime_stamp;	/* time stamp for accumulating walltime */
+	pbs_list_head	ji_rused_sent;	/* resources_used last sent to server */
+	int		ji_rused_gen;	/* server connection ji_rused_sent belongs to */
+	int		ji_rused_cycles; /* updates since the last full update */
 #ifdef WIN32
 	HANDLE		ji_momsubt;	/* process HANDLE to mom subtask */
 #else	/* not WIN32 */
@@ -582,6 +602,7 @@ struct job {
 	pbs_list_head	ji_rejectdest;	/* list of rejected destinations */
 	struct job     *ji_parentaj;	/* subjob:   parent Array Job */
 	struct ajtrkhd *ji_ajtrk;	/* ArrayJob: index tracking table */
+	struct ajqueued *ji_ajqueued;	/* ArrayJob: runs of queued subjobs */
 	int		ji_subjindx;	/* subjob:   its index into the table */
 	struct jbdscrd *ji_discard;	/* see discard_job() */
 	int		ji_jdcd_waiting;/* set if waiting on a mom for a response to discard job request */
@@ -611,6 +632,21 @@ struct job {
 	char           *ji_script;
 	int             ji_entity_limit_set;/* indicator that the entity limits are incremented */
 
+	/*
+	 *	Secondary indexes, maintained by svr_enquejob()/svr_dequejob()
+	 *	and svr_setjobstate(): every job on svr_alljobs is also linked
+	 *	on the list of jobs in the same state and on the list of jobs
+	 *	of the same owner.
+	 */
+	pbs_list_link	ji_statejobs;	/* links to jobs in same state */
+	int		ji_idxstate;	/* state list the job is linked on */
+	pbs_list_link	ji_histjobs;	/* links to history jobs by history_timestamp */
+	pbs_list_link	ji_histwarm;	/* links to history jobs not yet packed */
+	char		*ji_histpack;	/* packed cold attributes of a history job */
+	int		ji_histpacklen;	/* size of ji_histpack */
+	pbs_list_link	ji_ownerjobs;	/* links to jobs of same owner */
+	struct jobidx_owner *ji_owneridx; /* owner index entry, if linked */
+
 #endif					/* END SERVER ONLY */
 
 	/*
@@ -1110,6 +1146,17 @@ extern int   state_char2int(char);
 extern int   uniq_nameANDfile(char*, char*, char*);
 extern long  determine_accruetype(job *);
 extern int   update_eligible_time(long, job *);
+#ifndef PBS_MOM
+extern pbs_list_head svr_jobs_by_state[];
+extern pbs_list_head svr_histjobs;
+extern pbs_list_head svr_histwarm;
+extern void  svr_jobidx_state(job *);
+extern void  svr_histjobs_recov(int);
+extern void  job_hist_pack(job *);
+extern int   job_hist_unpack(job *);
+extern int   job_hist_is_cold(int);
+extern pbs_list_head *svr_jobs_by_owner(char *, int *);
+#endif
 
 /*
  *	The filesystem related recovery/save routines are renamed
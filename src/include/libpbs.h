@@ -281,6 +281,7 @@ struct batch_reply {
 #define PBS_BATCH_HookPeriodic  89
 #define PBS_BATCH_RelnodesJob	90
 #define PBS_BATCH_ModifyResv	91
+#define PBS_BATCH_SubmitJobs	92
 
 #define PBS_BATCH_FileOpt_Default	0
 #define PBS_BATCH_FileOpt_OFlg		1
@@ -343,6 +344,7 @@ extern struct batch_status *PBSD_status(int c, int function,
 extern struct batch_status *PBSD_status_get(int c);
 extern char * PBSD_queuejob(int c, char *j, char *d,
 	struct attropl *a, char *ex, int rpp, char **msgid);
+extern char **PBSD_select_get(int c);
 extern int decode_DIS_svrattrl(int sock, pbs_list_head *phead);
 extern int decode_DIS_attrl(int sock, struct attrl **ppatt);
 extern int decode_DIS_JobId(int socket, char *jobid);
@@ -362,6 +364,8 @@ extern int encode_DIS_RelnodesJob(int socket, char *jid, char *node_list);
 extern int encode_DIS_PySpawn(int socket, char *jid, char **argv, char **envp);
 extern int encode_DIS_QueueJob(int socket, char *jid,
 	char *dest, struct attropl *);
+extern int encode_DIS_SubmitJobs(int socket, struct batch_job *jobs,
+	char *script, char **scripts);
 extern int encode_DIS_SubmitResv(int sock, char *resv_id, struct attropl *aoplp);
 extern int encode_DIS_JobCredential(int sock, int type, char *buf, int len);
 extern int encode_DIS_ReqExtend(int socket, char *extend);
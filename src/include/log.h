@@ -61,6 +61,9 @@
 
 #define LOG_BUF_SIZE		4096
 
+/* suffix of the job index kept next to a log file, see log_index_open() */
+#define LOG_INDEX_SUFFIX	".idx"
+
 /* The following macro assist in sharing code between the Server and Mom */
 #define LOG_EVENT log_event
 
@@ -103,6 +106,10 @@ extern void log_suspect_file(const char *func, const char *text, const char *fil
 extern int  log_open(char *name, char *directory);
 extern int  log_open_main(char *name, char *directory, int silent);
 extern void log_record(int type, int objclass, int severity, const char *objname, const char *text);
+extern int  log_async_start(void);
+extern void log_async_flush(void);
+extern int  log_index_open(const char *path, int fd);
+extern void log_index_write(int idxfd, const char *id, long long offset);
 extern char log_buffer[LOG_BUF_SIZE];
 extern int log_level_2_etype(int level);
 
@@ -511,6 +511,14 @@ struct batch_status {
 	char		    *text;
 };
 
+/* one job of a pbs_submit_batch() request */
+struct batch_job {
+	struct batch_job *next;
+	struct attropl	 *attribs;
+	char		 *script;	/* NULL to use the shared script */
+	char		 *destination;
+};
+
 /* structure to hold an attribute that failed verification at ECL
  * and the associated errcode and errmsg
  */
@@ -630,6 +638,8 @@ DECLDIR struct ecl_attribute_errors * pbs_get_attributes_in_error(int);
 
 DECLDIR char *pbs_submit(int, struct attropl *, char *, char *, char *);
 
+DECLDIR char **pbs_submit_batch(int, struct batch_job *, char *, char *);
+
 DECLDIR char *pbs_submit_resv(int, struct attropl *, char *);
 
 DECLDIR int pbs_delresv(int, char *, char *);
@@ -721,6 +731,8 @@ extern struct ecl_attribute_errors * pbs_get_attributes_in_error(int);
 
 extern char *pbs_submit(int, struct attropl *, char *, char *, char *);
 
+extern char **pbs_submit_batch(int, struct batch_job *, char *, char *);
+
 extern char *pbs_submit_resv(int, struct attropl *, char *);
 
 extern int pbs_delresv(int, char *, char *);
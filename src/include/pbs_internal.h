@@ -180,6 +180,10 @@ extern "C" {
 /* Default value of Node fail requeue (ATTR_nodefailrq)*/
 #define PBS_NODE_FAIL_REQUEUE_DEFAULT	310
 
+/* values of pbs_conf.pbs_acct_format, may be or'ed */
+#define PBS_ACCT_FORMAT_TEXT	1	/* classic "key=value" records */
+#define PBS_ACCT_FORMAT_JSON	2	/* JSON lines, in <accounting file>.json */
+
 struct pbs_config
 {
 	unsigned loaded:1;			/* has the conf file been loaded? */
@@ -232,6 +236,14 @@ struct pbs_config
 	char *pbs_comm_routers;		/* for this router, the optional list of other routers to talk to */
 	long  pbs_comm_log_events;      /* log_events for pbs_comm process, default 0 */
 	unsigned int pbs_comm_threads;	/* number of threads for router, default 4 */
+	unsigned int pbs_comm_coalesce_ms;	/* window to coalesce small TPP sends in, default 0 (off) */
+	char *pbs_compression_codec;	/* codec to compress communication data with, default zlib */
+	unsigned int pbs_compression_threshold;	/* compress only data larger than this, 0 for the default */
+	unsigned pbs_compression_adaptive:1;	/* whether to stop compressing data that does not compress */
+	unsigned pbs_log_async:1;	/* whether daemons buffer log records and write them from a thread */
+	unsigned pbs_log_index:1;	/* whether daemons keep a job index of their log files */
+	unsigned pbs_acct_format:2;	/* PBS_ACCT_FORMAT_* formats the server writes accounting records in */
+	unsigned int pbs_acct_flush;	/* seconds the server may hold accounting records, 0 to write each one */
 	char *pbs_mom_node_name;	/* mom short name used for natural node, default NULL */
 #ifdef WIN32
 	char *pbs_conf_remote_viewer; /* Remote viewer client executable for PBS GUI jobs, along with launch options */
@@ -272,6 +284,14 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_COMM_ROUTERS		     "PBS_COMM_ROUTERS"
 #define PBS_CONF_COMM_THREADS		     "PBS_COMM_THREADS"
 #define PBS_CONF_COMM_LOG_EVENTS	     "PBS_COMM_LOG_EVENTS"
+#define PBS_CONF_COMM_COALESCE_MS	     "PBS_COMM_COALESCE_MS"
+#define PBS_CONF_COMPRESSION_CODEC	     "PBS_COMPRESSION_CODEC"
+#define PBS_CONF_COMPRESSION_THRESHOLD	     "PBS_COMPRESSION_THRESHOLD"
+#define PBS_CONF_COMPRESSION_ADAPTIVE	     "PBS_COMPRESSION_ADAPTIVE"
+#define PBS_CONF_LOG_ASYNC		     "PBS_LOG_ASYNC"
+#define PBS_CONF_LOG_INDEX		     "PBS_LOG_INDEX"
+#define PBS_CONF_ACCT_FORMAT		     "PBS_ACCT_FORMAT"
+#define PBS_CONF_ACCT_FLUSH		     "PBS_ACCT_FLUSH"
 #define PBS_CONF_HOME		"PBS_HOME"	 	 /* path to pbs home */
 #define PBS_CONF_EXEC		"PBS_EXEC"		 /* path to pbs exec */
 #define PBS_CONF_DEFAULT_NAME	"PBS_DEFAULT"	  /* old name for PBS_SERVER */
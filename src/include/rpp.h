@@ -66,6 +66,11 @@ extern "C" {
 #define TPP_AUTH_RESV_PORT	1
 #define TPP_AUTH_EXTERNAL	2
 
+/* TPP compression codecs, values of tpp_config.compress */
+#define TPP_COMPR_NONE		0
+#define TPP_COMPR_ZLIB		1
+#define TPP_COMPR_LZ		2
+
 struct tpp_config {
 	int    node_type; /* leaf, proxy */
 	char   **routers; /* other proxy names (and backups) to connect to */
@@ -74,13 +79,16 @@ struct tpp_config {
 	char   auth_type;
 	void * (*get_ext_auth_data)(int auth_type, int *data_len, char *ebuf, int ebufsz);
 	int    (*validate_ext_auth_data) (int auth_type, void *data, int data_len, char *ebuf, int ebufsz);
-	int    compress;
+	int    compress; /* compression codec, TPP_COMPR_XXX */
+	int    compress_min; /* compress only data larger than this */
+	int    compress_adaptive; /* stop compressing streams whose data does not compress */
 	int    tcp_keepalive; /* use keepalive? */
 	int    tcp_keep_idle;
 	int    tcp_keep_intvl;
 	int    tcp_keep_probes;
 	int    buf_limit_per_conn; /* buffer limit per physical connection */
 	int    force_fault_tolerance; /* by default disabled */
+	int    coalesce_ms; /* time to hold small sends for coalescing */
 };
 
 /* rpp node types, leaf and router */
@@ -184,7 +184,7 @@ extern void  renew_credential(job *);
 extern char *lastname(char *shell);
 extern void  chk_array_doneness(job *parent);
 extern job  *create_subjob(job *parent, char *newjid, int *rc);
-extern char *cvt_range(struct ajtrkhd *t, int state);
+extern char *cvt_range(job *parent, int state);
 extern job  *find_arrayparent(char *subjobid);
 extern int   get_subjob_state(job *parent, int offset);
 extern char *mk_subjob_id(job *parent, int offset);
@@ -253,6 +253,7 @@ extern void  req_gsscontext(struct batch_request *preq);
 extern void  req_jobscript(struct batch_request *preq);
 extern void  req_rdytocommit(struct batch_request *preq);
 extern void  req_commit(struct batch_request *preq);
+extern void  req_submitjobs(struct batch_request *preq);
 extern void  req_deletejob(struct batch_request *preq);
 extern void  req_holdjob(struct batch_request *preq);
 extern void  req_messagejob(struct batch_request *preq);
@@ -296,6 +297,7 @@ extern int   set_chunk_sum(attribute  *pselectattr, attribute *pattr);
 extern int   update_resources_rel(job *, attribute *, enum batch_op);
 extern int   keepfiles_action(attribute *pattr, void *pobject, int actmode);
 extern int   removefiles_action(attribute *pattr, void *pobject, int actmode);
+extern void  svrcached(attribute *, pbs_list_head *, attribute_def *);
 
 
 /* Functions below exposed as they are now accessed by the Python hooks */
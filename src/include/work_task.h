@@ -77,6 +77,9 @@ struct work_task  {
 	pbs_list_link	 wt_linkall;	/* link to event type work list */
 	pbs_list_link	 wt_linkobj;	/* link to others of same object */
 	pbs_list_link	 wt_linkobj2;   /* link to another set of similarity */
+	pbs_list_link	 wt_linkevent;	/* link to event hash bucket */
+	int		 wt_heapidx;	/* index in timed task heap, -1 if none */
+	unsigned long	 wt_seq;	/* orders timed tasks with the same time */
 	long		 wt_event;	/* event id: time, pid, socket, ... */
 	char		*wt_event2;	/* if replies on the same handle, then additional distinction */
 	enum work_type	 wt_type;	/* type of event */
@@ -94,6 +97,8 @@ extern void dispatch_task(struct work_task *);
 extern void delete_task(struct work_task *);
 extern void delete_task_by_parm1(void *parm1, enum wtask_delete_option option);
 extern int  has_task_by_parm1(void *parm1);
+extern struct work_task *find_work_task(enum work_type, long event, void *parm1);
+extern void unlink_task_event(struct work_task *);
 extern time_t default_next_task(void);
 
 #ifdef	__cplusplus
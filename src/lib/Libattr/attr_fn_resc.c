@@ -449,6 +449,74 @@ free_resc(attribute *pattr)
 	CLEAR_HEAD(pattr->at_val.at_list);
 }
 
+/*
+ * Name index of the resource definition list searched by find_resc_def(),
+ * and the resource_def at each indexed position.
+ */
+static struct name_idx resc_def_idx;
+static resource_def **resc_def_pos = NULL;
+
+/**
+ * @brief
+ * 	reset_resc_def_idx - discard the resource definition index
+ *
+ *	Must be called whenever an entry is added to or removed from the
+ *	resource definition list; the index is rebuilt on the next lookup.
+ *
+ * @return	Void
+ *
+ */
+
+void
+reset_resc_def_idx(void)
+{
+	name_idx_free(&resc_def_idx);
+	free(resc_def_pos);
+	resc_def_pos = NULL;
+}
+
+/**
+ * @brief
+ * 	build_resc_def_idx - index the first 'limit' entries of a resource
+ *	definition list
+ *
+ * @param[in] rscdf - address of array of resource_def structs
+ * @param[in] limit - number of members in resource_def array
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory, no index
+ *
+ */
+
+static int
+build_resc_def_idx(resource_def *rscdf, int limit)
+{
+	char **names;
+	int i;
+
+	reset_resc_def_idx();
+	resc_def_pos = (resource_def **)malloc(limit * sizeof(resource_def *));
+	names = (char **)malloc(limit * sizeof(char *));
+	if ((resc_def_pos == NULL) || (names == NULL)) {
+		free(names);
+		reset_resc_def_idx();
+		return (-1);
+	}
+	for (i = 0; (i < limit) && (rscdf != NULL); i++) {
+		resc_def_pos[i] = rscdf;
+		names[i] = rscdf->rs_name;
+		rscdf = rscdf->rs_next;
+	}
+	if (name_idx_build(&resc_def_idx, resc_def_pos[0], names, i) == -1) {
+		free(names);
+		reset_resc_def_idx();
+		return (-1);
+	}
+	free(names);
+	return (0);
+}
+
 /**
  * @brief
  * 	find_resc_def - find the resource_def structure for a resource with
@@ -467,9 +535,20 @@ free_resc(attribute *pattr)
 resource_def *
 find_resc_def(resource_def *rscdf, char *name, int limit)
 {
+	int i;
+
 	if (rscdf == NULL || name == NULL)
 		return NULL;
 
+	if ((limit > 0) && ((resc_def_idx.ni_owner != rscdf) ||
+		(resc_def_idx.ni_count < limit)))
+		(void)build_resc_def_idx(rscdf, limit);
+	if ((resc_def_idx.ni_owner == rscdf) &&
+		(resc_def_idx.ni_count >= limit)) {
+		i = name_idx_find(&resc_def_idx, name, limit);
+		return ((i >= 0) ? resc_def_pos[i] : NULL);
+	}
+
 	while (limit--) {
 		if (strcasecmp(rscdf->rs_name, name) == 0)
 			return (rscdf);
@@ -57,6 +57,9 @@
  *
  * @par Included are:
  *	clear_attr()
+ *	name_idx_build()
+ *	name_idx_find()
+ *	name_idx_free()
  *	find_attr()
  *	free_null()
  *	attrlist_alloc()
@@ -109,12 +112,183 @@ clear_attr(attribute *pattr, struct attribute_def *pdef)
 		CLEAR_HEAD(pattr->at_val.at_list);
 }
 
+/*
+ * Indexes built by find_attr(), one per attribute definition array.
+ * The definition arrays are static tables, so an index never goes stale.
+ */
+#define ATTR_DEF_IDX_MAX 16
+static struct name_idx attr_def_idx[ATTR_DEF_IDX_MAX];
+
+/**
+ * @brief
+ * 	name_hash - case-insensitive hash of a name
+ *
+ * @param[in] name - name to hash
+ *
+ * @return	unsigned int
+ */
+
+static unsigned int
+name_hash(char *name)
+{
+	unsigned int h = 5381;
+
+	while (*name)
+		h = (h * 33) ^ (unsigned char)tolower((unsigned char)*name++);
+	return (h);
+}
+
+/**
+ * @brief
+ * 	name_idx_free - free the storage of a name index and mark it unused
+ *
+ * @param[in] pidx - pointer to the index
+ *
+ * @return	Void
+ *
+ */
+
+void
+name_idx_free(struct name_idx *pidx)
+{
+	free(pidx->ni_bucket);
+	free(pidx->ni_chain);
+	free(pidx->ni_name);
+	memset(pidx, 0, sizeof(struct name_idx));
+}
+
+/**
+ * @brief
+ * 	name_idx_build - (re)build a name index over 'count' names
+ *
+ *	The names are not copied, they must stay valid as long as the
+ *	index is used.  Each bucket chain is kept in position order so
+ *	the first of several equal names is the one found.
+ *
+ * @param[in] pidx - pointer to the index, any previous contents are freed
+ * @param[in] owner - definition table the names belong to
+ * @param[in] names - array of 'count' names
+ * @param[in] count - number of names
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory, the index is left unused
+ *
+ */
+
+int
+name_idx_build(struct name_idx *pidx, void *owner, char **names, int count)
+{
+	int i;
+	int b;
+	int nbucket = 16;
+
+	name_idx_free(pidx);
+	while (nbucket < 2 * count)
+		nbucket <<= 1;
+
+	pidx->ni_bucket = (int *)malloc(nbucket * sizeof(int));
+	pidx->ni_chain = (int *)malloc((count + 1) * sizeof(int));
+	pidx->ni_name = (char **)malloc((count + 1) * sizeof(char *));
+	if ((pidx->ni_bucket == NULL) || (pidx->ni_chain == NULL) ||
+		(pidx->ni_name == NULL)) {
+		name_idx_free(pidx);
+		return (-1);
+	}
+	for (b = 0; b < nbucket; b++)
+		pidx->ni_bucket[b] = -1;
+
+	/* insert backwards so each chain is in ascending position order */
+	for (i = count - 1; i >= 0; i--) {
+		pidx->ni_name[i] = names[i];
+		b = name_hash(names[i]) & (nbucket - 1);
+		pidx->ni_chain[i] = pidx->ni_bucket[b];
+		pidx->ni_bucket[b] = i;
+	}
+	pidx->ni_owner = owner;
+	pidx->ni_count = count;
+	pidx->ni_nbucket = nbucket;
+	return (0);
+}
+
+/**
+ * @brief
+ * 	name_idx_find - look up a name in a name index
+ *
+ * @param[in] pidx - pointer to the index
+ * @param[in] name - name to find, case is ignored
+ * @param[in] limit - only positions below limit are matched
+ *
+ * @return	int
+ * @retval	>=0	position of the first matching name
+ * @retval	-1	if didn't find matching name
+ *
+ */
+
+int
+name_idx_find(struct name_idx *pidx, char *name, int limit)
+{
+	int i;
+
+	i = pidx->ni_bucket[name_hash(name) & (pidx->ni_nbucket - 1)];
+	for (; (i >= 0) && (i < limit); i = pidx->ni_chain[i]) {
+		if (!strcasecmp(pidx->ni_name[i], name))
+			return (i);
+	}
+	return (-1);
+}
+
+/**
+ * @brief
+ * 	find_attr_idx - return the name index of an attribute definition
+ *	array, building it on first use
+ *
+ * @param[in] attr_def - ptr to attribute definitions
+ * @param[in] limit - number of definitions that must be indexed
+ *
+ * @return	struct name_idx *
+ * @retval	the index
+ * @retval	NULL	no index could be built, caller searches linearly
+ *
+ */
+
+static struct name_idx *
+find_attr_idx(struct attribute_def *attr_def, int limit)
+{
+	struct name_idx *pidx = NULL;
+	char **names;
+	int i;
+
+	for (i = 0; i < ATTR_DEF_IDX_MAX; i++) {
+		if (attr_def_idx[i].ni_owner == attr_def) {
+			if (attr_def_idx[i].ni_count >= limit)
+				return (&attr_def_idx[i]);
+			pidx = &attr_def_idx[i];
+			break;
+		}
+		if ((pidx == NULL) && (attr_def_idx[i].ni_owner == NULL))
+			pidx = &attr_def_idx[i];
+	}
+	if (pidx == NULL)
+		return NULL;
+
+	names = (char **)malloc(limit * sizeof(char *));
+	if (names == NULL)
+		return NULL;
+	for (i = 0; i < limit; i++)
+		names[i] = attr_def[i].at_name;
+	i = name_idx_build(pidx, attr_def, names, limit);
+	free(names);
+	return ((i == 0) ? pidx : NULL);
+}
+
 /**
  * @brief
  * 	find_attr - find attribute definition by name
  *
  *	Searches array of attribute definition strutures to find one
- *	whose name matches the requested name.
+ *	whose name matches the requested name.  A hash index is kept for
+ *	each definition array searched.
  *
  * @param[in] attr_def - ptr to attribute definitions
  * @param[in] name - attribute name to find
@@ -130,8 +304,11 @@ int
 find_attr(struct attribute_def *attr_def, char *name, int limit)
 {
 	int index;
+	struct name_idx *pidx;
 
 	if (attr_def) {
+		if ((limit > 0) && ((pidx = find_attr_idx(attr_def, limit)) != NULL))
+			return (name_idx_find(pidx, name, limit));
 		for (index = 0; index < limit; index++) {
 			if (!strcasecmp(attr_def->at_name, name))
 				return (index);
@@ -91,3 +91,71 @@ decode_DIS_QueueJob(int sock, struct batch_request *preq)
 
 	return (decode_DIS_svrattrl(sock, &preq->rq_ind.rq_queuejob.rq_attr));
 }
+
+/**
+ * @brief -
+ *	decode a Submit Jobs Batch Request
+ *
+ * @par	Functionality:
+ *		u int   number of jobs\n
+ *		cnt str shared script\n
+ *		then for each job:\n
+ *		string  destination\n
+ *		list of attributes (attropl)\n
+ *		cnt str script of the job, empty for the shared script
+ *
+ * @param[in] sock - socket descriptor
+ * @param[out] preq - pointer to batch_request structure
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+decode_DIS_SubmitJobs(int sock, struct batch_request *preq)
+{
+	struct rq_submitjobs *psj = &preq->rq_ind.rq_submitjobs;
+	struct rq_submitjob  *pjob;
+	size_t	amt;
+	int	ct;
+	int	i;
+	int	rc;
+
+	CLEAR_HEAD(psj->rq_jobs);
+	psj->rq_numjobs = 0;
+	psj->rq_scriptsz = 0;
+
+	ct = disrui(sock, &rc);
+	if (rc) return rc;
+
+	psj->rq_script = disrcs(sock, &psj->rq_scriptsz, &rc);
+	if (rc) return rc;
+
+	for (i = 0; i < ct; i++) {
+		pjob = (struct rq_submitjob *)calloc(1, sizeof(struct rq_submitjob));
+		if (pjob == NULL)
+			return DIS_NOMALLOC;
+		CLEAR_LINK(pjob->rq_link);
+		CLEAR_HEAD(pjob->rq_attr);
+		append_link(&psj->rq_jobs, &pjob->rq_link, pjob);
+		psj->rq_numjobs++;
+
+		rc = disrfst(sock, PBS_MAXDEST+1, pjob->rq_destin);
+		if (rc) return rc;
+
+		rc = decode_DIS_svrattrl(sock, &pjob->rq_attr);
+		if (rc) return rc;
+
+		pjob->rq_script = disrcs(sock, &amt, &rc);
+		if (rc) return rc;
+		if (amt == 0) {
+			/* use the shared script */
+			free(pjob->rq_script);
+			pjob->rq_script = NULL;
+		}
+		pjob->rq_scriptsz = amt;
+	}
+	return 0;
+}
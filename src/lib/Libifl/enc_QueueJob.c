@@ -91,3 +91,58 @@ encode_DIS_QueueJob(int sock, char *jobid, char *destin, struct attropl *aoplp)
 
 	return (encode_DIS_attropl(sock, aoplp));
 }
+
+/**
+ * @brief
+ *	-encode a Submit Jobs Batch Request
+ *
+ * @par	Functionality:
+ *		This request carries the attributes and scripts of several jobs,
+ *		which the server queues and commits together.
+ *
+ * @par Data items are:
+ *		u int	number of jobs\n
+ *		cnt str	shared script\n
+ *		then for each job:\n
+ *		string	destination\n
+ *		list of attribute, see encode_DIS_attropl()\n
+ *		cnt str	script of the job, empty for the shared script
+ *
+ * @param[in] sock - socket descriptor
+ * @param[in] jobs - list of jobs
+ * @param[in] script - text of the shared script, NULL for none
+ * @param[in] scripts - text of the script of each job in the order of
+ *			'jobs', an entry is NULL to use the shared script
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+encode_DIS_SubmitJobs(int sock, struct batch_job *jobs, char *script,
+	char **scripts)
+{
+	struct batch_job *pj;
+	unsigned int	  ct = 0;
+	int		  i;
+	int		  rc;
+
+	for (pj = jobs; pj; pj = pj->next)
+		ct++;
+	if (script == NULL)
+		script = "";
+
+	if ((rc = diswui(sock, ct) != 0) ||
+		(rc = diswst(sock, script) != 0))
+		return rc;
+
+	for (pj = jobs, i = 0; pj; pj = pj->next, i++) {
+		if ((rc = diswst(sock, pj->destination ? pj->destination : "") != 0) ||
+			(rc = encode_DIS_attropl(sock, pj->attribs)) ||
+			(rc = diswst(sock, scripts[i] ? scripts[i] : "") != 0))
+			return rc;
+	}
+	return 0;
+}
@@ -58,7 +58,6 @@
 
 
 static int PBSD_select_put(int, int, struct attropl *, struct attrl *, char *);
-static char **PBSD_select_get(int);
 
 /**
  * @brief
@@ -214,7 +213,7 @@ PBSD_select_put(int c, int type, struct attropl *attrib,
  * @retval	NULL			error
  *
  */
-static char **
+char **
 PBSD_select_get(int c)
 {
 	int   i;
@@ -44,11 +44,15 @@
 #include <pbs_config.h>   /* the master config generated by configure */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <strings.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "libpbs.h"
+#include "dis.h"
 #include "credential.h"
 #include "pbs_ecl.h"
 #include "pbs_client_thread.h"
@@ -243,3 +247,157 @@ error:
 	(void)pbs_client_thread_unlock_connection(c);
 	return NULL;
 }
+
+/**
+ * @brief
+ *	-read a job script file into memory
+ *
+ * @param[in] c - communication handle
+ * @param[in] path - job script file
+ *
+ * @return      string
+ * @retval      text of the script, to be freed by the caller   success
+ * @retval      NULL    error, pbs_errno is set
+ *
+ */
+static char *
+read_script(int c, char *path)
+{
+	struct stat	 sb;
+	char		*buf;
+	size_t		 len = 0;
+	ssize_t		 cc;
+	int		 fd;
+
+	if ((fd = open(path, O_RDONLY, 0)) == -1) {
+		pbs_errno = PBSE_BADSCRIPT;
+		if ((connection[c].ch_errtxt = strdup("cannot access script file")) == NULL)
+			pbs_errno = PBSE_SYSTEM;
+		return NULL;
+	}
+	if ((fstat(fd, &sb) == -1) ||
+		((buf = malloc((size_t)sb.st_size + 1)) == NULL)) {
+		pbs_errno = PBSE_SYSTEM;
+		close(fd);
+		return NULL;
+	}
+	while ((len < (size_t)sb.st_size) &&
+		((cc = read(fd, buf + len, (size_t)sb.st_size - len)) > 0))
+		len += cc;
+	close(fd);
+	buf[len] = '\0';
+	return buf;
+}
+
+/**
+ * @brief
+ *	-submit several jobs in one request
+ *
+ * @par
+ *	The server queues and commits all of the jobs in one transaction;
+ *	if one of them is rejected, none of them is created.
+ *
+ * @param[in] c - communication handle
+ * @param[in] jobs - list of jobs, each with its attributes, destination
+ *			and script file; a job without a script file gets
+ *			the shared script
+ * @param[in] script - shared job script file, NULL for none
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return      string list
+ * @retval      job ids in the order of 'jobs', to be freed by the caller
+ *		with a single free()   success
+ * @retval      NULL    error
+ *
+ */
+char **
+pbs_submit_batch(int c, struct batch_job *jobs, char *script, char *extend)
+{
+	struct batch_job	*pj;
+	struct attropl		*pal;
+	char			*text = NULL;
+	char			**texts = NULL;
+	char			**ret = NULL;
+	int			njobs = 0;
+	int			i;
+	int			rc;
+	int			sock;
+
+	for (pj = jobs; pj; pj = pj->next)
+		njobs++;
+	if (njobs == 0) {
+		pbs_errno = PBSE_IVALREQ;
+		return NULL;
+	}
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return NULL;
+
+	/* first verify the attributes, if verification is enabled */
+	for (pj = jobs; pj; pj = pj->next) {
+		if (pbs_verify_attributes(c, PBS_BATCH_QueueJob,
+			MGR_OBJ_JOB, MGR_CMD_NONE, pj->attribs))
+			return NULL;
+	}
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return NULL;
+
+	if ((texts = (char **)calloc(njobs, sizeof(char *))) == NULL) {
+		pbs_errno = PBSE_SYSTEM;
+		goto done;
+	}
+	if ((script != NULL) && (*script != '\0') &&
+		((text = read_script(c, script)) == NULL))
+		goto done;
+	for (pj = jobs, i = 0; pj; pj = pj->next, i++) {
+		if ((pj->script != NULL) && (*pj->script != '\0') &&
+			((texts[i] = read_script(c, pj->script)) == NULL))
+			goto done;
+		for (pal = pj->attribs; pal; pal = pal->next)
+			pal->op = SET;		/* force operator to SET */
+	}
+
+	sock = connection[c].ch_socket;
+
+	/* setup DIS support routines for following DIS calls */
+
+	DIS_tcp_setup(sock);
+
+	if ((rc = encode_DIS_ReqHdr(sock, PBS_BATCH_SubmitJobs, pbs_current_user)) ||
+		(rc = encode_DIS_SubmitJobs(sock, jobs, text, texts)) ||
+		(rc = encode_DIS_ReqExtend(sock, extend))) {
+		connection[c].ch_errtxt = strdup(dis_emsg[rc]);
+		if (connection[c].ch_errtxt == NULL)
+			pbs_errno = PBSE_SYSTEM;
+		else
+			pbs_errno = PBSE_PROTOCOL;
+		goto done;
+	}
+	if (DIS_tcp_wflush(sock)) {
+		pbs_errno = PBSE_PROTOCOL;
+		goto done;
+	}
+
+	/* the reply is the list of the new job ids */
+	ret = PBSD_select_get(c);
+
+done:
+	free(text);
+	if (texts != NULL) {
+		for (i = 0; i < njobs; i++)
+			free(texts[i]);
+		free(texts);
+	}
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0) {
+		free(ret);
+		return NULL;
+	}
+
+	return ret;
+}
@@ -121,6 +121,14 @@ struct pbs_config pbs_conf = {
 	NULL,					/* for router, default communication routers list */
 	0,					/* default comm logevent mask */
 	4,					/* default number of threads */
+	0,					/* small TPP sends are not held back for coalescing */
+	NULL,					/* default compression codec (zlib) */
+	0,					/* default compression threshold */
+	1,					/* adaptive compression enabled by default */
+	0,					/* synchronous logging by default */
+	0,					/* no log file job index by default */
+	PBS_ACCT_FORMAT_TEXT,			/* text accounting records by default */
+	0,					/* accounting records are written as they come */
 	NULL					/* mom short name override */
 #ifdef WIN32
 	,NULL					/* remote viewer launcher executable alongwith launch options */
@@ -481,6 +489,47 @@ pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_comm_log_events = uvalue;
 			}
+			else if (!strcmp(conf_name, PBS_CONF_COMM_COALESCE_MS)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_comm_coalesce_ms = uvalue;
+			}
+			else if (!strcmp(conf_name, PBS_CONF_COMPRESSION_CODEC)) {
+				if (pbs_conf.pbs_compression_codec)
+					free(pbs_conf.pbs_compression_codec);
+				pbs_conf.pbs_compression_codec = strdup(conf_value);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_COMPRESSION_THRESHOLD)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_compression_threshold = uvalue;
+			}
+			else if (!strcmp(conf_name, PBS_CONF_COMPRESSION_ADAPTIVE)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_compression_adaptive = ((uvalue > 0) ? 1 : 0);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_LOG_ASYNC)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_async = ((uvalue > 0) ? 1 : 0);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_LOG_INDEX)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_index = ((uvalue > 0) ? 1 : 0);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_ACCT_FORMAT)) {
+				if (!strcasecmp(conf_value, "text")) {
+					pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_TEXT;
+				} else if (!strcasecmp(conf_value, "json")) {
+					pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_JSON;
+				} else if (!strcasecmp(conf_value, "both")) {
+					pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_TEXT | PBS_ACCT_FORMAT_JSON;
+				} else {
+					fprintf(stderr, "pbsconf error: illegal value for %s\n", PBS_CONF_ACCT_FORMAT);
+					goto err;
+				}
+			}
+			else if (!strcmp(conf_name, PBS_CONF_ACCT_FLUSH)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_acct_flush = uvalue;
+			}
 			else if (!strcmp(conf_name, PBS_CONF_HOME)) {
 				free(pbs_conf.pbs_home_path);
 				pbs_conf.pbs_home_path = shorten_and_cleanup_path(conf_value);
@@ -753,6 +802,47 @@ pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_comm_log_events = uvalue;
 	}
+	if ((gvalue = getenv(PBS_CONF_COMM_COALESCE_MS)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_comm_coalesce_ms = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_COMPRESSION_CODEC)) != NULL) {
+		if (pbs_conf.pbs_compression_codec)
+			free(pbs_conf.pbs_compression_codec);
+		pbs_conf.pbs_compression_codec = strdup(gvalue);
+	}
+	if ((gvalue = getenv(PBS_CONF_COMPRESSION_THRESHOLD)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_compression_threshold = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_COMPRESSION_ADAPTIVE)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_compression_adaptive = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_LOG_ASYNC)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_async = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_LOG_INDEX)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_index = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_ACCT_FORMAT)) != NULL) {
+		if (!strcasecmp(gvalue, "text")) {
+			pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_TEXT;
+		} else if (!strcasecmp(gvalue, "json")) {
+			pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_JSON;
+		} else if (!strcasecmp(gvalue, "both")) {
+			pbs_conf.pbs_acct_format = PBS_ACCT_FORMAT_TEXT | PBS_ACCT_FORMAT_JSON;
+		} else {
+			fprintf(stderr, "pbsconf error: illegal value for %s\n", PBS_CONF_ACCT_FORMAT);
+			goto err;
+		}
+	}
+	if ((gvalue = getenv(PBS_CONF_ACCT_FLUSH)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_acct_flush = uvalue;
+	}
 	if ((gvalue = getenv(PBS_CONF_DATA_SERVICE_PORT)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_data_service_port =
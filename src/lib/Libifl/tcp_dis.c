@@ -76,6 +76,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "libpbs.h"
 #include "libsec.h"
@@ -88,6 +89,15 @@
 
 #define THE_BUF_SIZE 1024
 
+/*
+ * Buffers grow by doubling.  Up to TCP_BUF_HWM, a write buffer is grown
+ * rather than flushed and a read buffer that was filled by one read is
+ * grown for the next, so large messages move in large system calls.
+ * A buffer that grew beyond TCP_BUF_HWM for one oversized item is given
+ * back when the channel is next set up.
+ */
+#define TCP_BUF_HWM (64 * 1024)
+
 struct tcpdisbuf {
 	size_t	tdis_lead;
 	size_t	tdis_trail;
@@ -195,7 +205,7 @@ struct tcpdisbuf * tcp_get_writebuf(int fd)
  * 	-tcp_pack_buff - pack existing data into front of buffer
  *
  *	Moves "uncommited" data to front of buffer and adjusts pointers.
- *	Does a character by character move since data may over lap.
+ *	Uses memmove since data may over lap.
  * 
  * @param[in] tp - tcp data buffer
  *
@@ -206,23 +216,54 @@ struct tcpdisbuf * tcp_get_writebuf(int fd)
 static void
 tcp_pack_buff(struct tcpdisbuf *tp)
 {
-	size_t amt;
 	size_t start;
-	size_t i;
 
 	start = tp->tdis_trail;
 	if (start != 0) {
-		amt  = tp->tdis_eod - start;
-		for (i=0; i<amt; ++i) {
-			*(tp->tdis_thebuf + i) =
-				*(tp->tdis_thebuf + i + start);
-		}
+		if (tp->tdis_eod > start)
+			(void)memmove(tp->tdis_thebuf, tp->tdis_thebuf + start,
+				tp->tdis_eod - start);
 		tp->tdis_lead  -= start;
 		tp->tdis_trail -= start;
 		tp->tdis_eod   -= start;
 	}
 }
 
+/**
+ * @brief
+ * 	-tcp_grow_buff - double the size of a buffer until it holds at least
+ *	'need' bytes
+ *
+ * @param[in] tp - tcp data buffer
+ * @param[in] need - size needed
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	realloc failed, the buffer is unchanged
+ *
+ */
+
+static int
+tcp_grow_buff(struct tcpdisbuf *tp, size_t need)
+{
+	size_t	newsize;
+	char	*tmcp;
+
+	newsize = tp->tdis_bufsize;
+	while (newsize < need)
+		newsize *= 2;
+	if (newsize == tp->tdis_bufsize)
+		return 0;
+
+	/* no need to lock mutex here, this is per fd resize */
+	tmcp = (char *)realloc(tp->tdis_thebuf, sizeof(char) * newsize);
+	if (tmcp == NULL)
+		return -1;
+	tp->tdis_thebuf = tmcp;
+	tp->tdis_bufsize = newsize;
+	return 0;
+}
+
 /**
  * @brief
  * 	-tcp_read - read data from tcp stream to "fill" the buffer
@@ -244,8 +285,8 @@ tcp_read(int fd)
 	int	try_decrypt_buf = 0;
 	struct	pollfd pollfds[1];
 	int	timeout;
+	size_t	space;
 	struct	tcpdisbuf	*tp;
-	char   *tmcp;
 
 	tp = tcp_get_readbuf(fd);
 
@@ -280,19 +321,9 @@ tcp_read(int fd)
 	tcp_pack_buff(tp);
 
 	if ((tp->tdis_bufsize - tp->tdis_eod) < 20) {
-
-		/* no need to lock mutex here, this is per fd resize */
 		/* needing a larger buffer area for the data */
-
-		tp->tdis_bufsize += THE_BUF_SIZE;
-		tmcp = (char *)realloc(tp->tdis_thebuf,
-			sizeof(char)*tp->tdis_bufsize);
-		if (tmcp != NULL) {
-			tp->tdis_thebuf = tmcp;
-		} else {
-			/* realloc failed */
+		if (tcp_grow_buff(tp, tp->tdis_bufsize + 1) != 0)
 			return -1;
-		}
 	}
 
 	/*
@@ -318,14 +349,19 @@ tcp_read(int fd)
 	if ((i == 0 && try_decrypt_buf == 0) || (i < 0))
 		return i;
 
+	space = tp->tdis_bufsize - tp->tdis_eod;
 	while ((i = CS_read(fd, &tp->tdis_thebuf[tp->tdis_eod],
-		tp->tdis_bufsize - tp->tdis_eod)) == CS_IO_FAIL) {
+		space)) == CS_IO_FAIL) {
 
 		if (errno != EINTR)
 			break;
 	}
-	if (i > 0)
+	if (i > 0) {
 		tp->tdis_eod += i;
+		/* filled the buffer, more is likely waiting; read more next time */
+		if (((size_t)i == space) && (tp->tdis_bufsize < TCP_BUF_HWM))
+			(void)tcp_grow_buff(tp, tp->tdis_bufsize + 1);
+	}
 
 	return ((i == 0) ? -2 : i);
 }
@@ -446,6 +482,30 @@ DIS_tcp_clear(struct  tcpdisbuf *tp)
 	tp->tdis_eod   = 0;
 }
 
+/**
+ * @brief
+ * 	tcp_shrink_buff - return a buffer grown beyond TCP_BUF_HWM to that size
+ *
+ * @param[in] tp - pointer to tcpdisbuf struct, its contents are discarded
+ *
+ * @return	Void
+ *
+ */
+
+static void
+tcp_shrink_buff(struct  tcpdisbuf *tp)
+{
+	char	*tmcp;
+
+	if (tp->tdis_bufsize <= TCP_BUF_HWM)
+		return;
+	tmcp = (char *)realloc(tp->tdis_thebuf, TCP_BUF_HWM);
+	if (tmcp != NULL) {
+		tp->tdis_thebuf = tmcp;
+		tp->tdis_bufsize = TCP_BUF_HWM;
+	}
+}
+
 /**
  * @brief
  * 	-wrapper function for DIS_tcp_clear.
@@ -566,26 +626,21 @@ static int
 tcp_puts(int fd, const char *str, size_t ct)
 {
 	struct	tcpdisbuf	*tp;
-	char			*tmcp;
 
 	tp = tcp_get_writebuf(fd);
 	if ((tp->tdis_bufsize - tp->tdis_lead) < ct) {
-		/* not enough room, try to flush committed data */
-		if (DIS_tcp_wflush(fd) < 0)
-			return -1;		/* error */
-
-		if ((tp->tdis_bufsize - tp->tdis_lead) < ct) {	/* add room */
-
-			/* no need to lock mutex here, per fd resize */
-			size_t	ru = (ct + tp->tdis_lead) / THE_BUF_SIZE;
-
-			tp->tdis_bufsize = (ru + 1) * THE_BUF_SIZE;
-			tmcp = (char *)realloc(tp->tdis_thebuf,
-				sizeof(char)*tp->tdis_bufsize);
-			if (tmcp != NULL)
-				tp->tdis_thebuf = tmcp;
-			else
-				return -1;	/* realloc failed */
+		/* below the high-water mark, grow rather than flush */
+		if ((tp->tdis_lead + ct > TCP_BUF_HWM) ||
+			(tcp_grow_buff(tp, tp->tdis_lead + ct) != 0)) {
+
+			/* not enough room, try to flush committed data */
+			if (DIS_tcp_wflush(fd) < 0)
+				return -1;		/* error */
+
+			if ((tp->tdis_bufsize - tp->tdis_lead) < ct) {	/* add room */
+				if (tcp_grow_buff(tp, tp->tdis_lead + ct) != 0)
+					return -1;	/* realloc failed */
+			}
 		}
 	}
 	(void)memcpy(&tp->tdis_thebuf[tp->tdis_lead], str, ct);
@@ -728,6 +783,10 @@ DIS_tcp_setup(int fd)
 		tcp->writebuf.tdis_bufsize = THE_BUF_SIZE;
 	}
 
+	/* give back room taken by an earlier oversized message */
+	tcp_shrink_buff(&tcp->readbuf);
+	tcp_shrink_buff(&tcp->writebuf);
+
 	/* initialize read and write buffers */
 	DIS_tcp_clear(&tcp->readbuf);
 	DIS_tcp_clear(&tcp->writebuf);
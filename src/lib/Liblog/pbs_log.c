@@ -50,6 +50,10 @@
  *	log_close()
  *	log_add_debug_info()
  *	log_add_if_info()
+ *	log_async_start()
+ *	log_async_flush()
+ *	log_index_open()
+ *	log_index_write()
  */
 
 
@@ -69,7 +73,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <pthread.h>
+#ifndef WIN32
+#include <signal.h>
+#endif
 #include "log.h"
 #include "pbs_ifl.h"
 #include "pbs_internal.h"
@@ -110,6 +118,55 @@ static volatile int  log_opened = 0;
 static int	     syslogopen = 0;
 #endif	/* SYSLOG */
 
+/*
+ * Timestamp prefix of log records, formatted at most once per second.
+ * Guarded by log_mutex.
+ */
+static time_t	     log_stamp_time = -1;
+static int	     log_stamp_yday;
+static char	     log_stamp[64];
+
+#ifndef WIN32
+/*
+ * Asynchronous logging (PBS_LOG_ASYNC in pbs.conf, see log_async_start()).
+ * log_record() formats records into log_ring while holding log_mutex only
+ * for the copy, and a writer thread writes whatever has accumulated with
+ * one write() per batch.  log_ring_head and log_ring_tail only ever grow;
+ * the bytes in [tail, head) are pending.  While the writer is writing
+ * [tail, log_ring_busy_to) outside the mutex, log_ring_busy is set and
+ * nobody else may write to or close the log file.
+ */
+#define LOG_RING_SIZE	(1024 * 1024)	/* bytes buffered before callers write themselves */
+#define LOG_RING_KICK	(64 * 1024)	/* wake the writer early once this much is pending */
+#define LOG_RING_DELAY	1		/* max seconds a record waits in the ring */
+
+static int	     log_async = 0;	/* writer thread runs in this process */
+static char	    *log_ring = NULL;
+static size_t	     log_ring_head = 0;
+static size_t	     log_ring_tail = 0;
+static int	     log_ring_busy = 0;
+static pthread_cond_t log_ring_cond;	/* records pending */
+static pthread_cond_t log_ring_done;	/* writer finished a batch */
+#endif
+
+
+/*
+ * Job index of the open log file (PBS_LOG_INDEX in pbs.conf), see
+ * log_index_open().  In asynchronous mode index lines are collected in
+ * log_idx_buf and written by whoever writes the ring, and log_file_end
+ * is the size of the log file up to log_ring_tail, from which the
+ * offset of a record still in the ring is computed.
+ */
+static int	     log_idx_fd = -1;
+#ifndef WIN32
+#define LOG_IDX_BUFSZ	8192
+static char	     log_idx_buf[LOG_IDX_BUFSZ];
+static size_t	     log_idx_len = 0;
+static off_t	     log_file_end = 0;
+#endif
+
+void log_init(void);
+
 /*
  * the order of these names MUST match the defintions of
  * PBS_EVENTCLASS_* in log.h
@@ -287,6 +344,357 @@ log_mutex_unlock()
 	return 0;
 }
 
+/**
+ * @brief
+ *	Open the job index of log file 'path', "<path>.idx", for appending.
+ *	Each line of the index is "<offset> <id>", the byte offset in the
+ *	log file of a record about job or reservation <id>.  tracejob uses
+ *	it to read only the records of the jobs it is asked about.
+ *
+ * @par
+ *	An index is only started along with a new, empty log file, so that
+ *	it covers the whole file.  "tracejob -I" builds indexes for log
+ *	files that already exist.
+ *
+ * @param[in]	path - log file path
+ * @param[in]	fd   - descriptor of the open log file
+ *
+ * @return	int
+ * @retval	>=0	descriptor of the index file
+ * @retval	-1	no index is kept for this log file
+ */
+int
+log_index_open(const char *path, int fd)
+{
+#ifndef WIN32
+	char		idxpath[MAXPATHLEN+1];
+	struct stat	sb;
+	int		flags = O_WRONLY|O_APPEND;
+
+	if (pbs_conf.pbs_log_index == 0)
+		return (-1);
+	if (snprintf(idxpath, sizeof(idxpath), "%s%s", path,
+		LOG_INDEX_SUFFIX) >= sizeof(idxpath))
+		return (-1);
+	if (fstat(fd, &sb) == -1)
+		return (-1);
+	if (sb.st_size == 0)
+		flags |= O_CREAT|O_TRUNC;	/* drop any index of a former file */
+	else if (stat(idxpath, &sb) == -1)
+		return (-1);
+	return (open(idxpath, flags, 0644));
+#else
+	return (-1);
+#endif
+}
+
+/**
+ * @brief
+ *	Append the index line for a record about 'id' written at 'offset'
+ *	of the log file to index descriptor 'idxfd'.
+ *
+ * @param[in]	idxfd  - index descriptor from log_index_open()
+ * @param[in]	id     - job or reservation id the record is about
+ * @param[in]	offset - byte offset of the record in the log file
+ */
+void
+log_index_write(int idxfd, const char *id, long long offset)
+{
+	char	line[PBS_MAXSVRJOBID + 32];
+	int	len;
+
+	if ((idxfd < 0) || (offset < 0))
+		return;
+	len = snprintf(line, sizeof(line), "%lld %s\n", offset, id);
+	if ((len > 0) && (len < sizeof(line)))
+		(void)write(idxfd, line, len);
+}
+
+/**
+ * @brief
+ *	Should a record about object 'objname' of class 'objclass' go into
+ *	the job index?  Job and reservation records do, and so does any
+ *	record named after a job id, as tracejob matches on the name.
+ *
+ * @return	int
+ * @retval	1	index the record
+ * @retval	0	do not
+ */
+static int
+log_index_wanted(int objclass, const char *objname)
+{
+	if (log_idx_fd < 0)
+		return (0);
+	return ((objclass == PBS_EVENTCLASS_JOB) ||
+		(objclass == PBS_EVENTCLASS_RESV) ||
+		isdigit((int)(unsigned char)objname[0]));
+}
+
+#ifndef WIN32
+/**
+ * @brief
+ *	Write the ring bytes [from, to) to file descriptor 'fd', in at most
+ *	two write() calls when the range wraps around the end of the ring.
+ *
+ * @param[in]	fd   - log file descriptor
+ * @param[in]	from - ring position of the first byte
+ * @param[in]	to   - ring position past the last byte
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	write error, errno is set
+ *
+ * @par MT-safe: No, only safe with log_ring_busy set or log_mutex held.
+ */
+static int
+log_ring_write(int fd, size_t from, size_t to)
+{
+	size_t	off;
+	size_t	len;
+	ssize_t	n;
+
+	while (from < to) {
+		off = from % LOG_RING_SIZE;
+		len = to - from;
+		if (len > LOG_RING_SIZE - off)
+			len = LOG_RING_SIZE - off;
+		n = write(fd, log_ring + off, len);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		from += n;
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ *	Write out all records pending in the ring on the caller's thread,
+ *	after waiting for the writer thread to finish the batch it holds.
+ *	Called before the log file is written synchronously, switched or
+ *	closed so that records stay in order.
+ *
+ * @par MT-safe: Yes, with log_mutex held exactly once at the pthread level.
+ */
+static void
+log_ring_drain(void)
+{
+	FILE	*cons;
+	int	rc;
+
+	if (!log_async)
+		return;
+	while (log_ring_busy)
+		(void)pthread_cond_wait(&log_ring_done, &log_mutex);
+	if (log_ring_head == log_ring_tail)
+		return;
+	if ((log_opened > 0) && (logfile != NULL) &&
+		(log_ring_write(fileno(logfile), log_ring_tail, log_ring_head) == 0)) {
+		log_file_end += log_ring_head - log_ring_tail;
+		if ((log_idx_fd >= 0) && (log_idx_len > 0))
+			(void)write(log_idx_fd, log_idx_buf, log_idx_len);
+	} else if ((log_opened > 0) && (logfile != NULL)) {
+		rc = errno;
+		cons = logfile;
+		logfile = fopen("/dev/console", "w");
+		if (logfile != NULL) {
+			log_async = 0;	/* straight to the console */
+			log_err(rc, "log_ring_drain", "PBS cannot write to its log");
+			log_async = 1;
+			fclose(logfile);
+		}
+		logfile = cons;
+	}
+	log_ring_tail = log_ring_head;
+	log_idx_len = 0;
+}
+
+/**
+ * @brief
+ *	Body of the log writer thread.  Waits up to LOG_RING_DELAY seconds
+ *	or until LOG_RING_KICK bytes are pending, then writes everything
+ *	pending with log_mutex released.
+ *
+ * @param[in]	arg - unused
+ *
+ * @return	void * - never returns
+ */
+static void *
+log_writer(void *arg)
+{
+	sigset_t	allsigs;
+	struct timespec	ts;
+	size_t		from;
+	size_t		to;
+	int		fd;
+	int		idxfd;
+	static char	idxbuf[LOG_IDX_BUFSZ];
+	size_t		idxlen;
+
+	/* signals are for the daemon's main thread */
+	sigfillset(&allsigs);
+	(void)pthread_sigmask(SIG_BLOCK, &allsigs, NULL);
+
+	for (;;) {
+		if (log_mutex_lock() != 0) {
+			sleep(LOG_RING_DELAY);
+			continue;
+		}
+		if (log_ring_head - log_ring_tail < LOG_RING_KICK) {
+			ts.tv_sec = time(NULL) + LOG_RING_DELAY;
+			ts.tv_nsec = 0;
+			(void)pthread_cond_timedwait(&log_ring_cond, &log_mutex, &ts);
+		}
+		from = log_ring_tail;
+		to = log_ring_head;
+		if ((from == to) || (log_opened < 1) || (logfile == NULL)) {
+			log_ring_tail = to;
+			log_idx_len = 0;
+			log_mutex_unlock();
+			continue;
+		}
+		fd = fileno(logfile);
+		/* index lines of records past 'to' point beyond the end of the log for now */
+		idxfd = log_idx_fd;
+		idxlen = log_idx_len;
+		if (idxlen > 0)
+			memcpy(idxbuf, log_idx_buf, idxlen);
+		log_idx_len = 0;
+		log_ring_busy = 1;
+		log_mutex_unlock();
+
+		(void)log_ring_write(fd, from, to);
+		if ((idxfd >= 0) && (idxlen > 0))
+			(void)write(idxfd, idxbuf, idxlen);
+
+		if (log_mutex_lock() == 0) {
+			log_file_end += to - from;
+			log_ring_tail = to;
+			log_ring_busy = 0;
+			(void)pthread_cond_broadcast(&log_ring_done);
+			log_mutex_unlock();
+		}
+	}
+	return (NULL);
+}
+
+/**
+ * @brief
+ *	Fatal signal handler installed by log_async_start().  Writes out the
+ *	records still pending in the ring without taking any lock, so the
+ *	last lines before a crash are not lost, then re-raises the signal
+ *	with its default action.
+ *
+ * @param[in]	sig - the fatal signal
+ */
+static void
+log_async_crash(int sig)
+{
+	if (log_async && (log_opened > 0) && (logfile != NULL)) {
+		(void)log_ring_write(fileno(logfile), log_ring_tail, log_ring_head);
+		if ((log_idx_fd >= 0) && (log_idx_len > 0))
+			(void)write(log_idx_fd, log_idx_buf, log_idx_len);
+	}
+	(void)signal(sig, SIG_DFL);
+	(void)raise(sig);
+}
+#endif	/* WIN32 */
+
+/**
+ * @brief
+ *	Write out any log records buffered by asynchronous logging.
+ *	Registered with atexit() by log_async_start().
+ *
+ * @par MT-safe: Yes
+ */
+void
+log_async_flush(void)
+{
+#ifndef WIN32
+	if (!log_async)
+		return;
+	if (log_mutex_lock() != 0)
+		return;
+	log_ring_drain();
+	log_mutex_unlock();
+#endif
+}
+
+/**
+ * @brief
+ *	Switch the calling process to asynchronous logging if PBS_LOG_ASYNC
+ *	is set in pbs.conf.  Meant to be called by a daemon once it has
+ *	detached and opened its log; forked children go back to
+ *	synchronous logging.
+ *
+ * @return	int
+ * @retval	0	asynchronous logging enabled, or not requested
+ * @retval	-1	could not be enabled, logging stays synchronous
+ *
+ * @par MT-safe: No
+ */
+int
+log_async_start(void)
+{
+#ifndef WIN32
+	static int	 registered = 0;
+	static int	 fatal_sigs[] = { SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGILL };
+	struct sigaction act;
+	struct sigaction oact;
+	pthread_attr_t	 attr;
+	pthread_t	 tid;
+	size_t		 i;
+
+	if ((pbs_conf.pbs_log_async == 0) || log_async)
+		return (0);
+	if (log_opened < 1)
+		return (-1);
+
+	pthread_once(&log_once_ctl, log_init);
+	if (log_ring == NULL) {
+		if ((log_ring = malloc(LOG_RING_SIZE)) == NULL)
+			return (-1);
+		if ((pthread_cond_init(&log_ring_cond, NULL) != 0) ||
+			(pthread_cond_init(&log_ring_done, NULL) != 0)) {
+			free(log_ring);
+			log_ring = NULL;
+			return (-1);
+		}
+	}
+	log_ring_head = log_ring_tail = 0;
+	log_ring_busy = 0;
+	log_idx_len = 0;
+	log_file_end = lseek(fileno(logfile), 0, SEEK_END);
+
+	if (pthread_attr_init(&attr) != 0)
+		return (-1);
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&tid, &attr, log_writer, NULL) != 0) {
+		pthread_attr_destroy(&attr);
+		return (-1);
+	}
+	pthread_attr_destroy(&attr);
+	log_async = 1;
+
+	if (!registered) {
+		(void)atexit(log_async_flush);
+		/* only take over fatal signals the daemon does not handle itself */
+		sigemptyset(&act.sa_mask);
+		act.sa_flags = 0;
+		act.sa_handler = log_async_crash;
+		for (i = 0; i < sizeof(fatal_sigs) / sizeof(fatal_sigs[0]); i++) {
+			if ((sigaction(fatal_sigs[i], NULL, &oact) == 0) &&
+				(oact.sa_handler == SIG_DFL))
+				(void)sigaction(fatal_sigs[i], &act, NULL);
+		}
+		registered = 1;
+	}
+#endif
+	return (0);
+}
+
 #ifndef WIN32
 
 /**
@@ -298,6 +706,8 @@ void
 log_atfork_prepare()
 {
 	log_mutex_lock();
+	/* the child has no writer thread, hand it an empty ring */
+	log_ring_drain();
 }
 
 /**
@@ -319,6 +729,7 @@ log_atfork_parent()
 void
 log_atfork_child()
 {
+	log_async = 0;	/* the child logs synchronously */
 	log_mutex_unlock();
 }
 #endif
@@ -577,6 +988,10 @@ log_open_main(char *filename, char *directory, int silent)
 		(void)setvbuf(logfile, NULL, _IOLBF, 0);	/* set line buffering */
 #endif
 		log_opened = 1;			/* note that file is open */
+		log_idx_fd = log_index_open(filename, fds);
+#ifndef WIN32
+		log_file_end = lseek(fds, 0, SEEK_END);
+#endif
 
 		if (!silent) {
 			log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, "Log", "Log opened");
@@ -839,6 +1254,11 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	int    rc = 0;
 	FILE  *savlog;
 	static char slogbuf[LOG_BUF_SIZE];
+#ifndef WIN32
+	static char recbuf[2 * LOG_BUF_SIZE];
+	size_t	    len;
+	size_t	    off;
+#endif
 
 
 #if SYSLOG
@@ -860,18 +1280,26 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 
 	now = time(NULL);	/* get time for message */
 
-#ifdef WIN32
-	ptm = localtime(&now);
-#else
-	ptm = localtime_r(&now, &ltm);
-#endif
-
 	/* lock the log mutex */
 	if (log_mutex_lock() != 0)
 		return;
 
+	if (now != log_stamp_time) {
+#ifdef WIN32
+		ptm = localtime(&now);
+#else
+		ptm = localtime_r(&now, &ltm);
+#endif
+		snprintf(log_stamp, sizeof(log_stamp),
+			"%02d/%02d/%04d %02d:%02d:%02d",
+			ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
+			ptm->tm_hour, ptm->tm_min, ptm->tm_sec);
+		log_stamp_yday = ptm->tm_yday;
+		log_stamp_time = now;
+	}
+
 	/* Do we need to switch the log? */
-	if (log_auto_switch && (ptm->tm_yday != log_open_day)) {
+	if (log_auto_switch && (log_stamp_yday != log_open_day)) {
 		log_close(1);
 		log_open(NULL, log_directory);
 	}
@@ -887,11 +1315,52 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 		return;
 	}
 
+#ifndef WIN32
+	if (log_async && (pbs_conf.locallog != 0 || pbs_conf.syslogfac == 0)) {
+		len = snprintf(recbuf, sizeof(recbuf), "%s;%04x;%s;%s;%s;%s\n",
+			log_stamp,
+			eventtype & ~PBSEVENT_FORCE,
+			msg_daemonname,
+			class_names[objclass],
+			objname,
+			text);
+		if (len < sizeof(recbuf)) {
+			if (LOG_RING_SIZE - (log_ring_head - log_ring_tail) < len)
+				log_ring_drain();	/* ring full, write it ourselves */
+			if (log_index_wanted(objclass, objname)) {
+				if (log_idx_len + PBS_MAXSVRJOBID + 32 > LOG_IDX_BUFSZ) {
+					(void)write(log_idx_fd, log_idx_buf, log_idx_len);
+					log_idx_len = 0;
+				}
+				log_idx_len += snprintf(log_idx_buf + log_idx_len,
+					LOG_IDX_BUFSZ - log_idx_len, "%lld %.*s\n",
+					(long long)(log_file_end +
+					(log_ring_head - log_ring_tail)),
+					PBS_MAXSVRJOBID, objname);
+			}
+			off = log_ring_head % LOG_RING_SIZE;
+			if (len > LOG_RING_SIZE - off) {
+				memcpy(log_ring + off, recbuf, LOG_RING_SIZE - off);
+				memcpy(log_ring, recbuf + (LOG_RING_SIZE - off),
+					len - (LOG_RING_SIZE - off));
+			} else {
+				memcpy(log_ring + off, recbuf, len);
+			}
+			log_ring_head += len;
+			if (log_ring_head - log_ring_tail >= LOG_RING_KICK)
+				(void)pthread_cond_signal(&log_ring_cond);
+			log_mutex_unlock();
+			return;
+		}
+		/* too long for the ring, write it synchronously in order */
+		log_ring_drain();
+	}
+#endif
+
 	if (pbs_conf.locallog != 0 || pbs_conf.syslogfac == 0) {
 		rc = fprintf(logfile,
-			"%02d/%02d/%04d %02d:%02d:%02d;%04x;%s;%s;%s;%s\n",
-			ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
-			ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
+			"%s;%04x;%s;%s;%s;%s\n",
+			log_stamp,
 			eventtype & ~PBSEVENT_FORCE,
 			msg_daemonname,
 			class_names[objclass],
@@ -899,6 +1368,9 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 			text);
 
 		(void)fflush(logfile);
+		if ((rc > 0) && log_index_wanted(objclass, objname))
+			log_index_write(log_idx_fd, objname,
+				(long long)lseek(fileno(logfile), 0, SEEK_CUR) - rc);
 		if (rc < 0) {
 			rc = errno;
 			clearerr(logfile);
@@ -947,7 +1419,17 @@ log_close(int msg)
 			log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,
 				LOG_INFO, "Log", "Log closed");
 		}
+#ifndef WIN32
+		if (log_async && (log_mutex_lock() == 0)) {
+			log_ring_drain();
+			log_mutex_unlock();
+		}
+#endif
 		(void)fclose(logfile);
+		if (log_idx_fd >= 0) {
+			(void)close(log_idx_fd);
+			log_idx_fd = -1;
+		}
 		log_opened = 0;
 	}
 #if SYSLOG
@@ -3527,6 +3527,7 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname)
 	job *pjob;
 	int tmp_rc = -1;
 	int t;
+	int packed;
 
 	if (pjob_o != NULL) {
 		pjob = pjob_o;
@@ -3588,11 +3589,14 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname)
 	 * OK, At this point we need to start populating the job class.
 	 */
 	snprintf((char *)hook_debug.objname, HOOK_BUF_SIZE-1, "%s(%s)", SERVER_JOB_OBJECT, pjob->ji_qs.ji_jobid);
+	packed = job_hist_unpack(pjob);
 	tmp_rc = pbs_python_populate_attributes_to_python_class(py_job,
 		py_job_attr_types,
 		pjob->ji_wattr,
 		job_attr_def,
 		JOB_ATR_LAST);
+	if (packed)
+		job_hist_pack(pjob);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
@@ -8459,8 +8463,121 @@ getval_exit:
 	return (strval);
 }
 
+#ifndef NAS /* localmod 014 */
+/* job lists a pbs_iter over jobs can follow, kept in data_index */
+#define ITER_JOBLIST_ALL	0	/* svr_alljobs */
+#define ITER_JOBLIST_QUEUE	1	/* the queue's qu_jobs */
+#define ITER_JOBLIST_STATE	2	/* svr_jobs_by_state[] */
+#define ITER_JOBLIST_OWNER	3	/* svr_jobs_by_owner() */
+
+/**
+ * @brief
+ *	Return the job after pjob on the job list a pbs_iter follows.
+ *
+ * @param[in]	pjob - current job
+ * @param[in]	list - ITER_JOBLIST_* list followed
+ *
+ * @return	job *
+ * @retval	next job on the list
+ * @retval	NULL	end of the list
+ *
+ */
+static job *
+iter_job_next_link(job *pjob, int list)
+{
+	switch (list) {
+		case ITER_JOBLIST_QUEUE:
+			return ((job *)GET_NEXT(pjob->ji_jobque));
+		case ITER_JOBLIST_STATE:
+			return ((job *)GET_NEXT(pjob->ji_statejobs));
+		case ITER_JOBLIST_OWNER:
+			return ((job *)GET_NEXT(pjob->ji_ownerjobs));
+		default:
+			return ((job *)GET_NEXT(pjob->ji_alljobs));
+	}
+}
+
+/**
+ * @brief
+ *	Skip over the jobs a pbs_iter has been told to leave out, so that no
+ *	Python object is ever built for them.
+ *
+ * @param[in]	pjob - first candidate
+ * @param[in]	list - ITER_JOBLIST_* list followed
+ * @param[in]	user - wanted owner user name, NULL or "" for any
+ * @param[in]	state - wanted job state, -1 for any
+ *
+ * @return	job *
+ * @retval	first job from pjob on that is wanted
+ * @retval	NULL	none left
+ *
+ */
+static job *
+iter_next_job(job *pjob, int list, char *user, int state)
+{
+	char	*owner;
+	size_t	 len;
+
+	for (; pjob != NULL; pjob = iter_job_next_link(pjob, list)) {
+		if ((state != -1) && (pjob->ji_qs.ji_state != state))
+			continue;
+		if ((user != NULL) && (user[0] != '\0') && (list != ITER_JOBLIST_OWNER)) {
+			if ((pjob->ji_wattr[(int)JOB_ATR_job_owner].at_flags & ATR_VFLAG_SET) == 0)
+				continue;
+			owner = pjob->ji_wattr[(int)JOB_ATR_job_owner].at_val.at_str;
+			len = strcspn(owner, "@");
+			if ((strlen(user) != len) || (strncmp(user, owner, len) != 0))
+				continue;
+		}
+		break;
+	}
+	return (pjob);
+}
+
+/**
+ * @brief
+ *	Find the first job a pbs_iter over jobs returns, choosing the
+ *	shortest job list that holds all the wanted jobs: the queue's jobs
+ *	if a queue is given, else the owner's jobs if a user is given, else
+ *	the jobs in the wanted state, else all jobs.
+ *
+ * @param[in]	pque - queue, NULL for all queues
+ * @param[in]	user - wanted owner user name, NULL or "" for any
+ * @param[in]	state - wanted job state, -1 for any
+ * @param[out]	list - ITER_JOBLIST_* list to follow
+ *
+ * @return	job *
+ * @retval	first wanted job
+ * @retval	NULL	none
+ *
+ */
+static job *
+iter_first_job(pbs_queue *pque, char *user, int state, int *list)
+{
+	pbs_list_head	*phead;
+
+	if (pque != NULL) {
+		*list = ITER_JOBLIST_QUEUE;
+		phead = &pque->qu_jobs;
+	} else if ((user != NULL) && (user[0] != '\0')) {
+		*list = ITER_JOBLIST_OWNER;
+		if ((phead = svr_jobs_by_owner(user, NULL)) == NULL)
+			return NULL;
+	} else if (state != -1) {
+		*list = ITER_JOBLIST_STATE;
+		if ((state < 0) || (state >= PBS_NUMJOBSTATE))
+			return NULL;
+		phead = &svr_jobs_by_state[state];
+	} else {
+		*list = ITER_JOBLIST_ALL;
+		phead = &svr_alljobs;
+	}
+	return (iter_next_job((job *)GET_NEXT(*phead), *list, user, state));
+}
+#endif /* localmod 014 */
+
 const char pbsv1mod_meth_iter_nextfunc_doc[] =
-"iter_nextfunc(meth_mode, obj_name, filter1, filter2)\n\
+"iter_nextfunc(meth_mode, obj_name, filter1, filter2[, filter_user, filter_state])\n\
 \n\
    meth_mode:	can be 1 if called from __init__() or 0 if from next()\n\
 		method of a pbs_iter type.\n\
@@ -8473,6 +8590,8 @@ const char pbsv1mod_meth_iter_nextfunc_doc[] =
 		being referenced. For example, this can be set to\n\
 		some <queue_name>, to have the iterator represents\n\
 		a list of jobs on <queue_name>@<server_name>\n\
+   filter_user:	for \"jobs\", only those owned by this user (optional).\n\
+   filter_state: for \"jobs\", only those in this state (optional).\n\
 \n\
    Returns the next PBS object in Python form to evaluate within a looping\n\
    construct. The idea is on a iterator instantiation, the following gets\n\
@@ -8497,7 +8616,7 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 		NULL};
 #else
 	static char *kwlist[] = {"iter_obj", "meth_mode", "obj_name", "filter1", "filter2",
-		NULL};
+		"filter_user", "filter_state", NULL};
 #endif /* localmod 014 */
 	int  meth_mode;
 	char *obj_name = NULL;
@@ -8506,6 +8625,9 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 #ifdef NAS /* localmod 014 */
 	int  ignore_fin;
 	char *filter_user = NULL;
+#else
+	char *filter_user = NULL;
+	int  filter_state = -1;
 #endif /* localmod 014 */
 	pbs_iter_item	*iter_entry = NULL;
 	pbs_queue	*pque = NULL;
@@ -8527,13 +8649,15 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 		)) {
 #else
 	if (!PyArg_ParseTupleAndKeywords(args, kwds,
-		"Oisss:iter_nextfunc",
+		"Oisss|si:iter_nextfunc",
 		kwlist,
 		&py_self,
 		&meth_mode,
 		&obj_name,
 		&filter1,
-		&filter2
+		&filter2,
+		&filter_user,
+		&filter_state
 		)) {
 #endif /* localmod 014 */
 		return NULL;
@@ -8602,10 +8726,22 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 							log_buffer);
 						return NULL;
 					}
+#ifdef NAS /* localmod 014 */
 					iter_entry->data = (job *)GET_NEXT(pque->qu_jobs);
+#else
+					iter_entry->data = iter_first_job(pque,
+						filter_user, filter_state,
+						&iter_entry->data_index);
+#endif /* localmod 014 */
 
 				} else { /* get jobs from server */
+#ifdef NAS /* localmod 014 */
 					iter_entry->data = (job *)GET_NEXT(svr_alljobs);
+#else
+					iter_entry->data = iter_first_job(NULL,
+						filter_user, filter_state,
+						&iter_entry->data_index);
+#endif /* localmod 014 */
 
 #ifdef NAS /* localmod 014 */
 					/* skip jobs according to filters requested for the iterator */
@@ -8690,14 +8826,17 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 				py_object = _pps_helper_get_job(\
 					(job *)iter_entry->data, NULL, NULL);
 
-
-#ifdef NAS /* localmod 014 */
+#ifndef NAS /* localmod 014 */
+				/* follow the list chosen by iter_first_job() */
+				iter_entry->data = iter_next_job(
+					iter_job_next_link((job *)iter_entry->data,
+					iter_entry->data_index),
+					iter_entry->data_index,
+					filter_user, filter_state);
+#else
 				if (!ignore_fin &&
 					(filter_user == NULL || filter_user[0] == '\0') &&
 					(filter2 != NULL) && (filter2[0] != '\0')) {
-#else
-				if ((filter2 != NULL) && (filter2[0] != '\0')) {
-#endif /* localmod 014 */
 
 					/* list of jobs filtered by queue   */
 					/* 'filter2', as setup in meth_mode */
@@ -8709,7 +8848,6 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 				} else {
 					iter_entry->data = (job *)GET_NEXT(\
 					((job *)iter_entry->data)->ji_alljobs);
-#ifdef NAS /* localmod 014 */
 					/* skip jobs according to filters requested for the iterator */
 					job *njob = (job *) iter_entry->data;
 					while (njob != NULL &&
@@ -8720,8 +8858,8 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 					}
 
 					iter_entry->data = njob;
-#endif /* localmod 014 */
 				}
+#endif /* localmod 014 */
 			} else if (strcmp(obj_name, ITER_VNODES) == 0) {
 
 				py_object = _pps_helper_get_vnode(\
@@ -161,6 +161,18 @@ typedef struct {
 					       * acks for this stream
 					       */
 } ack_info_t;
+
+/*
+ * Acks that fall due together are sent out as a single packet, holding one
+ * length prefixed ack header after the other. This is the same byte stream
+ * as that of separate ack packets, so the receiving side is not affected.
+ */
+#define TPP_ACK_BATCH_MAX	65536	/* send a batch once it grows this big */
+typedef struct {
+	char *buf;	/* the ack headers, with their length prefixes */
+	int len;	/* length of data in buf */
+	int size;	/* allocated size of buf */
+} ack_batch_t;
 tpp_que_t global_ack_queue;           /* global ack queue for all streams */
 
 /*
@@ -219,6 +231,9 @@ typedef struct {
 
 	short used_locally;      /* Whether this stream was accessed locally by the APP, APP thread only */
 
+	short cmpr_poor;         /* APP thread only, consecutive sends that compressed poorly */
+	short cmpr_skip;         /* APP thread only, number of sends to go without compressing */
+
 	unsigned int send_seq_no; /* APP thread only, sequence number of the next packet to be sent */
 	unsigned int seq_no_expected; /* IO thread only, sequence number of the next packet expected */
 
@@ -268,6 +283,13 @@ unsigned int high_sd = UNINITIALIZED_INT; /* the highest stream sd used */
 tpp_que_t freed_sd_queue;            /* last freed stream sd */
 int freed_queue_count = 0;
 
+/*
+ * cache of freed stream structures, so that stream churn does not go to
+ * malloc every time. Protected by strmarray_lock like the array itself.
+ */
+#define TPP_STRM_POOL_MAX 1024
+static tpp_pool_t strm_pool;
+
 /* AVL tree of streams - so that we can search faster inside it */
 AVL_IX_DESC *AVL_streams = NULL;
 
@@ -330,7 +352,8 @@ static int send_app_strm_close(stream_t *strm, int cmd, int error);
 static int shelve_pkt(tpp_packet_t *pkt, tpp_packet_t *data_pkt, time_t retry_time);
 static int shelve_mcast_pkt(tpp_mcast_pkt_hdr_t *mcast_hdr, int tfd, int seq, tpp_packet_t *pkt);
 static int queue_ack(stream_t *strm, unsigned char type, unsigned int seq_no_recvd);
-static int send_ack_packet(ack_info_t *ack);
+static int add_ack_to_batch(ack_batch_t *batch, ack_info_t *ack);
+static void send_ack_batch(ack_batch_t *batch);
 static int send_retry_packet(tpp_packet_t *pkt);
 static int unshelve_pkt(stream_t *strm, int seq_no_acked);
 static void *add_part_packet(stream_t *strm, void *data, int sz);
@@ -1032,29 +1055,55 @@ tpp_send(int sd, void *data, int len)
 	int send_len;
 	tpp_packet_t *pkt = NULL;
 	void *outbuf;
+	stream_t *strm;
 
-	if (!get_strm(sd)) {
+	if ((strm = get_strm(sd)) == NULL) {
 		TPP_DBPRT(("Bad sd %d", sd));
 		return -1;
 	}
 
 	TPP_DBPRT(("Sending: sd=%u, len=%d", sd, len));
 
-	if (tpp_conf->compress == 1 && len > TPP_SEND_SIZE) {
-		outbuf = tpp_deflate(data, len, &cmprsd_len);
+	if (tpp_conf->compress != TPP_COMPR_NONE && len > tpp_conf->compress_min && strm->cmpr_skip == 0) {
+		outbuf = tpp_compress(tpp_conf->compress, data, len, &cmprsd_len);
 		if (outbuf == NULL) {
-			tpp_log_func(LOG_CRIT, __func__, "tpp deflate failed");
+			tpp_log_func(LOG_CRIT, __func__, "tpp compress failed");
 			return -1;
 		}
-		pkt = tpp_cr_pkt(outbuf, cmprsd_len, 0);
-		if (pkt == NULL) {
-			free(outbuf);
-			return -1;
+
+		/*
+		 * If the data saved less than TPP_CMPR_POOR_PCT percent a few times
+		 * in a row, it is likely already compressed or random, so stop
+		 * spending cpu on compressing this stream for a while
+		 */
+		if (tpp_conf->compress_adaptive) {
+			if (cmprsd_len > (unsigned int) len - ((unsigned int) len / 100) * TPP_CMPR_POOR_PCT) {
+				if (++strm->cmpr_poor >= TPP_CMPR_POOR_MAX) {
+					strm->cmpr_poor = 0;
+					strm->cmpr_skip = TPP_CMPR_SKIP;
+				}
+			} else
+				strm->cmpr_poor = 0;
 		}
 
-		p = pkt->data;
-		to_send = cmprsd_len;
+		/* a packet is known to be compressed by its length, so it must be smaller */
+		if (cmprsd_len >= (unsigned int) len) {
+			free(outbuf);
+			p = data;
+			cmprsd_len = len;
+			to_send = len;
+		} else {
+			pkt = tpp_cr_pkt(outbuf, cmprsd_len, 0);
+			if (pkt == NULL) {
+				free(outbuf);
+				return -1;
+			}
+			p = pkt->data;
+			to_send = cmprsd_len;
+		}
 	} else {
+		if (strm->cmpr_skip > 0 && len > tpp_conf->compress_min)
+			strm->cmpr_skip--;
 		p = data;
 		cmprsd_len = len;
 		to_send = len;
@@ -1294,6 +1343,55 @@ tpp_recv(int sd, void *data, int len)
 	return trnsfr_bytes;
 }
 
+/**
+ * @brief
+ *	Get a zeroed stream structure, from the stream pool if possible
+ *
+ * @return	The stream structure
+ * @retval	NULL - Out of memory
+ *
+ * @par MT-safe: No (caller must hold strmarray_lock)
+ *
+ */
+static stream_t *
+strm_pool_get(void)
+{
+	stream_t *strm;
+
+	strm_pool.allocs++;
+	if ((strm = strm_pool.free_list) != NULL) {
+		strm_pool.free_list = *(void **) strm;
+		strm_pool.count--;
+		strm_pool.hits++;
+		memset(strm, 0, sizeof(stream_t));
+		return strm;
+	}
+	return calloc(1, sizeof(stream_t));
+}
+
+/**
+ * @brief
+ *	Return a stream structure to the stream pool, or free it if the
+ *	pool is full
+ *
+ * @param[in] strm - The stream structure
+ *
+ * @par MT-safe: No (caller must hold strmarray_lock)
+ *
+ */
+static void
+strm_pool_put(stream_t *strm)
+{
+	strm_pool.frees++;
+	if (strm_pool.count >= TPP_STRM_POOL_MAX) {
+		free(strm);
+		return;
+	}
+	*(void **) strm = strm_pool.free_list;
+	strm_pool.free_list = strm;
+	strm_pool.count++;
+}
+
 /**
  * @brief
  *	Local function to allocate a stream structure
@@ -1359,7 +1457,7 @@ alloc_stream(tpp_addr_t *src_addr, tpp_addr_t *dest_addr)
 		high_sd = sd; /* remember the max sd used */
 	}
 
-	strm = calloc(1, sizeof(stream_t));
+	strm = strm_pool_get();
 	if (!strm) {
 		tpp_unlock(&strmarray_lock);
 		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating stream");
@@ -1392,7 +1490,7 @@ alloc_stream(tpp_addr_t *src_addr, tpp_addr_t *dest_addr)
 		newsize = sd + 100;
 		p = realloc(strmarray, sizeof(stream_slot_t) * newsize);
 		if (!p) {
-			free(strm);
+			strm_pool_put(strm);
 			tpp_unlock(&strmarray_lock);
 			tpp_log_func(LOG_CRIT, __func__, "Out of memory resizing stream array");
 			return NULL;
@@ -1410,7 +1508,7 @@ alloc_stream(tpp_addr_t *src_addr, tpp_addr_t *dest_addr)
 		if (tree_add_del(AVL_streams, &strm->dest_addr, strm, TREE_OP_ADD) != 0) {
 			sprintf(tpp_get_logbuf(), "Failed to add strm with sd=%u to streams", strm->sd);
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
-			free(strm);
+			strm_pool_put(strm);
 			tpp_unlock(&strmarray_lock);
 			return NULL;
 		}
@@ -1548,12 +1646,24 @@ tpp_shutdown()
 			free_stream(sd);
 		}
 	}
+	snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "stream pool: allocs=%lu hits=%lu frees=%lu cached=%d",
+		strm_pool.allocs, strm_pool.hits, strm_pool.frees, strm_pool.count);
+	tpp_log_func(LOG_INFO, NULL, tpp_get_logbuf());
+	while (strm_pool.free_list) {
+		void *next = *(void **) strm_pool.free_list;
+		free(strm_pool.free_list);
+		strm_pool.free_list = next;
+	}
+	strm_pool.count = 0;
 	tpp_unlock(&strmarray_lock);
 	if (strmarray)
 		free(strmarray);
 	tpp_destroy_lock(&strmarray_lock);
 
 	free_routers();
+
+	tpp_log_pool_stats(tpp_get_tls());
+	tpp_free_pools(tpp_get_tls());
 }
 
 /**
@@ -2205,7 +2315,7 @@ tpp_mcast_send(int mtfd, void *data, unsigned int len, unsigned int full_len, un
 	chunks[0].len = sizeof(tpp_mcast_pkt_hdr_t);
 	totlen = chunks[0].len;
 
-	if (tpp_conf->compress == 1 && minfo_len > TPP_SEND_SIZE) {
+	if (tpp_conf->compress == TPP_COMPR_ZLIB && minfo_len > tpp_conf->compress_min) {
 		def_ctx = tpp_multi_deflate_init(minfo_len);
 		if (def_ctx == NULL)
 			goto err;
@@ -2251,7 +2361,28 @@ tpp_mcast_send(int mtfd, void *data, unsigned int len, unsigned int full_len, un
 		}
 	}
 
-	if (def_ctx != NULL) {
+	if (def_ctx == NULL && tpp_conf->compress != TPP_COMPR_NONE &&
+		minfo_len > tpp_conf->compress_min) {
+		/* other codecs compress the whole info block at once */
+		void *outbuf;
+
+		outbuf = tpp_compress(tpp_conf->compress, minfo_buf, minfo_len, &cmpr_len);
+		if (outbuf != NULL && cmpr_len < (unsigned int) minfo_len) {
+			free(minfo_buf);
+			minfo_buf = outbuf;
+			TPP_DBPRT(("*** mcast_send hdr orig=%d, cmprsd=%d", minfo_len, cmpr_len));
+			chunks[1].data = minfo_buf;
+			chunks[1].len = cmpr_len;
+			totlen += chunks[1].len;
+			mhdr.info_cmprsd_len = htonl(cmpr_len);
+		} else {
+			free(outbuf);
+			chunks[1].data = minfo_buf;
+			chunks[1].len = minfo_len;
+			totlen += chunks[1].len;
+			mhdr.info_cmprsd_len = 0;
+		}
+	} else if (def_ctx != NULL) {
 		minfo_buf = tpp_multi_deflate_done(def_ctx, &cmpr_len);
 		if (minfo_buf == NULL)
 			goto err;
@@ -2901,9 +3032,11 @@ queue_ack(stream_t *strm, unsigned char type, unsigned int seq_no_recvd)
 
 /**
  * @brief
- *	Send an ack packet to the destination stream set in the ack packet
+ *	Add an ack for the destination stream set in the ack info to a batch
+ *	of acks to be sent out together
  *
- * @param[in] ack - Ack packet
+ * @param[in] batch - The batch of acks
+ * @param[in] ack - Ack info
  *
  * @return Error code
  * @retval -1 - Failure
@@ -2916,10 +3049,13 @@ queue_ack(stream_t *strm, unsigned char type, unsigned int seq_no_recvd)
  *
  */
 static int
-send_ack_packet(ack_info_t *ack)
+add_ack_to_batch(ack_batch_t *batch, ack_info_t *ack)
 {
 	tpp_data_pkt_hdr_t dhdr;
 	stream_t *strm;
+	int nlen;
+	int sz = sizeof(int) + sizeof(tpp_data_pkt_hdr_t);
+	char *p;
 
 	tpp_lock(&strmarray_lock);
 	strm = strmarray[ack->sd].strm;
@@ -2941,16 +3077,78 @@ send_ack_packet(ack_info_t *ack)
 	memcpy(&dhdr.src_addr, &strm->src_addr, sizeof(tpp_addr_t));
 	memcpy(&dhdr.dest_addr, &strm->dest_addr, sizeof(tpp_addr_t));
 
+	if (batch->len + sz > batch->size) {
+		int size = (batch->size == 0) ? (sz * 16) : (batch->size * 2);
+		if ((p = realloc(batch->buf, size)) == NULL) {
+			tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating ack batch");
+			return -1;
+		}
+		batch->buf = p;
+		batch->size = size;
+	}
+
+	nlen = htonl(sizeof(tpp_data_pkt_hdr_t));
+	memcpy(batch->buf + batch->len, &nlen, sizeof(int));
+	memcpy(batch->buf + batch->len + sizeof(int), &dhdr, sizeof(tpp_data_pkt_hdr_t));
+	batch->len += sz;
+
+	if (batch->len >= TPP_ACK_BATCH_MAX)
+		send_ack_batch(batch);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	Send out a batch of acks to the active router in one packet, and
+ *	reset the batch. If the batch could not be sent, the streams it
+ *	carried acks for are closed, as each lost ack would have done.
+ *
+ * @param[in] batch - The batch of acks
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+send_ack_batch(ack_batch_t *batch)
+{
+	tpp_packet_t *pkt = NULL;
+	tpp_data_pkt_hdr_t *dhdr;
+	stream_t *strm;
+	int off;
+
+	if (batch->len == 0)
+		return;
+
 	active_router = get_active_router(active_router);
-	if (active_router == -1) {
-		return -1;
+	if (active_router != -1)
+		pkt = tpp_cr_pkt(batch->buf, batch->len, 0);
+
+	if (pkt != NULL) {
+		if (tpp_transport_send_raw(routers[active_router]->conn_fd, pkt) == 0) {
+			/* the packet owns the buffer now */
+			batch->buf = NULL;
+			batch->len = 0;
+			batch->size = 0;
+			return;
+		}
+		tpp_log_func(LOG_ERR, __func__, "tpp_transport_send_raw failed");
+		pkt->data = NULL; /* the buffer is still the batch's */
+		tpp_free_pkt(pkt);
 	}
 
-	if (tpp_transport_send(routers[active_router]->conn_fd, &dhdr, sizeof(tpp_data_pkt_hdr_t)) != 0) {
-		tpp_log_func(LOG_ERR, __func__, "tpp_transport_send failed");
-		return -1;
+	for (off = 0; off < batch->len; off += sizeof(int) + sizeof(tpp_data_pkt_hdr_t)) {
+		dhdr = (tpp_data_pkt_hdr_t *) (batch->buf + off + sizeof(int));
+		tpp_lock(&strmarray_lock);
+		strm = strmarray[ntohl(dhdr->src_sd)].strm;
+		tpp_unlock(&strmarray_lock);
+		if (strm)
+			send_app_strm_close(strm, TPP_CMD_NET_CLOSE, 0);
 	}
-	return 0;
+	batch->len = 0;
 }
 
 /**
@@ -3067,6 +3265,7 @@ check_pending_acks(time_t now)
 	tpp_que_elem_t *n = NULL;
 	ack_info_t *ack;
 	stream_t *strm;
+	ack_batch_t batch = {NULL, 0, 0};
 	int rc;
 
 	while ((n = TPP_QUE_HEAD(&global_ack_queue))) {
@@ -3091,7 +3290,7 @@ check_pending_acks(time_t now)
 			}
 
 			TPP_DBPRT(("Sending delayed ack packet sd=%u seq=%u", ack->sd, ack->seq_no));
-			rc = send_ack_packet(ack);
+			rc = add_ack_to_batch(&batch, ack);
 
 			if (rc != 0)
 				send_app_strm_close(strm, TPP_CMD_NET_CLOSE, 0);
@@ -3100,6 +3299,8 @@ check_pending_acks(time_t now)
 		} else
 			break; /* stop if we found an ack thats not yet ready */
 	}
+	send_ack_batch(&batch);
+	free(batch.buf);
 }
 
 /**
@@ -3119,6 +3320,7 @@ flush_acks(stream_t *strm)
 {
 	tpp_que_elem_t *n = NULL;
 	ack_info_t *ack;
+	ack_batch_t batch = {NULL, 0, 0};
 	int rc;
 
 	while ((n = TPP_QUE_HEAD(&strm->ack_queue))) {
@@ -3133,13 +3335,15 @@ flush_acks(stream_t *strm)
 			}
 
 			TPP_DBPRT(("Flushing ack packet sd=%u seq=%u", ack->sd, ack->seq_no));
-			rc = send_ack_packet(ack);
+			rc = add_ack_to_batch(&batch, ack);
 			if (rc != 0)
 				send_app_strm_close(strm, TPP_CMD_NET_CLOSE, 0);
 
 			free(ack);
 		}
 	}
+	send_ack_batch(&batch);
+	free(batch.buf);
 }
 
 /**
@@ -3562,7 +3766,7 @@ add_part_packet(stream_t *strm, void *data, int sz)
 			tpp_packet_t *tmp = obj;
 			void *uncmpr_data;
 
-			if ((uncmpr_data = tpp_inflate(tmp->data, cmprsd_len, totlen))) {
+			if ((uncmpr_data = tpp_uncompress(tmp->data, cmprsd_len, totlen))) {
 				obj = tpp_cr_pkt(uncmpr_data, totlen, 0);
 				if (!obj)
 					free(uncmpr_data);
@@ -3819,7 +4023,7 @@ free_stream(unsigned int sd)
 
 	strmarray[sd].slot_state = TPP_SLOT_FREE;
 	strmarray[sd].strm = NULL;
-	free(strm);
+	strm_pool_put(strm);
 
 	if (freed_queue_count < 100) {
 		tpp_enque(&freed_sd_queue, (void *)(intptr_t) sd);
@@ -126,13 +126,21 @@ typedef struct {
 /*
  * Packet structure used at various places to hold a data and the
  * current position to which data has been consumed or processed
+ *
+ * A packet may borrow the data of another packet (shared), so that the
+ * same payload can be queued to many connections without copying it.
+ * The borrowed packet is held by a reference until the borrower is
+ * freed. A packet may also carry the rest of its message as a chain of
+ * further packets (next_frag), which are queued right behind it.
  */
-typedef struct {
+typedef struct tpp_packet {
 	char *data;	/* pointer to the data buffer */
 	int len;	/* length of the data buffer */
 	char *pos;	/* current position - till which data is consumed */
 	void *extra_data;	/* any additional data */
 	int ref_count;	/* number of accessors */
+	struct tpp_packet *shared;	/* packet whose data is borrowed, if any */
+	struct tpp_packet *next_frag;	/* rest of the message, if any */
 } tpp_packet_t;
 
 /*
@@ -270,6 +278,11 @@ enum TPP_MSG_TYPES {
 #define TPP_MIN_WAIT            2
 #define TPP_SEND_SIZE           8192
 
+/* adaptive compression, see tpp_send */
+#define TPP_CMPR_POOR_PCT       10  /* compression saving less than this percent is poor */
+#define TPP_CMPR_POOR_MAX       4   /* consecutive poor compressions before skipping */
+#define TPP_CMPR_SKIP           64  /* sends to skip compression for, once it is poor */
+
 /* tpp cmds used internally by the layer to notify messages between threads */
 #define TPP_CMD_SEND            1
 #define TPP_CMD_CLOSE           2
@@ -285,6 +298,7 @@ enum TPP_MSG_TYPES {
 
 #define TPP_DEF_ROUTER_PORT     17001
 #define TPP_SCRATCHSIZE         8192
+#define TPP_SHARE_MIN           1024 /* smaller payloads are copied rather than shared */
 
 #define TPP_ROUTER_STATE_DISCONNECTED	0   /* Leaf not connected to router */
 #define TPP_ROUTER_STATE_CONNECTING		1   /* Leaf is connecting to router */
@@ -352,10 +366,11 @@ typedef struct {
  * The cmd structure is used to package the
  * command messages passed between threads
  */
-typedef struct {
+typedef struct tpp_cmd {
 	unsigned int tfd;
 	int cmdval;
 	void *data;
+	struct tpp_cmd *next; /* link in the mbox */
 } tpp_cmd_t;
 
 /*
@@ -364,10 +379,20 @@ typedef struct {
  * thread, it posts a message to that threads mbox.
  * That wakes up the thread from a poll/select
  * and allows to act on the message
+ *
+ * Any thread may post, but only the owning thread reads, so the mbox is
+ * a lock-free multi-producer/single-consumer queue. Posters swap
+ * themselves in at mbox_in, the owner reads from mbox_out. The
+ * notification fd is only written when the mbox goes from empty to
+ * non-empty.
  */
 typedef struct {
-	pthread_mutex_t mbox_mutex;
-	tpp_que_t mbox_queue;
+	tpp_cmd_t *mbox_in;	/* last cmd posted, swapped by posters */
+	tpp_cmd_t *mbox_out;	/* next cmd to read, owner only */
+	tpp_cmd_t mbox_stub;	/* placeholder that keeps the queue linked */
+	long mbox_pending;	/* cmds posted and not yet taken out */
+	tpp_cmd_t *mbox_held;	/* cmds set aside by tpp_mbox_clear, owner only */
+	tpp_cmd_t *mbox_held_tail;
 #ifdef HAVE_SYS_EVENTFD_H
 	int mbox_eventfd;
 #else
@@ -383,8 +408,25 @@ typedef struct {
 #define TPP_QUE_NEXT(q, n) (((n) == NULL)?(q)->head:(n)->next)
 #define TPP_QUE_DATA(n)    (((n) == NULL)?NULL:(n)->queue_data)
 
+/*
+ * Per-thread cache of freed fixed size objects (packet headers, queue
+ * elements), so that the hot paths can recycle them without going to
+ * malloc/free every time. Objects are linked through their first word.
+ */
+#define TPP_POOL_MAX	4096	/* max objects cached per pool per thread */
+
+typedef struct {
+	void *free_list;	/* cached free objects */
+	int count;		/* number of objects in free_list */
+	unsigned long allocs;	/* total allocations served */
+	unsigned long hits;	/* allocations served from free_list */
+	unsigned long frees;	/* total objects returned */
+} tpp_pool_t;
+
 typedef struct {
 	void *td;
+	tpp_pool_t pkt_pool;	/* cache of tpp_packet_t */
+	tpp_pool_t que_pool;	/* cache of tpp_que_elem_t */
 	char tpplogbuf[TPP_LOGBUF_SZ];
 	char tppstaticbuf[TPP_LOGBUF_SZ];
 	void *log_data; /* data created by the logging layer for the TPP threads */
@@ -409,6 +451,8 @@ char* convert_to_ip_port(char *host_port, int port);
 
 int tpp_init_tls_key(void);
 tpp_tls_t *tpp_get_tls(void);
+void tpp_free_pools(tpp_tls_t *ptr);
+void tpp_log_pool_stats(tpp_tls_t *ptr);
 char *tpp_get_logbuf(void);
 char *mk_hostname(char *host, int port);
 int tpp_open(char *dest_host, unsigned int port);
@@ -422,6 +466,7 @@ void tpp_terminate(void);
 int tpp_poll(void);
 char *tpp_parse_hostname(char *full, int *port);
 tpp_packet_t *tpp_cr_pkt(void *data, int len, int mk_data);
+tpp_packet_t *tpp_share_pkt(tpp_packet_t *pkt);
 
 void tpp_router_shutdown(void);
 void tpp_router_terminate(void);
@@ -445,6 +490,8 @@ void tpp_transport_shutdown(void);
 int tpp_transport_terminate(void);
 int tpp_transport_send(int tfd, void *data, int len);
 int tpp_transport_send_raw(int tfd, tpp_packet_t *pkt);
+tpp_packet_t *tpp_transport_cr_pkt(tpp_chunk_t *chunk, int count);
+int tpp_transport_vsend_shared(int tfd, tpp_chunk_t *chunk, int count, tpp_packet_t *payload);
 int tpp_init_router(struct tpp_config *cnf);
 void tpp_transport_set_conn_ctx(int tfd, void *ctx);
 void *tpp_transport_get_conn_ctx(int tfd);
@@ -486,6 +533,9 @@ void *tpp_inflate(void *inbuf, unsigned int inlen, unsigned int totlen);
 void *tpp_multi_deflate_init(int len);
 int tpp_multi_deflate_do(void *ctx, int fini, void *inbuf, unsigned int inlen);
 void *tpp_multi_deflate_done(void *c, unsigned int *cmpr_len);
+void *tpp_compress(int codec, void *inbuf, unsigned int inlen, unsigned int *outlen);
+void *tpp_uncompress(void *inbuf, unsigned int inlen, unsigned int totlen);
+int tpp_get_codec(char *name);
 
 int tpp_add_fd(int ctl_fd, int fd, int event);
 int tpp_del_fd(int ctl_fd, int fd);
@@ -649,7 +699,7 @@ int tpp_mbox_init(tpp_mbox_t *mbox);
 void tpp_mbox_destroy(tpp_mbox_t *mbox);
 int tpp_mbox_monitor(void *em_ctx, tpp_mbox_t *mbox);
 int tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data);
-int tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, int *cmdval, void **data);
+int tpp_mbox_clear(tpp_mbox_t *mbox, tpp_cmd_t **n, unsigned int tfd, int *cmdval, void **data);
 int tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data);
 int tpp_mbox_getfd(tpp_mbox_t *mbox);
 void tpp_mbox_drain_unsafe(tpp_mbox_t *mbox);
@@ -726,7 +726,8 @@ DIS_tpp_destroy(int fd)
  * @param[in] port     - The port at which this side is identified.
  * @param[in] routers  - Array of router addresses ended by a null entry
  *			 router addresses are of the form "host:port"
- * @param[in] compress - Whether compression of data must be done
+ * @param[in] compress - Whether compression of data must be done, the codec
+ *			 and threshold to use are read from pbs_conf
  *
  *
  * @retval Error code
@@ -880,11 +881,25 @@ set_tpp_config(struct pbs_config *pbs_conf,
 	}
 	tpp_log_func(LOG_INFO, NULL, log_buffer);
 
+	tpp_conf->compress = TPP_COMPR_NONE;
+	if (compress) {
+		if (pbs_conf->pbs_compression_codec && pbs_conf->pbs_compression_codec[0] != '\0') {
+			if ((i = tpp_get_codec(pbs_conf->pbs_compression_codec)) == -1) {
+				snprintf(log_buffer, TPP_LOGBUF_SZ, "Compression codec %s is not available, using the default",
+					pbs_conf->pbs_compression_codec);
+				tpp_log_func(LOG_WARNING, NULL, log_buffer);
+			} else
+				tpp_conf->compress = i;
+		}
 #ifdef PBS_COMPRESSION_ENABLED
-	tpp_conf->compress = compress;
-#else
-	tpp_conf->compress = 0;
+		if (tpp_conf->compress == TPP_COMPR_NONE)
+			tpp_conf->compress = TPP_COMPR_ZLIB;
 #endif
+	}
+	tpp_conf->compress_min = TPP_SEND_SIZE;
+	if (pbs_conf->pbs_compression_threshold > 0)
+		tpp_conf->compress_min = pbs_conf->pbs_compression_threshold;
+	tpp_conf->compress_adaptive = pbs_conf->pbs_compression_adaptive;
 
 	/* set default parameters for keepalive */
 	tpp_conf->tcp_keepalive = 1;
@@ -939,6 +954,8 @@ set_tpp_config(struct pbs_config *pbs_conf,
 	else
 		tpp_conf->force_fault_tolerance = 0;
 
+	tpp_conf->coalesce_ms = pbs_conf->pbs_comm_coalesce_ms;
+
 	if (routers && routers[0] != '\0') {
 		char *p = routers;
 		char *q;
@@ -1354,8 +1354,12 @@ tpp_em_pwait(void *em_ctx, em_event_t **ev_array, int timeout, const sigset_t *s
 int
 tpp_mbox_init(tpp_mbox_t *mbox)
 {
-	tpp_init_lock(&mbox->mbox_mutex);
-	TPP_QUE_CLEAR(&mbox->mbox_queue);
+	mbox->mbox_stub.next = NULL;
+	mbox->mbox_in = &mbox->mbox_stub;
+	mbox->mbox_out = &mbox->mbox_stub;
+	mbox->mbox_pending = 0;
+	mbox->mbox_held = NULL;
+	mbox->mbox_held_tail = NULL;
 
 #ifdef HAVE_SYS_EVENTFD_H
 	if ((mbox->mbox_eventfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
@@ -1435,7 +1439,6 @@ tpp_mbox_destroy(tpp_mbox_t *mbox)
 	if (mbox->mbox_pipe[1] > -1)
 		tpp_pipe_close(mbox->mbox_pipe[1]);
 #endif
-	tpp_destroy_lock(&mbox->mbox_mutex);
 }
 
 /**
@@ -1479,6 +1482,123 @@ tpp_mbox_monitor(void *em_ctx, tpp_mbox_t *mbox)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Link a cmd at the tail of the mbox queue
+ *
+ * @par Functionality
+ *	The tail is swapped in a single atomic exchange, so any number of
+ *	threads can post at once without a lock. Between the exchange and
+ *	the store of the link the queue is briefly broken, which mbox_take
+ *	treats as "nothing to read yet".
+ *
+ * @param[in] - mbox - The mbox
+ * @param[in] - cmd  - The cmd to link
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+mbox_link(tpp_mbox_t *mbox, tpp_cmd_t *cmd)
+{
+	tpp_cmd_t *prev;
+
+	cmd->next = NULL;
+	prev = tpp_atomic_xchg_ptr(&mbox->mbox_in, cmd);
+	tpp_atomic_store_ptr(&prev->next, cmd);
+}
+
+/**
+ * @brief
+ *	Take the cmd at the head of the mbox queue
+ *
+ * @param[in] - mbox - The mbox
+ *
+ * @return  The cmd
+ * @retval  NULL - the queue is empty, or a post is midway through linking
+ *
+ * @par MT-safe: No (only the thread owning the mbox may call this)
+ *
+ */
+static tpp_cmd_t *
+mbox_take(tpp_mbox_t *mbox)
+{
+	tpp_cmd_t *out = mbox->mbox_out;
+	tpp_cmd_t *next = tpp_atomic_load_ptr(&out->next);
+
+	if (out == &mbox->mbox_stub) {
+		if (next == NULL)
+			return NULL;
+		mbox->mbox_out = next;
+		out = next;
+		next = tpp_atomic_load_ptr(&next->next);
+	}
+
+	if (next == NULL) {
+		if (out != tpp_atomic_load_ptr(&mbox->mbox_in))
+			return NULL; /* a post is in progress */
+
+		/* out is the last cmd, put the stub behind it so out can be taken */
+		mbox_link(mbox, &mbox->mbox_stub);
+		if ((next = tpp_atomic_load_ptr(&out->next)) == NULL)
+			return NULL;
+	}
+
+	mbox->mbox_out = next;
+	tpp_atomic_add(&mbox->mbox_pending, -1);
+	return out;
+}
+
+/**
+ * @brief
+ *	Write the notification for an mbox, waking up its thread
+ *
+ * @param[in] - mbox - The mbox
+ *
+ * @return Error code
+ * @retval -1 Failure
+ * @retval  0 Success
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+mbox_notify(tpp_mbox_t *mbox)
+{
+	ssize_t s;
+#ifdef HAVE_SYS_EVENTFD_H
+	uint64_t u;
+#else
+	char b;
+#endif
+
+	while (1) {
+		/* send a notification to the thread */
+#ifdef HAVE_SYS_EVENTFD_H
+		u = 1;
+		s = write(mbox->mbox_eventfd, &u, sizeof(uint64_t));
+		if (s == sizeof(uint64_t))
+			break;
+#else
+		b = 1;
+		s = tpp_pipe_write(mbox->mbox_pipe[1], &b, sizeof(char));
+		if (s == sizeof(char))
+			break;
+#endif
+		if (s == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				/* pipe is full, which is fine, anyway we behave like edge triggered */
+				break;
+			} else if (errno != EINTR) {
+				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "mbox post failed, errno=%d", errno);
+				tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
 /**
  * @brief
  *	Read a command from the msg box.
@@ -1495,7 +1615,7 @@ tpp_mbox_monitor(void *em_ctx, tpp_mbox_t *mbox)
  * @par Side Effects:
  *	None
  *
- * @par MT-safe: Yes
+ * @par MT-safe: No (only the thread owning the mbox may read it)
  *
  */
 int
@@ -1511,22 +1631,31 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 	*cmdval = -1;
 	errno = 0;
 
-	tpp_lock(&mbox->mbox_mutex);
-
-	/* read the data from the mbox cmd queue head */
-	cmd = (tpp_cmd_t *) tpp_deque(&mbox->mbox_queue);
-
-	/* if no more data, clear all notifications */
-	if (cmd == NULL) {
+	/* cmds set aside by tpp_mbox_clear were posted first */
+	if ((cmd = mbox->mbox_held) != NULL) {
+		if ((mbox->mbox_held = cmd->next) == NULL)
+			mbox->mbox_held_tail = NULL;
+	} else if ((cmd = mbox_take(mbox)) == NULL) {
+		/*
+		 * No more data, clear the notification and look again,
+		 * so that a post which raced with us is not missed.
+		 */
 #ifdef HAVE_SYS_EVENTFD_H
 		read(mbox->mbox_eventfd, &u, sizeof(uint64_t));
 #else
 		while (tpp_pipe_read(mbox->mbox_pipe[0], &b, sizeof(char)) == sizeof(char));
 #endif
+		cmd = mbox_take(mbox);
+
+		/*
+		 * If something is left behind (the cmd just taken may not be the
+		 * last one, or a post is still linking) its notification may have
+		 * been cleared above, so raise it again.
+		 */
+		if (tpp_atomic_load(&mbox->mbox_pending) != 0)
+			mbox_notify(mbox);
 	}
 
-	tpp_unlock(&mbox->mbox_mutex);
-
 	if (cmd == NULL) {
 		errno = EWOULDBLOCK;
 		return -1;
@@ -1556,14 +1685,18 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 void
 tpp_mbox_drain_unsafe(tpp_mbox_t *mbox)
 {
-	tpp_que_elem_t *n = NULL;
+	tpp_cmd_t *cmd;
 
-	while ((n = TPP_QUE_NEXT(&mbox->mbox_queue, n))) {
-		tpp_cmd_t *cmd;
-		if ((cmd = TPP_QUE_DATA(n)))
-			free(cmd->data);
+	while ((cmd = mbox->mbox_held) != NULL) {
+		mbox->mbox_held = cmd->next;
+		free(cmd->data);
+		free(cmd);
+	}
+	mbox->mbox_held_tail = NULL;
+
+	while ((cmd = mbox_take(mbox)) != NULL) {
+		free(cmd->data);
 		free(cmd);
-		n = tpp_que_del_elem(&mbox->mbox_queue, n);
 	}
 }
 
@@ -1575,8 +1708,14 @@ tpp_mbox_drain_unsafe(tpp_mbox_t *mbox)
  *	the caller wants to clear the pending commands for
  *	that connection from this thread mbox
  *
+ * @par Functionality
+ *	Everything posted so far is first moved aside to the mbox's held
+ *	list (which only the owning thread touches, and which tpp_mbox_read
+ *	drains first), and the held list is searched from there.
+ *
  * @param[in] - mbox   - The mbox to read from
- * @param[in] - n      - The node/position to start searching from
+ * @param[in,out] - n  - The held cmd after which to search (NULL to
+ *			 start at the head). Updated for the next call.
  * @param[in] - tfd    - The Virtual file descriptor
  * @param[out] - cmdval - Return the cmdval
  * @param[out] - data - Any data associated
@@ -1584,33 +1723,48 @@ tpp_mbox_drain_unsafe(tpp_mbox_t *mbox)
  * @par Side Effects:
  *	None
  *
- * @par MT-safe: Yes
+ * @par MT-safe: No (only the thread owning the mbox may call this)
  *
  */
 int
-tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, int *cmdval, void **data)
+tpp_mbox_clear(tpp_mbox_t *mbox, tpp_cmd_t **n, unsigned int tfd, int *cmdval, void **data)
 {
 	tpp_cmd_t *cmd;
-	int ret = -1;
+	tpp_cmd_t *prev;
+
 	errno = 0;
 
-	tpp_lock(&mbox->mbox_mutex);
+	while ((cmd = mbox_take(mbox)) != NULL) {
+		cmd->next = NULL;
+		if (mbox->mbox_held_tail)
+			mbox->mbox_held_tail->next = cmd;
+		else
+			mbox->mbox_held = cmd;
+		mbox->mbox_held_tail = cmd;
+	}
 
-	while ((*n = TPP_QUE_NEXT(&mbox->mbox_queue, *n))) {
-		cmd = TPP_QUE_DATA(*n);
-		if (cmd && cmd->tfd == tfd) {
-			*n = tpp_que_del_elem(&mbox->mbox_queue, *n);
+	prev = *n;
+	cmd = prev ? prev->next : mbox->mbox_held;
+	while (cmd) {
+		if (cmd->tfd == tfd) {
+			if (prev)
+				prev->next = cmd->next;
+			else
+				mbox->mbox_held = cmd->next;
+			if (mbox->mbox_held_tail == cmd)
+				mbox->mbox_held_tail = prev;
+			*n = prev;
 			*cmdval = cmd->cmdval;
 			*data = cmd->data;
 			free(cmd);
-			ret = 0;
-			break;
+			return 0;
 		}
+		prev = cmd;
+		cmd = cmd->next;
 	}
+	*n = prev;
 
-	tpp_unlock(&mbox->mbox_mutex);
-
-	return ret;
+	return -1;
 }
 
 /**
@@ -1636,12 +1790,6 @@ int
 tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 {
 	tpp_cmd_t *cmd;
-	ssize_t s;
-#ifdef HAVE_SYS_EVENTFD_H
-	uint64_t u;
-#else
-	char b;
-#endif
 
 	errno = 0;
 	cmd = malloc(sizeof(tpp_cmd_t));
@@ -1655,38 +1803,11 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 	cmd->data = data;
 
 	/* add the cmd to the threads queue */
-	tpp_lock(&mbox->mbox_mutex);
-	if (tpp_enque(&mbox->mbox_queue, cmd) == NULL) {
-		tpp_unlock(&mbox->mbox_mutex);
-		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory in em_mbox_post");
-		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
-		return -1;
-	}
-	tpp_unlock(&mbox->mbox_mutex);
+	mbox_link(mbox, cmd);
 
-	while (1) {
-		/* send a notification to the thread */
-#ifdef HAVE_SYS_EVENTFD_H
-		u = 1;
-		s = write(mbox->mbox_eventfd, &u, sizeof(uint64_t));
-		if (s == sizeof(uint64_t))
-			break;
-#else
-		b = 1;
-		s = tpp_pipe_write(mbox->mbox_pipe[1], &b, sizeof(char));
-		if (s == sizeof(char))
-			break;
-#endif
-		if (s == -1) {
-			if (errno == EAGAIN || errno == EWOULDBLOCK) {
-				/* pipe is full, which is fine, anyway we behave like edge triggered */
-				break;
-			} else if (errno != EINTR) {
-				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "mbox post failed, errno=%d", errno);
-				tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
-				return -1;
-			}
-		}
-	}
-	return 0;
+	/* only the post that makes the mbox non-empty needs to wake the thread */
+	if (tpp_atomic_add(&mbox->mbox_pending, 1) != 0)
+		return 0;
+
+	return mbox_notify(mbox);
 }
@@ -375,6 +375,29 @@ tpp_sock_send(int s, const char *buf, int len, int flags)
 	return ret;
 }
 
+/*
+ * emulate writev() on sockets by sending each buffer in turn, stopping
+ * at the first short send, so that the return value has the same meaning
+ * as that of writev()
+ */
+int
+tpp_sock_sendv(int s, tpp_iovec_t *iov, int iovcnt)
+{
+	int i;
+	int ret;
+	int sent = 0;
+
+	for (i = 0; i < iovcnt; i++) {
+		ret = tpp_sock_send(s, iov[i].iov_base, (int) iov[i].iov_len, 0);
+		if (ret < 0)
+			return (sent > 0) ? sent : -1;
+		sent += ret;
+		if (ret < (int) iov[i].iov_len)
+			break;
+	}
+	return sent;
+}
+
 /*
  * wrapper to call windows select() and map windows
  * error code to errno and massage the return value
@@ -907,3 +930,29 @@ tpp_is_valid_thrd(pthread_t thrd)
 #endif
 	return 0;
 }
+
+/**
+ * @brief
+ *	Return a monotonic time in milliseconds, for timing intervals
+ *	shorter than a second
+ *
+ * @return  time in milliseconds from an arbitrary starting point
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+long long
+tpp_time_ms(void)
+{
+#ifndef WIN32
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((long long) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+#else
+	return (long long) GetTickCount64();
+#endif
+}
@@ -71,10 +71,29 @@ extern "C" {
 #define tpp_sock_getsockopt(a, b, c, d, e)   getsockopt(a, b, c, d, e)
 #define tpp_sock_setsockopt(a, b, c, d, e)   setsockopt(a, b, c, d, e)
 
+/* gather write of several buffers, see tpp_sock_sendv */
+#include <sys/uio.h>
+typedef struct iovec tpp_iovec_t;
+#define tpp_sock_sendv(a, b, c)       writev(a, b, c)
+
+/* atomic primitives, full barriers */
+#define tpp_atomic_xchg_ptr(p, v)	__atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define tpp_atomic_load_ptr(p)		__atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define tpp_atomic_store_ptr(p, v)	__atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define tpp_atomic_add(p, v)		__atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define tpp_atomic_load(p)		__atomic_load_n((p), __ATOMIC_SEQ_CST)
+
 #else
 
 #define EINPROGRESS   EAGAIN
 
+/* atomic primitives, full barriers */
+#define tpp_atomic_xchg_ptr(p, v)	InterlockedExchangePointer((PVOID volatile *)(p), (v))
+#define tpp_atomic_load_ptr(p)		InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+#define tpp_atomic_store_ptr(p, v)	((void) InterlockedExchangePointer((PVOID volatile *)(p), (v)))
+#define tpp_atomic_add(p, v)		InterlockedExchangeAdd((LONG volatile *)(p), (v))
+#define tpp_atomic_load(p)		InterlockedCompareExchange((LONG volatile *)(p), 0, 0)
+
 int tpp_pipe_cr(int fds[2]);
 int tpp_pipe_read(int s, char *buf, int len);
 int tpp_pipe_write(int s, char *buf, int len);
@@ -92,6 +111,12 @@ int tpp_sock_close(int s);
 int tpp_sock_getsockopt(int s, int level, int optname, int *optval, int *optlen);
 int tpp_sock_setsockopt(int s, int level, int optname, const int *optval, int optlen);
 
+typedef struct {
+	void *iov_base;
+	size_t iov_len;
+} tpp_iovec_t;
+int tpp_sock_sendv(int s, tpp_iovec_t *iov, int iovcnt);
+
 #endif
 
 int tpp_sock_layer_init();
@@ -100,4 +125,5 @@ int set_pipe_disposition();
 int tpp_sock_attempt_connection(int fd, char *host, int port);
 void tpp_invalidate_thrd_handle(pthread_t *thrd);
 int tpp_is_valid_thrd(pthread_t thrd);
+long long tpp_time_ms(void);
 #endif
@@ -93,8 +93,31 @@ pthread_mutex_t router_lock; /* for now only a write only lock, since our avltre
 /* AVL tree of routers connected to this router */
 AVL_IX_DESC *AVL_routers = NULL;
 
-/* AVL tree of all leaves in the cluster */
-AVL_IX_DESC *AVL_cluster_leaves = NULL;
+/*
+ * Index of all leaves in the cluster, by address. This is the routing
+ * table consulted for every forwarded packet, so it is split into shards
+ * on a hash of the address, each with its own rwlock. Forwarding only
+ * takes the read lock of one shard, so the IO threads route in parallel.
+ * Joins and leaves are still serialized by router_lock, and additionally
+ * take the write locks of the shards they change. A leaf's routes (conn_fd
+ * and its list of routers) are only changed while holding the write locks
+ * of the shards of all its addresses (see leaf_wrlock).
+ */
+#define TPP_LEAF_SHARDS		64
+#define TPP_LEAF_BUCKETS	1024	/* hash buckets per shard */
+
+typedef struct leaf_idx_ent {
+	tpp_addr_t addr;
+	tpp_leaf_t *leaf;
+	struct leaf_idx_ent *next;
+} leaf_idx_ent_t;
+
+typedef struct {
+	pthread_rwlock_t lock;
+	leaf_idx_ent_t *buckets[TPP_LEAF_BUCKETS];
+} leaf_shard_t;
+
+static leaf_shard_t *leaf_shards = NULL;
 
 /* AVL tree of special routers who need to be notified for join updates */
 AVL_IX_DESC *AVL_my_leaves_notify = NULL;
@@ -114,6 +137,244 @@ static int router_post_connect_handler(int tfd, void *data, void *c);
 /* structure identifying this router */
 static tpp_router_t *this_router = NULL;
 
+/**
+ * @brief
+ *	Hash a leaf address to its shard and bucket in the leaf index
+ *
+ * @param[in] - addr - The address
+ * @param[out] - bucket - The bucket within the shard
+ *
+ * @return	The shard index
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+leaf_addr_shard(tpp_addr_t *addr, int *bucket)
+{
+	unsigned int h = 2166136261u;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		h = (h ^ (unsigned int) addr->ip[i]) * 16777619u;
+	h = (h ^ (unsigned short) addr->port) * 16777619u;
+	h = (h ^ (unsigned char) addr->family) * 16777619u;
+
+	*bucket = (h / TPP_LEAF_SHARDS) % TPP_LEAF_BUCKETS;
+	return h % TPP_LEAF_SHARDS;
+}
+
+/**
+ * @brief
+ *	Whether two leaf addresses are the same
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+leaf_addr_eq(tpp_addr_t *a, tpp_addr_t *b)
+{
+	return (a->ip[0] == b->ip[0] && a->ip[1] == b->ip[1] &&
+		a->ip[2] == b->ip[2] && a->ip[3] == b->ip[3] &&
+		a->port == b->port && a->family == b->family);
+}
+
+/**
+ * @brief
+ *	Find the leaf owning an address in the leaf index
+ *
+ * @param[in] - addr - The address
+ *
+ * @return	The leaf
+ * @retval	NULL - no leaf has this address
+ *
+ * @par MT-safe: No (caller must hold router_lock, or the read lock of
+ *		 the address' shard)
+ *
+ */
+static tpp_leaf_t *
+leaf_idx_lookup(tpp_addr_t *addr)
+{
+	leaf_idx_ent_t *e;
+	int b;
+	int sh = leaf_addr_shard(addr, &b);
+
+	for (e = leaf_shards[sh].buckets[b]; e; e = e->next) {
+		if (leaf_addr_eq(&e->addr, addr))
+			return e->leaf;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Add an address of a leaf to the leaf index
+ *
+ * @param[in] - addr - The address
+ * @param[in] - l    - The leaf
+ *
+ * @return	Error code
+ * @retval	-1 - Failure (address already present, or out of memory)
+ * @retval	 0 - Success
+ *
+ * @par MT-safe: No (caller must hold router_lock)
+ *
+ */
+static int
+leaf_idx_add(tpp_addr_t *addr, tpp_leaf_t *l)
+{
+	leaf_idx_ent_t *e;
+	int b;
+	int sh = leaf_addr_shard(addr, &b);
+
+	if (leaf_idx_lookup(addr))
+		return -1;
+
+	if ((e = malloc(sizeof(leaf_idx_ent_t))) == NULL)
+		return -1;
+	memcpy(&e->addr, addr, sizeof(tpp_addr_t));
+	e->leaf = l;
+
+	tpp_wrlock_rwlock(&leaf_shards[sh].lock);
+	e->next = leaf_shards[sh].buckets[b];
+	leaf_shards[sh].buckets[b] = e;
+	tpp_unlock_rwlock(&leaf_shards[sh].lock);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	Delete an address from the leaf index
+ *
+ * @param[in] - addr - The address
+ *
+ * @return	Error code
+ * @retval	 1 - Address not found
+ * @retval	 0 - Success
+ *
+ * @par MT-safe: No (caller must hold router_lock)
+ *
+ */
+static int
+leaf_idx_del(tpp_addr_t *addr)
+{
+	leaf_idx_ent_t **pe;
+	leaf_idx_ent_t *e;
+	int b;
+	int sh = leaf_addr_shard(addr, &b);
+
+	tpp_wrlock_rwlock(&leaf_shards[sh].lock);
+	for (pe = &leaf_shards[sh].buckets[b]; (e = *pe) != NULL; pe = &e->next) {
+		if (leaf_addr_eq(&e->addr, addr)) {
+			*pe = e->next;
+			tpp_unlock_rwlock(&leaf_shards[sh].lock);
+			free(e);
+			return 0;
+		}
+	}
+	tpp_unlock_rwlock(&leaf_shards[sh].lock);
+	return 1;
+}
+
+/**
+ * @brief
+ *	Take (or release) the write locks of the shards of all of a leaf's
+ *	addresses, so that the leaf's routes can be changed without any
+ *	packet being routed through the leaf at the same time
+ *
+ * @param[in] - l - The leaf
+ * @param[in] - lock - 1 to lock, 0 to unlock
+ *
+ * @par MT-safe: No (caller must hold router_lock)
+ *
+ */
+static void
+leaf_shards_lock(tpp_leaf_t *l, int lock)
+{
+	char want[TPP_LEAF_SHARDS];
+	int i;
+	int b;
+
+	memset(want, 0, sizeof(want));
+	for (i = 0; i < l->num_addrs; i++)
+		want[leaf_addr_shard(&l->leaf_addrs[i], &b)] = 1;
+
+	/* always in shard order, so lockers can never deadlock */
+	for (i = 0; i < TPP_LEAF_SHARDS; i++) {
+		if (!want[i])
+			continue;
+		if (lock)
+			tpp_wrlock_rwlock(&leaf_shards[i].lock);
+		else
+			tpp_unlock_rwlock(&leaf_shards[i].lock);
+	}
+}
+
+#define leaf_wrlock(l)		leaf_shards_lock((l), 1)
+#define leaf_wrunlock(l)	leaf_shards_lock((l), 0)
+
+/**
+ * @brief
+ *	Find the route to the leaf with the given address
+ *
+ * @par Functionality
+ *	This is the per-packet lookup. It takes only the read lock of the
+ *	shard of the address, not router_lock.
+ *
+ * @param[in] - dest - The address of the leaf
+ * @param[out] - target - The router to send to (this_router if the leaf
+ *			  is connected directly), NULL if none is connected
+ * @param[out] - fd - fd of the connection to send to
+ *
+ * @return	Error code
+ * @retval	-1 - No leaf with this address is known
+ * @retval	 0 - Leaf found, see target
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+route_to_leaf(tpp_addr_t *dest, tpp_router_t **target, int *fd)
+{
+	tpp_leaf_t *l;
+	int b;
+	int sh = leaf_addr_shard(dest, &b);
+
+	*target = NULL;
+	*fd = -1;
+
+	tpp_rdlock_rwlock(&leaf_shards[sh].lock);
+	if ((l = leaf_idx_lookup(dest)) != NULL)
+		*target = get_preferred_router(l, this_router, fd);
+	tpp_unlock_rwlock(&leaf_shards[sh].lock);
+
+	return (l == NULL) ? -1 : 0;
+}
+
+/**
+ * @brief
+ *	Create the leaf index
+ *
+ * @return	Error code
+ * @retval	-1 - Failure
+ * @retval	 0 - Success
+ *
+ * @par MT-safe: No
+ *
+ */
+static int
+leaf_idx_init(void)
+{
+	int i;
+
+	if ((leaf_shards = calloc(TPP_LEAF_SHARDS, sizeof(leaf_shard_t))) == NULL)
+		return -1;
+	for (i = 0; i < TPP_LEAF_SHARDS; i++)
+		tpp_init_rwlock(&leaf_shards[i].lock);
+	return 0;
+}
+
 static tpp_router_t *
 alloc_router(char *name, tpp_addr_t *address)
 {
@@ -334,6 +595,7 @@ broadcast_to_my_routers(tpp_chunk_t *chunks, int count, int origin_tfd)
 	int list[TPP_MAX_ROUTERS];
 	int max_cons = 0;
 	int i;
+	tpp_packet_t *pkt;
 
 	pkey = avlkey_create(AVL_routers, NULL);
 	if (pkey == NULL) {
@@ -356,11 +618,21 @@ broadcast_to_my_routers(tpp_chunk_t *chunks, int count, int origin_tfd)
 
 	free(pkey);
 
+	if (max_cons == 0)
+		return 0;
+
+	/* build the data once, every router's queue shares it */
+	if ((pkt = tpp_transport_cr_pkt(chunks, count)) == NULL) {
+		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating broadcast packet");
+		return -1;
+	}
+
 	for (i = 0; i < max_cons; i++) {
-		if (tpp_transport_vsend(list[i], chunks, count) != 0) {
+		if (tpp_transport_vsend_shared(list[i], NULL, 0, pkt) != 0) {
 			tpp_log_func(LOG_ERR, __func__, "send failed");
 		}
 	}
+	tpp_free_pkt(pkt);
 	return 0;
 }
 
@@ -401,6 +673,7 @@ broadcast_to_my_leaves(tpp_chunk_t *chunks, int count, int origin_tfd, int type)
 	int max_cons = 0;
 	int i;
 	AVL_IX_DESC *AVL_traverse_tree = NULL;
+	tpp_packet_t *pkt;
 
 	if (type == 1)
 		AVL_traverse_tree = AVL_my_leaves_notify;
@@ -451,12 +724,25 @@ broadcast_to_my_leaves(tpp_chunk_t *chunks, int count, int origin_tfd, int type)
 	tpp_unlock(&router_lock);
 	free(pkey);
 
+	if (max_cons == 0) {
+		free(list);
+		return 0;
+	}
+
+	/* build the data once, every leaf's queue shares it */
+	if ((pkt = tpp_transport_cr_pkt(chunks, count)) == NULL) {
+		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating broadcast packet");
+		free(list);
+		return -1;
+	}
+
 	for (i = 0; i < max_cons; i++) {
-		if (tpp_transport_vsend(list[i], chunks, count) != 0) {
+		if (tpp_transport_vsend_shared(list[i], NULL, 0, pkt) != 0) {
 			if (errno != ENOTCONN)
 				tpp_log_func(LOG_ERR, __func__, "send failed");
 		}
 	}
+	tpp_free_pkt(pkt);
 
 	free(list);
 	return 0;
@@ -657,7 +943,13 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 
 		tpp_lock(&router_lock);
 
-		if ((r = del_router_from_leaf(l, tfd)) == NULL) {
+		leaf_wrlock(l);
+		r = del_router_from_leaf(l, tfd);
+		if (r != NULL && hop == 1)
+			l->conn_fd = -1; /* reset my direct connection fd to -1 since its closing */
+		leaf_wrunlock(l);
+
+		if (r == NULL) {
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Failed to clear pbs_comm from leaf %s's list",
 						tfd, tpp_netaddr(&l->leaf_addrs[0]));
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -675,10 +967,6 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			return -1;
 		}
 
-		if (hop == 1) {
-			l->conn_fd = -1; /* reset my direct connection fd to -1 since its closing */
-		}
-
 		if (l->num_routers > 0) {
 			TPP_DBPRT(("tfd=%d, Other pbs_comms for leaf %s present", tfd, tpp_netaddr(&l->leaf_addrs[0])));
 			tpp_unlock(&router_lock);
@@ -687,9 +975,9 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 
 		TPP_DBPRT(("No more pbs_comms to leaf %s, deleting leaf", tpp_netaddr(&l->leaf_addrs[0])));
 
-		/* delete all of this leaf's addresses from the search tree */
+		/* delete all of this leaf's addresses from the leaf index */
 		for (i = 0; i < l->num_addrs; i++) {
-			rc = tree_add_del(AVL_cluster_leaves, &l->leaf_addrs[i], NULL, TREE_OP_DEL);
+			rc = leaf_idx_del(&l->leaf_addrs[i]);
 			if (rc != 0) {
 				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Failed to delete address %s from cluster leaves", tfd, tpp_netaddr(&l->leaf_addrs[i]));
 				tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -761,7 +1049,9 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				l = (tpp_leaf_t *) pkey->recptr;
 
 				if (l->num_routers > 0) {
+					leaf_wrlock(l);
 					del_router_from_leaf(l, tfd);
+					leaf_wrunlock(l);
 					if (l->num_routers == 0) {
 						/*
 						 * delete leaf from the leaf tree, since it
@@ -779,7 +1069,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			}
 			free(pkey);
 
-			/* now remove each of the leaf's addresses from avl_clusters */
+			/* now remove each of the leaf's addresses from the leaf index */
 			while ((n = TPP_QUE_NEXT(&deleted_leaves, n))) {
 				l = (tpp_leaf_t *) TPP_QUE_DATA(n);
 
@@ -788,7 +1078,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				}
 
 				for (i = 0; i < l->num_addrs; i++) {
-					rc = tree_add_del(AVL_cluster_leaves, &l->leaf_addrs[i], NULL, TREE_OP_DEL);
+					rc = leaf_idx_del(&l->leaf_addrs[i]);
 					if (rc != 0) {
 						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Failed to delete address %s",
 									tfd, tpp_netaddr(&l->leaf_addrs[i]));
@@ -1252,7 +1542,7 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 				/* find the leaf */
 				found = 1;
-				l = (tpp_leaf_t *) find_tree(AVL_cluster_leaves, &addrs[0]);
+				l = leaf_idx_lookup(&addrs[0]);
 				if (!l) {
 					found = 0;
 					l = (tpp_leaf_t *) calloc(1, sizeof(tpp_leaf_t));
@@ -1293,7 +1583,9 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 						tpp_unlock(&router_lock);
 						return -1;
 					}
+					leaf_wrlock(l);
 					l->conn_fd = tfd;
+					leaf_wrunlock(l);
 
 					/*
 					 * Set a context only if the JOIN came from a direct connection
@@ -1318,7 +1610,9 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 				 * router is not part of leaf's list
 				 * of routers already, so add
 				 */
+				leaf_wrlock(l);
 				i = add_route_to_leaf(l, r, index);
+				leaf_wrunlock(l);
 				if (i == -1) {
 					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Leaf %s exists!", tfd, tpp_netaddr(&l->leaf_addrs[0]));
 					tpp_log_func(LOG_CRIT, NULL, tpp_get_logbuf());
@@ -1336,12 +1630,12 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 				if (found == 0) {
 					int fatal = 0;
-					/* add each address to the AVL_cluster_leaves tree
+					/* add each address to the leaf index
 					 * since this is the primary "routing table"
 					 */
 					for (i = 0; i < l->num_addrs; i++) {
-						if (tree_add_del(AVL_cluster_leaves, &l->leaf_addrs[i], l, TREE_OP_ADD) != 0) {
-							if (find_tree(AVL_cluster_leaves, &l->leaf_addrs[i])) {
+						if (leaf_idx_add(&l->leaf_addrs[i], l) != 0) {
+							if (leaf_idx_lookup(&l->leaf_addrs[i])) {
 								int k;
 								sprintf(tpp_get_logbuf(), "tfd=%d, Failed to add address %s to cluster-leaves tree "
 										"since address already exists, dropping duplicate",
@@ -1451,7 +1745,7 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 				tpp_lock(&router_lock);
 
 				/* find the leaf context to pass to close handler */
-				l = find_tree(AVL_cluster_leaves, src_addr);
+				l = leaf_idx_lookup(src_addr);
 				if (!l) {
 					TPP_DBPRT(("No leaf %s found", tpp_netaddr(src_addr)));
 					tpp_unlock(&router_lock);
@@ -1477,7 +1771,6 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 		break; /* TPP_CTL_LEAVE */
 
 		case TPP_MCAST_DATA: {
-			tpp_leaf_t *l;
 			int i, k;
 			unsigned int src_sd;
 			tpp_addr_t *src_host, *dest_host;
@@ -1500,6 +1793,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 			unsigned int info_len = ntohl(mhdr->info_len);
 			tpp_chunk_t mchunks[1];
 			int already_sent;
+			tpp_packet_t *mpkt = NULL; /* whole mcast packet, shared by the routers sent to */
+			tpp_packet_t *ppkt = NULL; /* payload, shared by the local leaves sent to */
 
 			if (cmprsd_len > 0) {
 				payload_len = len - sizeof(tpp_mcast_pkt_hdr_t) - cmprsd_len;
@@ -1529,15 +1824,14 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 			chunks[1].data = payload;
 			chunks[1].len = payload_len;
 
-#ifdef PBS_COMPRESSION_ENABLED
+			/* the lz codec is built in, so this works without zlib too */
 			if (cmprsd_len > 0) {
-				minfo_base = tpp_inflate(info_start, cmprsd_len, info_len);
+				minfo_base = tpp_uncompress(info_start, cmprsd_len, info_len);
 				if (minfo_base == NULL) {
 					tpp_log_func(LOG_CRIT, __func__, "Decompression of mcast hdr failed");
 					return -1;
 				}
 			}
-#endif
 
 			mhdr->hop = 1; /* set hop=1 to forward, use orig_hop for checking */
 			mchunks[0].data = data;
@@ -1556,21 +1850,15 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 				TPP_DBPRT(("MCAST data on fd=%d", src_sd));
 
-				tpp_lock(&router_lock);
-				l = find_tree(AVL_cluster_leaves, dest_host);
-				if (l == NULL) {
+				/* find a router that is still connected */
+				if (route_to_leaf(dest_host, &target_router, &target_fd) != 0) {
 					char msg[TPP_LOGBUF_SZ];
-					tpp_unlock(&router_lock);
 					snprintf(msg, TPP_LOGBUF_SZ, "pbs_comm:%s: Dest not found at pbs_comm", tpp_netaddr(&this_router->router_addr));
 					log_noroute(src_host, dest_host, src_sd, msg);
 					tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
 					continue;
 				}
 
-				/* find a router that is still connected */
-				target_router = get_preferred_router(l, this_router, &target_fd);
-				tpp_unlock(&router_lock);
-
 				if (target_router == NULL) {
 					char msg[TPP_LOGBUF_SZ];
 					snprintf(msg, TPP_LOGBUF_SZ, "pbs_comm:%s: No target pbs_comm found", tpp_netaddr(&this_router->router_addr));
@@ -1591,13 +1879,17 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 					TPP_DBPRT(("Send mcast indiv packet to %s", tpp_netaddr(&shdr.dest_addr)));
 
-					if (tpp_transport_vsend(target_fd, chunks, 2) != 0) {
+					if (ppkt == NULL)
+						ppkt = tpp_transport_cr_pkt(&chunks[1], 1);
+					if (ppkt == NULL || tpp_transport_vsend_shared(target_fd, chunks, 1, ppkt) != 0) {
 						tpp_log_func(LOG_ERR, __func__, "Failed to send mcast indiv pkt");
 						tpp_transport_close(target_fd);
 						if (rlist)
 							free(rlist);
 						if (cmprsd_len > 0)
 							free(minfo_base);
+						tpp_free_pkt(ppkt);
+						tpp_free_pkt(mpkt);
 						return 0;
 					}
 				} else if (orig_hop == 0) {
@@ -1609,6 +1901,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 						if (!rlist) {
 							if (cmprsd_len > 0)
 								free(minfo_base);
+							tpp_free_pkt(ppkt);
+							tpp_free_pkt(mpkt);
 							snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating pbs_comm list of %lu bytes",
 								sizeof(int) * rsize);
 							tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -1640,6 +1934,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 							free(rlist);
 							if (cmprsd_len > 0)
 								free(minfo_base);
+							tpp_free_pkt(ppkt);
+							tpp_free_pkt(mpkt);
 							snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory resizing pbs_comm list to %lu bytes",
 								sizeof(int) * rsize);
 							tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -1649,7 +1945,9 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 						rlist = tmp;
 					}
 					TPP_DBPRT(("Forwarding MCAST to %s", target_router->router_name));
-					if (tpp_transport_vsend(target_fd, mchunks, 1) != 0) {
+					if (mpkt == NULL)
+						mpkt = tpp_transport_cr_pkt(mchunks, 1);
+					if (mpkt == NULL || tpp_transport_vsend_shared(target_fd, NULL, 0, mpkt) != 0) {
 						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "send failed: errno = %d", errno);
 						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
 
@@ -1666,6 +1964,10 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 			if (rlist)
 				free(rlist);
 
+			/* drop our references, the queued packets keep the data alive */
+			tpp_free_pkt(ppkt);
+			tpp_free_pkt(mpkt);
+
 			tpp_log_func(LOG_INFO, NULL, "mcast done");
 
 			return 0;
@@ -1674,7 +1976,6 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 		case TPP_DATA:
 		case TPP_CLOSE_STRM: {
-			tpp_leaf_t *l;
 			tpp_addr_t *src_host, *dest_host;
 			unsigned int src_sd;
 			tpp_data_pkt_hdr_t *dhdr = (tpp_data_pkt_hdr_t *) data;
@@ -1683,12 +1984,9 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 			dest_host = &dhdr->dest_addr;
 			src_sd = ntohl(dhdr->src_sd);
 
-			tpp_lock(&router_lock);
-
-			l = find_tree(AVL_cluster_leaves, dest_host);
-			if (l == NULL) {
+			/* find a router that is still connected */
+			if (route_to_leaf(dest_host, &target_router, &target_fd) != 0) {
 				char msg[TPP_LOGBUF_SZ];
-				tpp_unlock(&router_lock);
 
 				snprintf(msg, TPP_LOGBUF_SZ, "tfd=%d, pbs_comm:%s: Dest not found", tfd, tpp_netaddr(&this_router->router_addr));
 				log_noroute(src_host, dest_host, src_sd, msg);
@@ -1696,10 +1994,6 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 				return 0;
 			}
 
-			/* find a router that is still connected */
-			target_router = get_preferred_router(l, this_router, &target_fd);
-
-			tpp_unlock(&router_lock);
 			if (target_router == NULL) {
 				char msg[TPP_LOGBUF_SZ];
 				snprintf(msg, TPP_LOGBUF_SZ, "tfd=%d, pbs_comm:%s: No target pbs_comm found", tfd, tpp_netaddr(&this_router->router_addr));
@@ -1732,7 +2026,6 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 		case TPP_CTL_MSG: {
 			tpp_ctl_pkt_hdr_t *ehdr = (tpp_ctl_pkt_hdr_t *) data;
-			tpp_leaf_t *l;
 			int subtype = ehdr->code;
 
 			if (subtype == TPP_MSG_NOROUTE) {
@@ -1746,17 +2039,9 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 				tpp_log_func(LOG_WARNING, __func__, tpp_get_logbuf());
 
 				/* find the fd to forward to via the associated router */
-				tpp_lock(&router_lock);
-
-				l = find_tree(AVL_cluster_leaves, dest_host);
-				if (l == NULL) {
-					tpp_unlock(&router_lock);
+				if (route_to_leaf(dest_host, &target_router, &target_fd) != 0)
 					return 0;
-				}
-				/* find a router that is still connected */
-				target_router = get_preferred_router(l, this_router, &target_fd);
 
-				tpp_unlock(&router_lock);
 				if (target_router == NULL) {
 					snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, No connections to send TPP_CTL_NOROUTE", tfd);
 					tpp_log_func(LOG_WARNING, NULL, tpp_get_logbuf());
@@ -1873,8 +2158,11 @@ del_router_from_leaf(tpp_leaf_t *l, int tfd)
 			r = l->r[i];
 			l->r[i] = NULL;
 			l->num_routers--;
-			if (l->num_routers == 0)
+			if (l->num_routers == 0) {
 				free(l->r);
+				l->r = NULL;
+				l->tot_routers = 0;
+			}
 			TPP_DBPRT(("pbs_comm count for leaf=%s is %d", tpp_netaddr(&l->leaf_addrs[0]), l->num_routers));
 			return r;
 		}
@@ -2023,9 +2311,8 @@ tpp_init_router(struct tpp_config *cnf)
 		return -1;
 	}
 
-	AVL_cluster_leaves = create_tree(AVL_NO_DUP_KEYS, sizeof(tpp_addr_t));
-	if (AVL_cluster_leaves == NULL) {
-		tpp_log_func(LOG_CRIT, __func__, "Failed to create AVL tree for cluster leaves");
+	if (leaf_idx_init() != 0) {
+		tpp_log_func(LOG_CRIT, __func__, "Failed to create index of cluster leaves");
 		return -1;
 	}
 
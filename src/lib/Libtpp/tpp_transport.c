@@ -80,6 +80,9 @@
 #define TPP_CONN_CONNECTING     3 /* Channel is connecting */
 #define TPP_CONN_CONNECTED      4 /* Channel is connected */
 
+#define TPP_COALESCE_IOV	64	/* max packets gathered into one write */
+#define TPP_COALESCE_MAX	65536	/* bytes after which a write is not held back */
+
 int tpp_going_down = 0;
 
 /*
@@ -144,6 +147,8 @@ typedef struct {
 	void *em_context;         /* the em context */
 	tpp_que_t lazy_conn_que;  /* The delayed connection queue on this thread */
 	tpp_que_t close_conn_que;  /* The closed connection queue on this thread */
+	tpp_que_t flush_conn_que;  /* tfds of connections with unwritten sends */
+	long long flush_time;	/* when to write the unwritten sends, 0 if none */
 	tpp_mbox_t mbox;     /* message box for this thread */
 	tpp_tls_t *tpp_tls;	/* tls data related to tpp work */
 } thrd_data_t;
@@ -182,6 +187,7 @@ typedef struct {
 	int lasterr;             /* last error that was captured on this socket */
 	short net_state;         /* network status of this connection, up, down etc */
 	int can_send;            /* can we send data in this fd now, or would it block? */
+	int flush_pending;       /* on its thread's flush queue */
 
 	conn_param_t *conn_params; /* the connection params */
 
@@ -210,6 +216,8 @@ static void assign_to_worker(int tfd, int delay, thrd_data_t *td);
 static void handle_disconnect(phy_conn_t *conn);
 static void handle_incoming_data(phy_conn_t *conn);
 static void send_data(phy_conn_t *conn);
+static void queue_flush(thrd_data_t *td, phy_conn_t *conn);
+static void flush_conns(thrd_data_t *td);
 static void free_phy_conn(phy_conn_t *conn);
 static void handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data);
 static int add_pkts(phy_conn_t *conn);
@@ -564,6 +572,7 @@ tpp_transport_init(struct tpp_config *conf)
 		thrd_pool[i]->listen_fd = -1;
 		TPP_QUE_CLEAR(&thrd_pool[i]->lazy_conn_que);
 		TPP_QUE_CLEAR(&thrd_pool[i]->close_conn_que);
+		TPP_QUE_CLEAR(&thrd_pool[i]->flush_conn_que);
 
 		if ((thrd_pool[i]->em_context = tpp_em_init(max_con)) == NULL) {
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "em_init() error, errno=%d", errno);
@@ -1155,6 +1164,122 @@ tpp_transport_vsend(int tfd, tpp_chunk_t *chunk, int count)
 	return (tpp_transport_vsend_extra(tfd, chunk, count, NULL));
 }
 
+/**
+ * @brief
+ *	Create a packet holding the concatenation of a set of data buffers,
+ *	without the length header, to be handed to tpp_transport_vsend_shared
+ *
+ * @param[in] chunk - Array of chunks that describes each data buffer
+ * @param[in] count - Number of chunks in the array of chunks
+ *
+ * @return  The packet
+ * @retval  NULL - Failure (out of memory)
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+tpp_packet_t *
+tpp_transport_cr_pkt(tpp_chunk_t *chunk, int count)
+{
+	tpp_packet_t *pkt;
+	int i;
+	int totlen = 0;
+
+	for (i = 0; i < count; i++)
+		totlen += chunk[i].len;
+
+	pkt = tpp_cr_pkt(NULL, totlen, 1);
+	if (!pkt)
+		return NULL;
+
+	for (i = 0; i < count; i++) {
+		memcpy(pkt->pos, chunk[i].data, chunk[i].len);
+		pkt->pos = pkt->pos + chunk[i].len;
+	}
+	pkt->pos = pkt->data;
+
+	return pkt;
+}
+
+/**
+ * @brief
+ *	Queue data to be sent out by the IO thread, where the data is a set
+ *	of data buffers followed by a payload packet that may be sent to
+ *	several connections.
+ *
+ * @par Functionality
+ *	The chunks are copied, but the payload is not. Instead a packet
+ *	borrowing the payload's data is queued right behind them, so that
+ *	a payload fanned out to many connections lives in memory only once.
+ *	Small payloads are cheaper to copy than to send separately, so
+ *	those are copied along with the chunks.
+ *
+ * @param[in] tfd     - The file descriptor of the connection
+ * @param[in] chunk   - Array of chunks that describes each data buffer
+ * @param[in] count   - Number of chunks in the array of chunks
+ * @param[in] payload - Packet (from tpp_transport_cr_pkt) to send after the
+ *			chunks. The caller keeps its reference.
+ *
+ * @return  Error code
+ * @retval  -1 - Failure
+ * @retval   0 - Success
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+int
+tpp_transport_vsend_shared(int tfd, tpp_chunk_t *chunk, int count, tpp_packet_t *payload)
+{
+	tpp_packet_t *pkt;
+	int i;
+	int ntotlen;
+	int hdrlen = 0;
+	int totlen;
+
+	errno = 0;
+
+	for (i = 0; i < count; i++)
+		hdrlen += chunk[i].len;
+	totlen = hdrlen + payload->len;
+
+	if (payload->len < TPP_SHARE_MIN)
+		pkt = tpp_cr_pkt(NULL, totlen + sizeof(int), 1);
+	else
+		pkt = tpp_cr_pkt(NULL, hdrlen + sizeof(int), 1);
+	if (!pkt)
+		return -1;
+
+	ntotlen = htonl(totlen);
+	memcpy(pkt->pos, &ntotlen, sizeof(int));
+	pkt->pos = pkt->pos + sizeof(int);
+
+	for (i = 0; i < count; i++) {
+		memcpy(pkt->pos, chunk[i].data, chunk[i].len);
+		pkt->pos = pkt->pos + chunk[i].len;
+	}
+
+	if (payload->len < TPP_SHARE_MIN) {
+		memcpy(pkt->pos, payload->data, payload->len);
+	} else if ((pkt->next_frag = tpp_share_pkt(payload)) == NULL) {
+		tpp_free_pkt(pkt);
+		return -1;
+	}
+	pkt->pos = pkt->data;
+
+	/* write to worker threads send pipe */
+	if (tpp_post_cmd(tfd, TPP_CMD_SEND, (void *) pkt) != 0) {
+		tpp_free_pkt(pkt);
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * @brief
  *	Whether the underlying connection is from a reserved port or not
@@ -1427,12 +1552,16 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 			tpp_sock_close(conn->sock_fd);
 			free_phy_conn(conn);
 		}
+		while (TPP_QUE_HEAD(&td->flush_conn_que))
+			tpp_que_del_elem(&td->flush_conn_que, TPP_QUE_HEAD(&td->flush_conn_que));
 
 		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Thrd exiting, had %d connections", num_cons);
 		tpp_log_func(LOG_INFO, NULL, tpp_get_logbuf());
 
 		/* clean up any tls memory, just for valgrind's sake */
 		if ((p = tpp_get_tls())) {
+			tpp_log_pool_stats(p);
+			tpp_free_pools(p);
 			free(p->log_data);
 			free(p->avl_data);
 			free(p);
@@ -1459,6 +1588,7 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 		}
 	} else if (cmd == TPP_CMD_SEND) {
 		tpp_packet_t *pkt = (tpp_packet_t *) data;
+		tpp_packet_t *next;
 
 		if (conn == NULL || slot_state != TPP_SLOT_BUSY) {
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Phy Con %d (cmd = %d) already deleted/closing", tfd, cmd);
@@ -1466,14 +1596,26 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 			tpp_free_pkt(pkt);
 			return;
 		}
-		if (tpp_enque(&conn->send_queue, pkt) == NULL) {
-			tpp_log_func(LOG_CRIT, __func__, "Out of memory enqueing to send queue");
-			return;
+
+		/* queue each fragment of the message as a packet of its own */
+		while (pkt) {
+			next = pkt->next_frag;
+			pkt->next_frag = NULL;
+			if (tpp_enque(&conn->send_queue, pkt) == NULL) {
+				tpp_log_func(LOG_CRIT, __func__, "Out of memory enqueing to send queue");
+				/* a partly queued message would corrupt the stream */
+				if (pkt != data)
+					handle_disconnect(conn);
+				tpp_free_pkt(pkt);
+				tpp_free_pkt(next);
+				return;
+			}
+			conn->send_queue_size += pkt->len;
+			pkt = next;
 		}
-		conn->send_queue_size += pkt->len;
 
-		/* handle socket add calls */
-		send_data(conn);
+		/* write it out along with whatever else gets queued meanwhile */
+		queue_flush(td, conn);
 	}
 }
 
@@ -1605,6 +1747,9 @@ work(void *v)
 		while (1) {
 			now = time(0);
 
+			/* write out sends that were held back for coalescing */
+			flush_conns(td);
+
 			/* trigger all delayed connects, and return the wait time till the next one to trigger */
 			timeout = trigger_lazy_connects(td, now);
 			if (the_timer_handler) {
@@ -1622,6 +1767,15 @@ work(void *v)
 				timeout = timeout * 1000; /* milliseconds */
 			}
 
+			if (td->flush_time != 0) {
+				long long wait = td->flush_time - tpp_time_ms();
+
+				if (wait < 0)
+					wait = 0;
+				if (timeout == -1 || wait < timeout)
+					timeout = (int) wait;
+			}
+
 			errno = 0;
 			nfds = tpp_em_wait(td->em_context, &events, timeout);
 			if (nfds <= 0) {
@@ -1820,7 +1974,7 @@ handle_disconnect(phy_conn_t *conn)
 	int cmd;
 	void *data;
 	pbs_socklen_t len = sizeof(error);
-	tpp_que_elem_t *n;
+	tpp_cmd_t *n;
 
 	if (conn == NULL || conn->net_state == TPP_CONN_DISCONNECTED)
 		return;
@@ -2053,12 +2207,15 @@ add_pkts(phy_conn_t *conn)
 	return rc;
 }
 
+#ifdef NAS /* localmod 149 */
 /**
  * @brief
- *	Loop over the list of queued data and send out packet by packet
- *	Stop if sending would block.
+ *	Account a write to a connection in the tpp instrumentation statistics,
+ *	and log them when their period is over
  *
  * @param[in] conn - The physical connection
+ * @param[in] tosend - The number of bytes that were to be written
+ * @param[in] rc - The number of bytes that were written
  *
  * @par Side Effects:
  *	None
@@ -2067,222 +2224,256 @@ add_pkts(phy_conn_t *conn)
  *
  */
 static void
-send_data(phy_conn_t *conn)
+nas_instr_send(phy_conn_t *conn, int tosend, int rc)
 {
-	tpp_packet_t *p = NULL;
-	int tosend = 0;
-	int rc;
-	int can_send_more;
-	tpp_que_elem_t *n;
-#ifdef NAS /* localmod 149 */
 	time_t curr;
 	int rc_iflag;
-#endif /* localmod 149 */
 
+	curr = time(0);
 
-	/*
-	 * if a socket is still connecting, we will wait to send out data,
-	 * even if app called close - so check this first
-	 */
-	if (conn->net_state == TPP_CONN_CONNECTING || conn->net_state == TPP_CONN_INITIATING)
-		return;
+	conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
+	conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
+	conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
 
-	n = TPP_QUE_HEAD(&conn->send_queue);
-	p = TPP_QUE_DATA(n);
+	if (tosend > TPP_SCRATCHSIZE) {
+		conn->td->nas_num_lrg_sends_A++;
+		conn->td->nas_lrg_send_sum_kb_A += ((double) tosend) / 1024.0;
 
-	if (conn->can_send == 0)
-		return;
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_A++;
+		}
 
-	can_send_more = 1;
+		if (tosend > conn->td->nas_max_bytes_lrg_send_A) {
+			conn->td->nas_max_bytes_lrg_send_A = tosend;
+		}
 
-	while (p && can_send_more) {
-		tosend = p->len - (p->pos - p->data);
-		if (p->pos == p->data) {
-			if (the_pkt_presend_handler) {
-				if (the_pkt_presend_handler(conn->sock_fd, p) != 0) {
-					/* handler asked not to send data, skip packet */
-					conn->send_queue_size -= tosend;
-					n = tpp_que_del_elem(&conn->send_queue, n);
-					n = TPP_QUE_HEAD(&conn->send_queue);
-					p = TPP_QUE_DATA(n);
-					continue;
-				}
-			}
+		if (tosend < conn->td->nas_min_bytes_lrg_send_A) {
+			conn->td->nas_min_bytes_lrg_send_A = tosend;
 		}
 
-		while (tosend > 0) {
-			rc = tpp_sock_send(conn->sock_fd, p->pos, tosend, 0);
-#ifdef NAS /* localmod 149 */
-			if (rc > 0) {
-				curr = time(0);
 
-				conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
 
-				if (tosend > TPP_SCRATCHSIZE) {
-					conn->td->nas_num_lrg_sends_A++;
-					conn->td->nas_lrg_send_sum_kb_A += ((double) tosend) / 1024.0;
+		conn->td->nas_num_lrg_sends_B++;
+		conn->td->nas_lrg_send_sum_kb_B += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_A++;
-					}
-
-					if (tosend > conn->td->nas_max_bytes_lrg_send_A) {
-						conn->td->nas_max_bytes_lrg_send_A = tosend;
-					}
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_B++;
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_A) {
-						conn->td->nas_min_bytes_lrg_send_A = tosend;
-					}
+		if (tosend > conn->td->nas_max_bytes_lrg_send_B) {
+			conn->td->nas_max_bytes_lrg_send_B = tosend;
+		}
 
+		if (tosend < conn->td->nas_min_bytes_lrg_send_B) {
+			conn->td->nas_min_bytes_lrg_send_B = tosend;
+		}
 
 
-					conn->td->nas_num_lrg_sends_B++;
-					conn->td->nas_lrg_send_sum_kb_B += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_B++;
-					}
+		conn->td->nas_num_lrg_sends_C++;
+		conn->td->nas_lrg_send_sum_kb_C += ((double) tosend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_B) {
-						conn->td->nas_max_bytes_lrg_send_B = tosend;
-					}
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_C++;
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_B) {
-						conn->td->nas_min_bytes_lrg_send_B = tosend;
-					}
+		if (tosend > conn->td->nas_max_bytes_lrg_send_C) {
+			conn->td->nas_max_bytes_lrg_send_C = tosend;
+		}
 
+		if (tosend < conn->td->nas_min_bytes_lrg_send_C) {
+			conn->td->nas_min_bytes_lrg_send_C = tosend;
+		}
+	}
 
+	if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
+		rc_iflag = access(tpp_instr_flag_file, F_OK);
+		if (rc_iflag != 0) {
+			conn->td->nas_tpp_log_enabled = 0;
+		} else {
+			conn->td->nas_tpp_log_enabled = 1;
+		}
 
-					conn->td->nas_num_lrg_sends_C++;
-					conn->td->nas_lrg_send_sum_kb_C += ((double) tosend) / 1024.0;
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				 conn->td->NAS_TPP_LOG_PERIOD_A,
+				 (int) (curr - conn->td->nas_last_time_A),
+				 conn->td->nas_kb_sent_A / 1024.0,
+				 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
+				 TPP_SCRATCHSIZE,
+				 conn->td->nas_num_lrg_sends_A,
+				 conn->td->nas_num_qual_lrg_sends_A,
+				 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
+				 conn->td->nas_max_bytes_lrg_send_A,
+				 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_C++;
-					}
+		conn->td->nas_last_time_A = curr;
+		conn->td->nas_kb_sent_A = 0.0;
+		conn->td->nas_num_lrg_sends_A = 0;
+		conn->td->nas_num_qual_lrg_sends_A = 0;
+		conn->td->nas_max_bytes_lrg_send_A = 0;
+		conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_A = 0.0;
+	}
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_C) {
-						conn->td->nas_max_bytes_lrg_send_C = tosend;
-					}
+	if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				 conn->td->NAS_TPP_LOG_PERIOD_B,
+				 (int) (curr - conn->td->nas_last_time_B),
+				 conn->td->nas_kb_sent_B / 1024.0,
+				 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
+				 TPP_SCRATCHSIZE,
+				 conn->td->nas_num_lrg_sends_B,
+				 conn->td->nas_num_qual_lrg_sends_B,
+				 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
+				 conn->td->nas_max_bytes_lrg_send_B,
+				 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_C) {
-						conn->td->nas_min_bytes_lrg_send_C = tosend;
-					}
-				}
+		conn->td->nas_last_time_B = curr;
+		conn->td->nas_kb_sent_B = 0.0;
+		conn->td->nas_num_lrg_sends_B = 0;
+		conn->td->nas_num_qual_lrg_sends_B = 0;
+		conn->td->nas_max_bytes_lrg_send_B = 0;
+		conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_B = 0.0;
+	}
 
-				if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
-					rc_iflag = access(tpp_instr_flag_file, F_OK);
-					if (rc_iflag != 0) {
-						conn->td->nas_tpp_log_enabled = 0;
-					} else {
-						conn->td->nas_tpp_log_enabled = 1;
-					}
+	if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				conn->td->NAS_TPP_LOG_PERIOD_C,
+				(int) (curr - conn->td->nas_last_time_C),
+				conn->td->nas_kb_sent_C / 1024.0,
+				(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
+				curr - conn->td->nas_last_time_C)) / 60.0),
+				TPP_SCRATCHSIZE,
+				conn->td->nas_num_lrg_sends_C,
+				conn->td->nas_num_qual_lrg_sends_C,
+				conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
+				conn->td->nas_max_bytes_lrg_send_C,
+				conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_A,
-							 (int) (curr - conn->td->nas_last_time_A),
-							 conn->td->nas_kb_sent_A / 1024.0,
-							 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_A,
-							 conn->td->nas_num_qual_lrg_sends_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
-							 conn->td->nas_max_bytes_lrg_send_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+		conn->td->nas_last_time_C = curr;
+		conn->td->nas_kb_sent_C = 0.0;
+		conn->td->nas_num_lrg_sends_C = 0;
+		conn->td->nas_num_qual_lrg_sends_C = 0;
+		conn->td->nas_max_bytes_lrg_send_C = 0;
+		conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_C = 0.0;
+	}
+}
+#endif /* localmod 149 */
 
-					conn->td->nas_last_time_A = curr;
-					conn->td->nas_kb_sent_A = 0.0;
-					conn->td->nas_num_lrg_sends_A = 0;
-					conn->td->nas_num_qual_lrg_sends_A = 0;
-					conn->td->nas_max_bytes_lrg_send_A = 0;
-					conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_A = 0.0;
-				}
+/**
+ * @brief
+ *	Loop over the list of queued data and send it out. Packets at the head
+ *	of the queue are gathered into a single write, so that a burst of
+ *	small packets costs one system call. Stop if sending would block.
+ *
+ * @param[in] conn - The physical connection
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+send_data(phy_conn_t *conn)
+{
+	tpp_iovec_t iov[TPP_COALESCE_IOV];
+	tpp_packet_t *p = NULL;
+	tpp_que_elem_t *n;
+	int niov;
+	int tosend;
+	int len;
+	int rc;
 
-				if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_B,
-							 (int) (curr - conn->td->nas_last_time_B),
-							 conn->td->nas_kb_sent_B / 1024.0,
-							 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_B,
-							 conn->td->nas_num_qual_lrg_sends_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
-							 conn->td->nas_max_bytes_lrg_send_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+	/*
+	 * if a socket is still connecting, we will wait to send out data,
+	 * even if app called close - so check this first
+	 */
+	if (conn->net_state == TPP_CONN_CONNECTING || conn->net_state == TPP_CONN_INITIATING)
+		return;
 
-					conn->td->nas_last_time_B = curr;
-					conn->td->nas_kb_sent_B = 0.0;
-					conn->td->nas_num_lrg_sends_B = 0;
-					conn->td->nas_num_qual_lrg_sends_B = 0;
-					conn->td->nas_max_bytes_lrg_send_B = 0;
-					conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_B = 0.0;
-				}
+	if (conn->can_send == 0)
+		return;
 
-				if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							conn->td->NAS_TPP_LOG_PERIOD_C,
-							(int) (curr - conn->td->nas_last_time_C),
-							conn->td->nas_kb_sent_C / 1024.0,
-							(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
-							curr - conn->td->nas_last_time_C)) / 60.0),
-							TPP_SCRATCHSIZE,
-							conn->td->nas_num_lrg_sends_C,
-							conn->td->nas_num_qual_lrg_sends_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
-							conn->td->nas_max_bytes_lrg_send_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+	for (;;) {
+		niov = 0;
+		tosend = 0;
+		n = NULL;
+		while (niov < TPP_COALESCE_IOV && tosend < TPP_COALESCE_MAX &&
+			(n = TPP_QUE_NEXT(&conn->send_queue, n))) {
+			p = TPP_QUE_DATA(n);
+			if (p->pos == p->data) {
+				if (the_pkt_presend_handler) {
+					if (the_pkt_presend_handler(conn->sock_fd, p) != 0) {
+						/* handler asked not to send data, skip packet */
+						conn->send_queue_size -= p->len;
+						n = tpp_que_del_elem(&conn->send_queue, n);
+						continue;
 					}
-
-					conn->td->nas_last_time_C = curr;
-					conn->td->nas_kb_sent_C = 0.0;
-					conn->td->nas_num_lrg_sends_C = 0;
-					conn->td->nas_num_qual_lrg_sends_C = 0;
-					conn->td->nas_max_bytes_lrg_send_C = 0;
-					conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_C = 0.0;
 				}
 			}
-#endif /* localmod 149 */
+			len = p->len - (p->pos - p->data);
+			iov[niov].iov_base = p->pos;
+			iov[niov].iov_len = len;
+			niov++;
+			tosend += len;
+		}
 
-			if (rc < 0) {
-				if (errno == EWOULDBLOCK || errno == EAGAIN) {
-					/* set this socket in POLLOUT */
-					if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
-						EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
-						tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
-						exit(1);
-					}
+		if (niov == 0)
+			return;
 
-					/* set to cannot send data any more */
-					conn->can_send = 0;
-				} else {
-					handle_disconnect(conn);
-					return;
+		rc = tpp_sock_sendv(conn->sock_fd, iov, niov);
+		if (rc < 0) {
+			if (errno == EWOULDBLOCK || errno == EAGAIN) {
+				/* set this socket in POLLOUT */
+				if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
+					EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
+					tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
+					exit(1);
 				}
-				can_send_more = 0;
-				break;
+
+				/* set to cannot send data any more */
+				conn->can_send = 0;
+			} else {
+				handle_disconnect(conn);
 			}
-			TPP_DBPRT(("tfd=%d, sending out %d bytes", conn->sock_fd, rc));
-			p->pos += rc;
-			tosend -= rc;
+			return;
 		}
+#ifdef NAS /* localmod 149 */
+		if (rc > 0)
+			nas_instr_send(conn, tosend, rc);
+#endif /* localmod 149 */
+		TPP_DBPRT(("tfd=%d, sending out %d bytes", conn->sock_fd, rc));
 
-		if (tosend == 0) {
+		/*
+		 * all data in the packets fully written has been sent or done
+		 * with, so delete their nodes. The next write continues from
+		 * where this one stopped.
+		 */
+		while (rc > 0) {
+			n = TPP_QUE_HEAD(&conn->send_queue);
+			p = TPP_QUE_DATA(n);
+			len = p->len - (p->pos - p->data);
+			if (rc < len) {
+				p->pos += rc;
+				break;
+			}
+			rc -= len;
+			p->pos += len;
 			conn->send_queue_size -= p->len;
 
 			if (the_pkt_postsend_handler)
@@ -2290,16 +2481,96 @@ send_data(phy_conn_t *conn)
 			else {
 				tpp_free_pkt(p);
 			}
+			tpp_que_del_elem(&conn->send_queue, n);
+		}
+	}
+}
 
-			/*
-			 * all data in this packet has been sent or done with.
-			 * delete this node and get next node in queue
-			 */
-			n = tpp_que_del_elem(&conn->send_queue, n);
-			n = TPP_QUE_HEAD(&conn->send_queue);
-			p = TPP_QUE_DATA(n);
+/**
+ * @brief
+ *	Put a connection that has new data to send on its thread's flush
+ *	queue, instead of writing the data out right away.
+ *
+ * @par Functionality
+ *	The IO thread writes out the flush queue each time around its event
+ *	loop, after handling all the commands posted to it so far, so that
+ *	the packets queued by a burst of sends go out in a single write. If
+ *	the coalesce window (PBS_COMM_COALESCE_MS) is set, the data is held
+ *	back for up to that long, so that more packets can join it.
+ *
+ * @param[in] td - The thread data of the calling IO thread
+ * @param[in] conn - The physical connection
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+queue_flush(thrd_data_t *td, phy_conn_t *conn)
+{
+	if (conn->flush_pending)
+		return;
+
+	/* remember the tfd, since the connection could be freed meanwhile */
+	if (tpp_enque(&td->flush_conn_que, (void *)(long) conn->sock_fd) == NULL) {
+		send_data(conn);
+		return;
+	}
+	conn->flush_pending = 1;
+
+	if (td->flush_time == 0)
+		td->flush_time = tpp_time_ms() + tpp_conf->coalesce_ms;
+}
+
+/**
+ * @brief
+ *	Write out the data of the connections on the thread's flush queue.
+ *	Before the coalesce window is over, only connections that have
+ *	gathered enough data to fill a write are written out.
+ *
+ * @param[in] td - The thread data of the calling IO thread
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+flush_conns(thrd_data_t *td)
+{
+	tpp_que_elem_t *n = NULL;
+	phy_conn_t *conn;
+	int slot_state;
+	int tfd;
+	long long flush_time = td->flush_time;
+	int hold;
+
+	if (flush_time == 0)
+		return;
+
+	hold = (tpp_time_ms() < flush_time);
+	td->flush_time = 0;
+
+	while ((n = TPP_QUE_NEXT(&td->flush_conn_que, n))) {
+		tfd = (int)(long) TPP_QUE_DATA(n);
+		conn = get_transport_atomic(tfd, &slot_state);
+		if (conn == NULL || slot_state != TPP_SLOT_BUSY || conn->td != td) {
+			n = tpp_que_del_elem(&td->flush_conn_que, n);
+			continue;
 		}
+		if (hold && conn->send_queue_size < TPP_COALESCE_MAX)
+			continue;
+
+		n = tpp_que_del_elem(&td->flush_conn_que, n);
+		conn->flush_pending = 0;
+		send_data(conn);
 	}
+
+	if (TPP_QUE_HEAD(&td->flush_conn_que))
+		td->flush_time = flush_time;
 }
 
 /**
@@ -2427,6 +2698,7 @@ tpp_transport_terminate()
 #endif
 		tpp_em_destroy(thrd_pool[i]->em_context);
 		if (thrd_pool[i]->tpp_tls) {
+			tpp_free_pools(thrd_pool[i]->tpp_tls);
 			free(thrd_pool[i]->tpp_tls->log_data);
 			free(thrd_pool[i]->tpp_tls->avl_data);
 		}
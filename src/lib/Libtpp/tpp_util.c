@@ -84,6 +84,7 @@ int tpp_dbprt = 1; /* controls debug printing */
 /* TLS data for each TPP thread */
 static pthread_key_t tpp_key_tls;
 static pthread_once_t tpp_once_ctrl = PTHREAD_ONCE_INIT; /* once ctrl to initialize tls key */
+static int tpp_tls_key_ready = 0; /* set once tpp_key_tls is created */
 
 long tpp_log_event_mask = 0;
 
@@ -100,6 +101,147 @@ struct cache_rec {
 
 void (*tpp_log_func)(int level, const char *id, char *mess) = NULL;
 
+/**
+ * @brief
+ *	Get the calling thread's TLS area for pool use, without creating the
+ *	TLS key (queues may be used before the tpp layer is initialized)
+ *
+ * @return	TLS area of the calling thread
+ * @retval	NULL - TLS not yet available, use plain malloc/free
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static tpp_tls_t *
+tpp_get_pool_tls(void)
+{
+	if (!tpp_tls_key_ready)
+		return NULL;
+	return tpp_get_tls();
+}
+
+/**
+ * @brief
+ *	Get a fixed size object from a thread's pool, falling back to malloc
+ *	if the pool is empty (or there is no pool)
+ *
+ * @param[in] - pool - The pool to take the object from (may be NULL)
+ * @param[in] - size - Size of the object
+ *
+ * @return Address of the object
+ * @retval NULL - Failure (Out of memory)
+ *
+ * @par MT-safe: Yes (pools are per thread)
+ *
+ */
+static void *
+tpp_pool_get(tpp_pool_t *pool, size_t size)
+{
+	void *obj;
+
+	if (pool == NULL)
+		return malloc(size);
+
+	pool->allocs++;
+	if ((obj = pool->free_list) != NULL) {
+		pool->free_list = *(void **) obj;
+		pool->count--;
+		pool->hits++;
+		return obj;
+	}
+	return malloc(size);
+}
+
+/**
+ * @brief
+ *	Return a fixed size object to a thread's pool, or free it if the
+ *	pool is full (or there is no pool)
+ *
+ * @param[in] - pool - The pool to return the object to (may be NULL)
+ * @param[in] - obj  - The object
+ *
+ * @par MT-safe: Yes (pools are per thread)
+ *
+ */
+static void
+tpp_pool_put(tpp_pool_t *pool, void *obj)
+{
+	if (pool == NULL) {
+		free(obj);
+		return;
+	}
+
+	pool->frees++;
+	if (pool->count >= TPP_POOL_MAX) {
+		free(obj);
+		return;
+	}
+	*(void **) obj = pool->free_list;
+	pool->free_list = obj;
+	pool->count++;
+}
+
+/**
+ * @brief
+ *	Release all objects cached in a pool
+ *
+ * @param[in] - pool - The pool
+ *
+ */
+static void
+tpp_pool_drain(tpp_pool_t *pool)
+{
+	void *obj;
+
+	while ((obj = pool->free_list) != NULL) {
+		pool->free_list = *(void **) obj;
+		free(obj);
+	}
+	pool->count = 0;
+}
+
+/**
+ * @brief
+ *	Release the objects cached in the pools of a thread's TLS area
+ *
+ * @param[in] - ptr - The TLS area of the thread
+ *
+ * @par MT-safe: No (must be called by the owning thread, or after fork)
+ *
+ */
+void
+tpp_free_pools(tpp_tls_t *ptr)
+{
+	if (ptr == NULL)
+		return;
+	tpp_pool_drain(&ptr->pkt_pool);
+	tpp_pool_drain(&ptr->que_pool);
+}
+
+/**
+ * @brief
+ *	Log the allocation statistics of the pools of a thread's TLS area,
+ *	to help size TPP_POOL_MAX
+ *
+ * @param[in] - ptr - The TLS area of the thread
+ *
+ * @par MT-safe: No (must be called by the owning thread)
+ *
+ */
+void
+tpp_log_pool_stats(tpp_tls_t *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	snprintf(ptr->tpplogbuf, TPP_LOGBUF_SZ,
+		"pkt pool: allocs=%lu hits=%lu frees=%lu cached=%d; "
+		"que pool: allocs=%lu hits=%lu frees=%lu cached=%d",
+		ptr->pkt_pool.allocs, ptr->pkt_pool.hits, ptr->pkt_pool.frees, ptr->pkt_pool.count,
+		ptr->que_pool.allocs, ptr->que_pool.hits, ptr->que_pool.frees, ptr->que_pool.count);
+	tpp_log_func(LOG_INFO, NULL, ptr->tpplogbuf);
+}
+
 /**
  * @brief
  *	Create a packet structure from the inputs provided
@@ -123,8 +265,9 @@ tpp_packet_t *
 tpp_cr_pkt(void *data, int len, int mk_data)
 {
 	tpp_packet_t *pkt;
+	tpp_tls_t *tls = tpp_get_pool_tls();
 
-	if ((pkt = malloc(sizeof(tpp_packet_t))) == NULL) {
+	if ((pkt = tpp_pool_get(tls ? &tls->pkt_pool : NULL, sizeof(tpp_packet_t))) == NULL) {
 		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating packet");
 		return NULL;
 	}
@@ -139,7 +282,7 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 		pkt->data = malloc(len);
 #endif
 		if (!pkt->data) {
-			free(pkt);
+			tpp_pool_put(tls ? &tls->pkt_pool : NULL, pkt);
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating packet data of %d bytes", len);
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 			return NULL;
@@ -151,10 +294,47 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 	pkt->extra_data = NULL;
 	pkt->len = len;
 	pkt->ref_count = 1;
+	pkt->shared = NULL;
+	pkt->next_frag = NULL;
 
 	return pkt;
 }
 
+/**
+ * @brief
+ *	Create a packet that borrows the data of another packet
+ *
+ * @par Functionality
+ *	The new packet has its own position, so it can be sent out on a
+ *	connection independently of other packets sharing the same data.
+ *	A reference is held on the lender until the new packet is freed.
+ *
+ * @param[in] - pkt - The packet whose data is to be shared
+ *
+ * @return Newly allocated packet structure
+ * @retval NULL - Failure (Out of memory)
+ * @retval !NULL - Address of allocated packet structure
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+tpp_packet_t *
+tpp_share_pkt(tpp_packet_t *pkt)
+{
+	tpp_packet_t *spkt;
+
+	if ((spkt = tpp_cr_pkt(pkt->data, pkt->len, 0)) == NULL)
+		return NULL;
+
+	tpp_atomic_add(&pkt->ref_count, 1);
+	spkt->shared = pkt;
+
+	return spkt;
+}
+
 /**
  * @brief
  *	Free a packet structure
@@ -170,16 +350,24 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 void
 tpp_free_pkt(tpp_packet_t *pkt)
 {
-	if (pkt) {
-		pkt->ref_count--;
-
-		if (pkt->ref_count <= 0) {
-			if (pkt->data)
-				free(pkt->data);
-			if (pkt->extra_data)
-				free(pkt->extra_data);
-			free(pkt);
-		}
+	tpp_tls_t *tls;
+	tpp_packet_t *next;
+
+	while (pkt) {
+		/* shared packets may be released from several threads */
+		if (tpp_atomic_add(&pkt->ref_count, -1) > 1)
+			return;
+
+		if (pkt->shared)
+			tpp_free_pkt(pkt->shared);
+		else if (pkt->data)
+			free(pkt->data);
+		if (pkt->extra_data)
+			free(pkt->extra_data);
+		next = pkt->next_frag;
+		tls = tpp_get_pool_tls();
+		tpp_pool_put(tls ? &tls->pkt_pool : NULL, pkt);
+		pkt = next;
 	}
 }
 
@@ -616,6 +804,41 @@ tpp_parse_hostname(char *full, int *port)
 	return host;
 }
 
+/**
+ * @brief
+ *	Allocate a queue element from the calling thread's pool
+ *
+ * @return	The new (uninitialized) queue element
+ * @retval	NULL - Out of memory
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static tpp_que_elem_t *
+tpp_que_elem_alloc(void)
+{
+	tpp_tls_t *tls = tpp_get_pool_tls();
+
+	return tpp_pool_get(tls ? &tls->que_pool : NULL, sizeof(tpp_que_elem_t));
+}
+
+/**
+ * @brief
+ *	Return a queue element to the calling thread's pool
+ *
+ * @param[in] - n - The queue element
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+tpp_que_elem_free(tpp_que_elem_t *n)
+{
+	tpp_tls_t *tls = tpp_get_pool_tls();
+
+	tpp_pool_put(tls ? &tls->que_pool : NULL, n);
+}
+
 /**
  * @brief
  *	Enqueue a node to a queue
@@ -646,7 +869,7 @@ tpp_enque(tpp_que_t *l, void *data)
 {
 	tpp_que_elem_t *nd;
 
-	if ((nd = malloc(sizeof(tpp_que_elem_t))) == NULL) {
+	if ((nd = tpp_que_elem_alloc()) == NULL) {
 		return NULL;
 	}
 	nd->queue_data = data;
@@ -702,7 +925,7 @@ tpp_deque(tpp_que_t *l)
 			l->head->prev = NULL;
 		else
 			l->tail = NULL;
-		free(p);
+		tpp_que_elem_free(p);
 	}
 	return data;
 }
@@ -757,7 +980,7 @@ tpp_que_del_elem(tpp_que_t *l, tpp_que_elem_t *n)
 		if (n->prev)
 			p = n->prev;
 		/* else return p as NULL, so list QUE_NEXT starts from head again */
-		free(n);
+		tpp_que_elem_free(n);
 	}
 	return p;
 }
@@ -795,7 +1018,7 @@ tpp_que_ins_elem(tpp_que_t *l, tpp_que_elem_t *n, void *data, int before)
 	tpp_que_elem_t *nd = NULL;
 
 	if (n) {
-		if ((nd = malloc(sizeof(tpp_que_elem_t))) == NULL) {
+		if ((nd = tpp_que_elem_alloc()) == NULL) {
 			return NULL;
 		}
 		nd->queue_data = data;
@@ -929,6 +1152,7 @@ tpp_init_tls_key_once()
 		fprintf(stderr, "Failed to initialize TLS key\n");
 		exit(1);
 	}
+	tpp_tls_key_ready = 1;
 }
 
 /**
@@ -1360,6 +1584,322 @@ tpp_inflate(void *inbuf, unsigned int inlen, unsigned int totlen)
 }
 #endif
 
+/*
+ * The "lz" codec, a fast LZ77 byte codec built into the library, for when
+ * zlib costs too much CPU. Its output starts with TPP_LZ_TAG, a byte that
+ * no zlib stream starts with (the low nibble of a zlib header is always 8),
+ * so that tpp_uncompress can tell the codecs apart.
+ *
+ * The tag is followed by sequences of a token byte, whose high nibble is
+ * the number of literals and low nibble the match length - TPP_LZ_MINMATCH
+ * (15 in either meaning more length bytes follow, each added, until one is
+ * not 255), the literals, and a 2 byte little endian match offset. The
+ * last sequence has only literals.
+ */
+#define TPP_LZ_TAG		0x4c
+#define TPP_LZ_MINMATCH		4
+#define TPP_LZ_LASTLITERALS	5	/* input tail always sent as literals */
+#define TPP_LZ_MAX_OFFSET	65535
+#define TPP_LZ_HASH_BITS	12
+
+static unsigned int
+tpp_lz_read32(const unsigned char *p)
+{
+	unsigned int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned char *
+tpp_lz_put_len(unsigned char *op, unsigned int len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char) len;
+	return op;
+}
+
+/**
+ * @brief Compress data with the lz codec
+ *
+ * @param[in] inbuf   - Ptr to buffer to compress
+ * @param[in] inlen   - The size of input buffer
+ * @param[out] outlen - The size of the compressed data
+ *
+ * @return      - Ptr to the compressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+static void *
+tpp_lz_compress(void *inbuf, unsigned int inlen, unsigned int *outlen)
+{
+	unsigned int htab[1 << TPP_LZ_HASH_BITS]; /* input position + 1 of last 4 bytes with the hash */
+	const unsigned char *in = inbuf;
+	const unsigned char *ip = in;
+	const unsigned char *anchor = in;
+	const unsigned char *iend = in + inlen;
+	const unsigned char *ref;
+	unsigned char *out;
+	unsigned char *op;
+	unsigned char *token;
+	unsigned int h;
+	unsigned int lit;
+	unsigned int mlen;
+	unsigned int off;
+
+	*outlen = 0;
+
+	/* worst case, all literals */
+	if ((out = malloc(inlen + (inlen / 255) + 16)) == NULL) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating compress buffer %u bytes", inlen);
+		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+		return NULL;
+	}
+	memset(htab, 0, sizeof(htab));
+
+	op = out;
+	*op++ = TPP_LZ_TAG;
+
+	while (inlen >= TPP_LZ_MINMATCH + TPP_LZ_LASTLITERALS &&
+		ip <= iend - (TPP_LZ_MINMATCH + TPP_LZ_LASTLITERALS)) {
+		h = (tpp_lz_read32(ip) * 2654435761u) >> (32 - TPP_LZ_HASH_BITS);
+		ref = htab[h] ? in + htab[h] - 1 : NULL;
+		htab[h] = (ip - in) + 1;
+
+		if (ref == NULL || (ip - ref) > TPP_LZ_MAX_OFFSET || tpp_lz_read32(ref) != tpp_lz_read32(ip)) {
+			ip++;
+			continue;
+		}
+
+		mlen = TPP_LZ_MINMATCH;
+		while (ip + mlen < iend - TPP_LZ_LASTLITERALS && ref[mlen] == ip[mlen])
+			mlen++;
+
+		lit = ip - anchor;
+		off = ip - ref;
+
+		token = op++;
+		*token = (unsigned char) (((lit < 15) ? lit : 15) << 4);
+		if (lit >= 15)
+			op = tpp_lz_put_len(op, lit - 15);
+		memcpy(op, anchor, lit);
+		op += lit;
+
+		*op++ = (unsigned char) (off & 0xff);
+		*op++ = (unsigned char) (off >> 8);
+
+		mlen -= TPP_LZ_MINMATCH;
+		*token |= (unsigned char) ((mlen < 15) ? mlen : 15);
+		if (mlen >= 15)
+			op = tpp_lz_put_len(op, mlen - 15);
+
+		ip += mlen + TPP_LZ_MINMATCH;
+		anchor = ip;
+	}
+
+	/* last sequence, the remaining literals */
+	lit = iend - anchor;
+	token = op++;
+	*token = (unsigned char) (((lit < 15) ? lit : 15) << 4);
+	if (lit >= 15)
+		op = tpp_lz_put_len(op, lit - 15);
+	memcpy(op, anchor, lit);
+	op += lit;
+
+	*outlen = op - out;
+	return out;
+}
+
+/**
+ * @brief Uncompress data compressed by the lz codec
+ *
+ * @param[in] inbuf  - Ptr to compress data buffer
+ * @param[in] inlen  - The size of input buffer
+ * @param[in] totlen - The total size of the uncompress data
+ *
+ * @return      - Ptr to the uncompressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure (out of memory, or corrupt data)
+ *
+ * @par MT-safe: Yes
+ **/
+static void *
+tpp_lz_uncompress(void *inbuf, unsigned int inlen, unsigned int totlen)
+{
+	const unsigned char *ip = inbuf;
+	const unsigned char *iend = ip + inlen;
+	unsigned char *out;
+	unsigned char *op;
+	unsigned char *oend;
+	const unsigned char *ref;
+	unsigned int token;
+	unsigned int len;
+	unsigned int off;
+	unsigned int b;
+
+	if (inlen < 2 || *ip != TPP_LZ_TAG)
+		goto corrupt;
+	ip++;
+
+	if ((out = malloc(totlen > 0 ? totlen : 1)) == NULL) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating uncompress buffer %u bytes", totlen);
+		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+		return NULL;
+	}
+	op = out;
+	oend = out + totlen;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					goto corrupt_free;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		if (len > (unsigned int) (iend - ip) || len > (unsigned int) (oend - op))
+			goto corrupt_free;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		if (ip == iend)
+			break; /* the last sequence has no match */
+
+		if (iend - ip < 2)
+			goto corrupt_free;
+		off = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (off == 0 || off > (unsigned int) (op - out))
+			goto corrupt_free;
+
+		len = token & 0x0f;
+		if (len == 15) {
+			do {
+				if (ip >= iend)
+					goto corrupt_free;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += TPP_LZ_MINMATCH;
+		if (len > (unsigned int) (oend - op))
+			goto corrupt_free;
+
+		/* byte by byte, since the match may overlap what it produces */
+		ref = op - off;
+		while (len-- > 0)
+			*op++ = *ref++;
+	}
+
+	if (op != oend)
+		goto corrupt_free;
+
+	return out;
+
+corrupt_free:
+	free(out);
+corrupt:
+	tpp_log_func(LOG_CRIT, __func__, "Decompression failed, corrupt data");
+	return NULL;
+}
+
+/*
+ * The table of compression codecs, indexed by the codec ids, TPP_COMPR_*,
+ * that are used in tpp_config.compress
+ */
+static struct {
+	char *name;
+	void *(*compress)(void *inbuf, unsigned int inlen, unsigned int *outlen);
+} tpp_codecs[] = {
+	{"none", NULL},
+#ifdef PBS_COMPRESSION_ENABLED
+	{"zlib", tpp_deflate},
+#else
+	{"zlib", NULL},
+#endif
+	{"lz", tpp_lz_compress}
+};
+
+/**
+ * @brief Find a compression codec by its name
+ *
+ * @param[in] name - Name of the codec, "zlib" or "lz"
+ *
+ * @return - The codec id (TPP_COMPR_*)
+ * @retval  -1 - No such codec is available in this build
+ *
+ * @par MT-safe: Yes
+ **/
+int
+tpp_get_codec(char *name)
+{
+	int i;
+
+	for (i = TPP_COMPR_ZLIB; i < (int) (sizeof(tpp_codecs) / sizeof(tpp_codecs[0])); i++) {
+		if (strcmp(name, tpp_codecs[i].name) == 0) {
+			if (tpp_codecs[i].compress == NULL)
+				return -1;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Compress data with the given codec
+ *
+ * @param[in] codec   - The codec id (TPP_COMPR_*)
+ * @param[in] inbuf   - Ptr to buffer to compress
+ * @param[in] inlen   - The size of input buffer
+ * @param[out] outlen - The size of the compressed data
+ *
+ * @return      - Ptr to the compressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_compress(int codec, void *inbuf, unsigned int inlen, unsigned int *outlen)
+{
+	*outlen = 0;
+	if (codec <= TPP_COMPR_NONE || codec > TPP_COMPR_LZ || tpp_codecs[codec].compress == NULL)
+		return NULL;
+	return tpp_codecs[codec].compress(inbuf, inlen, outlen);
+}
+
+/**
+ * @brief Uncompress data compressed by any of the codecs. The codec is
+ *	known from the first byte of the data.
+ *
+ * @param[in] inbuf  - Ptr to compress data buffer
+ * @param[in] inlen  - The size of input buffer
+ * @param[in] totlen - The total size of the uncompress data
+ *
+ * @return      - Ptr to the uncompressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_uncompress(void *inbuf, unsigned int inlen, unsigned int totlen)
+{
+	if (inlen > 0 && *((unsigned char *) inbuf) == TPP_LZ_TAG)
+		return tpp_lz_uncompress(inbuf, inlen, totlen);
+	return tpp_inflate(inbuf, inlen, totlen);
+}
+
 /**
  * @brief Convenience function to validate a tpp header
  *
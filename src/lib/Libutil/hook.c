@@ -501,6 +501,52 @@ hook_freq_as_string(int freq)
 	return (freq_str);
 }
 
+/**
+ *
+ * @brief
+ *	Returns the string representation of the execution statistics
+ *	gathered for hook 'phook', one comma-separated entry per event
+ *	the hook has run on:
+ *	  <event>:count=<n>;accept=<n>;reject=<n>;total=<s>;max=<s>;setup=<s>;run=<s>
+ *
+ * @param[in]	phook - the hook in question
+ *
+ * @return char *
+ * @retval <string> - the statistics, or "" if the hook never ran.
+ *
+ * @note
+ *	This returns a static string that will get overwritten on the
+ *	next call to this function.
+ */
+char *
+hook_stats_as_string(hook *phook)
+{
+	static char	stats_str[HOOK_BUF_SIZE*4];
+	struct hook_stats *ps;
+	size_t		len = 0;
+	int		i;
+
+	stats_str[0] = '\0';
+	if (phook->stats == NULL)
+		return (stats_str);
+
+	for (i = 0; i < HOOK_STATS_NEVENTS; i++) {
+		ps = &phook->stats[i];
+		if (ps->count == 0)
+			continue;
+		len += snprintf(stats_str + len, sizeof(stats_str) - len,
+			"%s%s:count=%lu;accept=%lu;reject=%lu;total=%.6f;"
+			"max=%.6f;setup=%.6f;run=%.6f",
+			(len > 0) ? "," : "",
+			hook_event_as_string(1 << i), ps->count,
+			ps->accepts, ps->rejects, ps->total, ps->max,
+			ps->setup, ps->run);
+		if (len >= sizeof(stats_str))
+			break;
+	}
+	return (stats_str);
+}
+
 /*
  *	Sets the hook 'phook's name attribute to string 'newval'.
  *	RETURNS: 0 for success; 1 otherwise with 'msg' of size 'msg_len'
@@ -2266,6 +2312,10 @@ hook_init(hook *phook, void (*pyfree_func)(struct python_script *))
 		free(phook->script);
 	}
 	phook->script = NULL;
+	if (phook->stats != NULL) {
+		free(phook->stats);
+		phook->stats = NULL;
+	}
 	phook->hook_control_checksum = 0;
 	phook->hook_script_checksum = 0;
 	phook->hook_config_checksum = 0;
@@ -61,6 +61,141 @@ extern pbs_list_head task_list_event; /* list of tasks responding to an event */
 extern int svr_delay_entry;
 extern time_t	time_now;
 
+/*
+ * Timed tasks are kept in a binary min-heap ordered on (wt_event, wt_seq) so
+ * that adding and dispatching them does not walk task_list_timed, which is
+ * left unsorted and only used by the wt_parm1 searches below.
+ *
+ * Event tasks are also hashed on their event id (on wt_parm1 for
+ * WORK_Deferred_Local tasks, whose event id is always the local connection)
+ * so that find_work_task() only has to look at one bucket.
+ */
+#define WT_EVENT_HASH	1024
+
+static struct work_task **wt_heap = NULL;	/* timed task heap */
+static int		  wt_heap_ct = 0;	/* entries in use */
+static int		  wt_heap_size = 0;	/* entries allocated */
+static unsigned long	  wt_seq_next = 0;
+
+static pbs_list_head	  wt_event_hash[WT_EVENT_HASH];
+static int		  wt_event_hash_init = 0;
+
+/**
+ * @brief
+ *	Return the event hash bucket for a task of type 'type'.
+ *
+ * @param[in]	type	- type of the task
+ * @param[in]	event	- event id of the task
+ * @param[in]	parm1	- wt_parm1 of the task
+ *
+ * @return pbs_list_head *
+ */
+static pbs_list_head *
+wt_bucket(enum work_type type, long event, void *parm1)
+{
+	unsigned long key;
+	int i;
+
+	if (wt_event_hash_init == 0) {
+		for (i = 0; i < WT_EVENT_HASH; i++)
+			CLEAR_HEAD(wt_event_hash[i]);
+		wt_event_hash_init = 1;
+	}
+	if (type == WORK_Deferred_Local)
+		key = (unsigned long)parm1 >> 4;
+	else
+		key = (unsigned long)event;
+	key ^= key >> 10;
+	return (&wt_event_hash[key & (WT_EVENT_HASH - 1)]);
+}
+
+/**
+ * @brief
+ *	Return 1 if timed task 'a' is due before timed task 'b'.
+ */
+static int
+wt_heap_before(struct work_task *a, struct work_task *b)
+{
+	if (a->wt_event != b->wt_event)
+		return (a->wt_event < b->wt_event);
+	return (a->wt_seq < b->wt_seq);
+}
+
+/**
+ * @brief
+ *	Place 'ptask' at heap slot 'i' and move it up or down until the heap
+ *	order is restored.
+ */
+static void
+wt_heap_fix(int i, struct work_task *ptask)
+{
+	int child;
+
+	while (i > 0 && wt_heap_before(ptask, wt_heap[(i - 1) / 2])) {
+		wt_heap[i] = wt_heap[(i - 1) / 2];
+		wt_heap[i]->wt_heapidx = i;
+		i = (i - 1) / 2;
+	}
+	while ((child = 2 * i + 1) < wt_heap_ct) {
+		if ((child + 1 < wt_heap_ct) &&
+			wt_heap_before(wt_heap[child + 1], wt_heap[child]))
+			child++;
+		if (!wt_heap_before(wt_heap[child], ptask))
+			break;
+		wt_heap[i] = wt_heap[child];
+		wt_heap[i]->wt_heapidx = i;
+		i = child;
+	}
+	wt_heap[i] = ptask;
+	ptask->wt_heapidx = i;
+}
+
+/**
+ * @brief
+ *	Add a timed task to the heap.
+ *
+ * @return int
+ * @retval 0	- success
+ * @retval -1	- out of memory
+ */
+static int
+wt_heap_add(struct work_task *ptask)
+{
+	struct work_task **tmp;
+	int newsize;
+
+	if (wt_heap_ct == wt_heap_size) {
+		newsize = wt_heap_size ? wt_heap_size * 2 : 64;
+		tmp = (struct work_task **)realloc(wt_heap,
+			newsize * sizeof(struct work_task *));
+		if (tmp == NULL)
+			return -1;
+		wt_heap = tmp;
+		wt_heap_size = newsize;
+	}
+	ptask->wt_seq = wt_seq_next++;
+	wt_heap_fix(wt_heap_ct++, ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove a task from the timed task heap, if it is on it.
+ */
+static void
+wt_heap_del(struct work_task *ptask)
+{
+	int i = ptask->wt_heapidx;
+	struct work_task *last;
+
+	if (i < 0)
+		return;
+	ptask->wt_heapidx = -1;
+	last = wt_heap[--wt_heap_ct];
+	if (last != ptask)
+		wt_heap_fix(i, last);
+}
+
 /**
  *
  * @brief
@@ -82,7 +217,6 @@ extern time_t	time_now;
 struct work_task *set_task(enum work_type type, long event_id, void (*func)(struct work_task *) , void *parm)
 {
 	struct work_task *pnew;
-	struct work_task *pold;
 
 	pnew = (struct work_task *)malloc(sizeof(struct work_task));
 	if (pnew == NULL)
@@ -90,6 +224,9 @@ struct work_task *set_task(enum work_type type, long event_id, void (*func)(stru
 	CLEAR_LINK(pnew->wt_linkall);
 	CLEAR_LINK(pnew->wt_linkobj);
 	CLEAR_LINK(pnew->wt_linkobj2);
+	CLEAR_LINK(pnew->wt_linkevent);
+	pnew->wt_heapidx = -1;
+	pnew->wt_seq = 0;
 	pnew->wt_event = event_id;
 	pnew->wt_event2 = NULL;
 	pnew->wt_type  = type;
@@ -103,19 +240,16 @@ struct work_task *set_task(enum work_type type, long event_id, void (*func)(stru
 	if (type == WORK_Immed)
 		append_link(&task_list_immed, &pnew->wt_linkall, pnew);
 	else if (type == WORK_Timed) {
-		pold = (struct work_task *)GET_NEXT(task_list_timed);
-		while (pold) {
-			if (pold->wt_event > pnew->wt_event)
-				break;
-			pold = (struct work_task *)GET_NEXT(pold->wt_linkall);
+		if (wt_heap_add(pnew) == -1) {
+			free(pnew);
+			return NULL;
 		}
-		if (pold)
-			insert_link(&pold->wt_linkall, &pnew->wt_linkall, pnew,
-				LINK_INSET_BEFORE);
-		else
-			append_link(&task_list_timed, &pnew->wt_linkall, pnew);
-	} else
+		append_link(&task_list_timed, &pnew->wt_linkall, pnew);
+	} else {
 		append_link(&task_list_event, &pnew->wt_linkall, pnew);
+		append_link(wt_bucket(type, event_id, parm),
+			&pnew->wt_linkevent, pnew);
+	}
 	return (pnew);
 }
 
@@ -138,6 +272,8 @@ dispatch_task(struct work_task *ptask)
 	delete_link(&ptask->wt_linkall);
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
+	delete_link(&ptask->wt_linkevent);
+	wt_heap_del(ptask);
 	if (ptask->wt_func)
 		ptask->wt_func(ptask);		/* dispatch process function */
 	(void)free(ptask);
@@ -157,9 +293,64 @@ delete_task(struct work_task *ptask)
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
 	delete_link(&ptask->wt_linkall);
+	delete_link(&ptask->wt_linkevent);
+	wt_heap_del(ptask);
 	(void)free(ptask);
 }
 
+/**
+ *
+ * @brief
+ *	Remove an event task from task_list_event without freeing it, so that
+ *	it is no longer found by find_work_task().  The caller may then place
+ *	the task on another list through wt_linkall.
+ *
+ * @param[in]	ptask	- the event task
+ */
+
+void
+unlink_task_event(struct work_task *ptask)
+{
+	delete_link(&ptask->wt_linkall);
+	delete_link(&ptask->wt_linkevent);
+}
+
+/**
+ *
+ * @brief
+ *	Find an event task of type 'type' for event id 'event'.
+ *
+ * @param[in]	type	- type of the task
+ * @param[in]	event	- event id being matched, ignored for
+ *			  WORK_Deferred_Local tasks
+ * @param[in]	parm1	- if not NULL, wt_parm1 must also match
+ *
+ * @return struct work_task *
+ * @retval <the first task added that matches>
+ * @retval NULL	- no such task
+ *
+ * @note
+ *	Only tasks on task_list_event are found; a task whose wt_type was
+ *	changed after set_task() is found under its new type as long as the
+ *	type is not changed to or from WORK_Deferred_Local.
+ */
+
+struct work_task *
+find_work_task(enum work_type type, long event, void *parm1)
+{
+	struct work_task *ptask;
+
+	ptask = (struct work_task *)GET_NEXT(*wt_bucket(type, event, parm1));
+	while (ptask) {
+		if ((ptask->wt_type == type) &&
+			((type == WORK_Deferred_Local) || (ptask->wt_event == event)) &&
+			((parm1 == NULL) || (ptask->wt_parm1 == parm1)))
+			return (ptask);
+		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkevent);
+	}
+	return NULL;
+}
+
 /**
  *
  * @brief
@@ -307,7 +498,8 @@ default_next_task(void)
 	while ((ptask=(struct work_task *)GET_NEXT(task_list_immed)) != NULL)
 		dispatch_task(ptask);
 
-	while ((ptask=(struct work_task *)GET_NEXT(task_list_timed))!=NULL) {
+	while (wt_heap_ct > 0) {
+		ptask = wt_heap[0];
 		if ((delay = ptask->wt_event - time_now) > 0) {
 			if (tilwhen > delay)
 				tilwhen = delay;
@@ -526,11 +526,15 @@ class _queue(object):
             return _pbs_v1.get_job(jobid, self.name)
     #: m(job)
 
-    def jobs(self):
+    def jobs(self, username=None, state=None):
         """
             Returns an iterator that loops over the list of jobs on this queue.
+            If username is given, only jobs owned by that user are returned; if
+            state is given (e.g. pbs.JOB_STATE_QUEUED), only jobs in that
+            state.  Jobs left out are skipped without being looked at.
         """
-        return pbs_iter("jobs", "",  self.name, self._connect_server)
+        return pbs_iter("jobs", "",  self.name, self._connect_server,
+                        username, state)
     #: m(jobs)
     
 #: C(_queue)
@@ -660,12 +664,19 @@ class _server(object):
             return pbs_iter("jobs", "",  qname, self._connect_server, ignore_fin, username)
         #: m(jobs_nas)
     else:
-        def jobs(self):
+        def jobs(self, qname=None, username=None, state=None):
             """
             Returns an iterator that loops over the list of jobs on this server.
+            Jobs can be restricted to those in queue qname, to those owned by
+            username, and to those in state (e.g. pbs.JOB_STATE_QUEUED).  Jobs
+            left out are skipped without being looked at, which is much cheaper
+            than filtering the full list in the hook.
             """
 
-            return pbs_iter("jobs", "",  "", self._connect_server)
+            if qname is None:
+                qname = ""
+            return pbs_iter("jobs", "",  qname, self._connect_server,
+                            username, state)
         #: m(jobs)
 
     def vnodes(self):
@@ -931,9 +942,15 @@ class pbs_iter(object):
 		# argument 1 below tells C function were inside __init__
 		_pbs_v1.iter_nextfunc(self, 1, pbs_obj_name, pbs_filter1, self.filter2, self.ignore_fin, self.filter_user) 
     else:
-	def __init__(self, pbs_obj_name, pbs_filter1, pbs_filter2, connect_server=None):
+	def __init__(self, pbs_obj_name, pbs_filter1, pbs_filter2, connect_server=None, pbs_username=None, pbs_state=None):
         
 	    self._caller = _pbs_v1.get_python_daemon_name()
+	    self.filter_user = ""
+	    self.filter_state = -1
+	    if pbs_username != None:
+		self.filter_user = pbs_username
+	    if pbs_state != None:
+		self.filter_state = int(pbs_state)
 	    if self._caller == "pbs_python":
 
 		if( connect_server == None ):
@@ -986,7 +1003,7 @@ class pbs_iter(object):
 		self.filter1 = pbs_filter1
 		self.filter2 = pbs_filter2
 		# argument 1 below tells C function we're inside __init__
-		_pbs_v1.iter_nextfunc(self, 1, pbs_obj_name, pbs_filter1, pbs_filter2) 
+		_pbs_v1.iter_nextfunc(self, 1, pbs_obj_name, pbs_filter1, pbs_filter2, self.filter_user, self.filter_state) 
 
     def __iter__(self):
         return self
@@ -1117,6 +1134,16 @@ class pbs_iter(object):
 		return _pbs_v1.iter_nextfunc(self, 0, self.obj_name, self.filter1, self.filter2, self.ignore_fin, self.filter_user)
     else:
 	def next(self):
+	    obj = self._next()
+	    if self._caller == "pbs_python" and self.type == "jobs":
+		# the server filters for hooks; here it is done on the results
+		while (self.filter_user != "" and
+		       str(obj.Job_Owner).split("@")[0] != self.filter_user) or \
+		      (self.filter_state != -1 and obj.job_state != self.filter_state):
+		    obj = self._next()
+	    return obj
+
+	def _next(self):
 	    if self._caller == "pbs_python":
 		if not hasattr(self, "bs") or self.bs == None:
 		    if not _pbs_v1.use_static_data():
@@ -1233,6 +1260,6 @@ class pbs_iter(object):
 		return obj
 	    else:
 		# argument 0 below tells C function we're inside next
-		    return _pbs_v1.iter_nextfunc(self, 0, self.obj_name, self.filter1, self.filter2)
+		    return _pbs_v1.iter_nextfunc(self, 0, self.obj_name, self.filter1, self.filter2, self.filter_user, self.filter_state)
 #: C(pbs_iter)
 
@@ -106,6 +106,9 @@ extern int		termin_child;
 extern int		resc_access_perm;
 extern int		server_stream;
 extern time_t		time_now;
+extern float		resc_update_threshold;
+extern int		resc_update_full;
+extern int		rused_full_gen;
 extern pbs_list_head	mom_polljobs;
 extern unsigned int	pbs_mom_port;
 #if MOM_ALPS
@@ -1113,6 +1116,145 @@ update_ajob_status(job *pjob)
 	update_ajob_status_using_cmd(pjob, IS_RESCUSED);
 }
 
+/**
+ * @brief
+ *	Convert a resources_used value to a number for comparing against an
+ *	earlier value: a plain number, a time of the form [[HH:]MM:]SS or a
+ *	size; a size keeps its unit in 'unit' as values are only comparable
+ *	in the same unit.
+ *
+ * @param[in]	val - the value string
+ * @param[out]	num - the number
+ * @param[out]	unit - the unit suffix of the value, if any
+ *
+ * @return int
+ * @retval 0	success
+ * @retval -1	value is not numeric
+ */
+static int
+rused_numeric(char *val, double *num, char **unit)
+{
+	char	*end;
+	char	*end2;
+	double	 part;
+
+	*num = strtod(val, &end);
+	if (end == val)
+		return -1;
+	while (*end == ':') {
+		part = strtod(end + 1, &end2);
+		if (end2 == end + 1)
+			return -1;
+		*num = *num * 60 + part;
+		end = end2;
+	}
+	*unit = end;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Decide whether a value of a job's periodic update differs enough from
+ *	the value last sent to the server to be sent again.
+ *
+ * @param[in]	pal - the value about to be sent
+ * @param[in]	sent - the value last sent
+ *
+ * @return int
+ * @retval 1	changed, send it
+ * @retval 0	not changed enough
+ */
+static int
+rused_changed(svrattrl *pal, svrattrl *sent)
+{
+	double	 nv;
+	double	 ov;
+	char	*nu;
+	char	*ou;
+
+	if ((pal->al_value == NULL) || (sent->al_value == NULL))
+		return (pal->al_value != sent->al_value);
+	if (strcmp(pal->al_value, sent->al_value) == 0)
+		return 0;
+
+	/* only resources_used values may be held back by the threshold */
+	if ((resc_update_threshold <= 0.0) ||
+		(strncmp(pal->al_name, ATTR_used, strlen(ATTR_used)) != 0))
+		return 1;
+	if ((rused_numeric(pal->al_value, &nv, &nu) != 0) ||
+		(rused_numeric(sent->al_value, &ov, &ou) != 0) ||
+		(strcmp(nu, ou) != 0))
+		return 1;
+
+	nv = (nv > ov) ? (nv - ov) : (ov - nv);
+	if (ov < 0)
+		ov = -ov;
+	return (nv > ov * resc_update_threshold / 100.0);
+}
+
+/**
+ * @brief
+ *	Reduce a job's periodic update to the values that changed since they
+ *	were last sent to the server.
+ *
+ * @par Functionality:
+ *	The server keeps the values it is not sent, so only those that
+ *	changed, by more than $resc_update_threshold percent for numeric
+ *	resources_used, need to be sent.  The whole update is sent on the
+ *	first update to a (re)connected server and every $resc_update_full
+ *	updates, so the server cannot stay behind for long.
+ *
+ * @param[in]	pjob - the job
+ * @param[in,out] phead - the job's update, values that need not be sent
+ *			  are removed
+ * @param[in]	full - if non-zero, send the whole update
+ *
+ * @return int
+ * @retval	number of values left in the update
+ */
+static int
+rused_delta(job *pjob, pbs_list_head *phead, int full)
+{
+	svrattrl	*pal;
+	svrattrl	*next;
+	svrattrl	*sent;
+	int		 kept = 0;
+
+	if ((pjob->ji_rused_gen != rused_full_gen) ||
+		(++pjob->ji_rused_cycles >= resc_update_full))
+		full = 1;
+	if (full) {
+		free_attrlist(&pjob->ji_rused_sent);
+		pjob->ji_rused_gen = rused_full_gen;
+		pjob->ji_rused_cycles = 0;
+	}
+
+	/* values are dropped one by one, so unchain the resource sisters */
+	for (pal = (svrattrl *)GET_NEXT(*phead); pal;
+		pal = (svrattrl *)GET_NEXT(pal->al_link))
+		pal->al_sister = NULL;
+
+	for (pal = (svrattrl *)GET_NEXT(*phead); pal; pal = next) {
+		next = (svrattrl *)GET_NEXT(pal->al_link);
+
+		sent = find_svrattrl_list_entry(&pjob->ji_rused_sent,
+			pal->al_name, pal->al_resc);
+		if (sent != NULL) {
+			if (!rused_changed(pal, sent)) {
+				delete_link(&pal->al_link);
+				free(pal);
+				continue;
+			}
+			delete_link(&sent->al_link);
+			free(sent);
+		}
+		(void)add_to_svrattrl_list(&pjob->ji_rused_sent, pal->al_name,
+			pal->al_resc, pal->al_value, pal->al_flags, NULL);
+		kept++;
+	}
+	return kept;
+}
+
 /**
  * @brief
  * 	update_jobs_status - return the status of jobs to the server
@@ -1148,7 +1290,6 @@ update_jobs_status(void)
 		if (pjob->ji_qs.ji_substate != JOB_SUBSTATE_RUNNING)
 			continue;
 
-		++count;
 		/* allocate reply structure and fill in header portion */
 		prused = (struct resc_used_update *)
 			malloc(sizeof(struct resc_used_update));
@@ -1162,9 +1303,7 @@ update_jobs_status(void)
 			prused->ru_hop    = pjob->ji_wattr[(int)JOB_ATR_runcount].at_val.at_long;
 		}
 		CLEAR_HEAD(prused->ru_attr);
-		*prusednext	  = prused;	/* make last on list */
 		prused->ru_next   = NULL;	/* terminate list */
-		prusednext	  = &prused->ru_next;	/* track last link */
 
 		/* now append the session id and resources used */
 		(void)job_attr_def[(int)JOB_ATR_session_id].at_encode(
@@ -1198,6 +1337,18 @@ update_jobs_status(void)
 			}
 
 		}
+
+		/* send only what changed, skip the job if nothing did */
+		if (rused_delta(pjob, &prused->ru_attr,
+			svr_hook_resend_job_attrs) == 0) {
+			free_attrlist(&prused->ru_attr);
+			free(prused);
+			continue;
+		}
+
+		++count;
+		*prusednext	  = prused;	/* make last on list */
+		prusednext	  = &prused->ru_next;	/* track last link */
 	}
 
 	/* now send info to server via rpp */
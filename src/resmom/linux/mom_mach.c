@@ -138,11 +138,21 @@ static DIR	*cpusetdir = NULL;
 /* convert between jiffies and seconds */
 #define	JTOS(x)	(((x) + (hz/2)) / hz)
 
-static char	*choose_procflagsfmt(void);
-
 proc_stat_t	*proc_info = NULL;
 int		nproc = 0;
 int		max_proc = 0;
+
+/*
+ * Index of proc_info[] by session id, rebuilt by mom_get_sample().
+ * sess_head[] holds the first process of each hash bucket and
+ * proc_sess_next[] chains the rest; walk it with sess_next().
+ */
+static int	*sess_head = NULL;
+static int	*proc_sess_next = NULL;
+static int	sess_nbuckets = 0;	/* power of two */
+static int	sess_nnext = 0;		/* size of proc_sess_next[] */
+#define	SESS_HASH(sid)	((unsigned int)(sid) & (sess_nbuckets - 1))
+static int	sess_next(int, pid_t);
 #if	MOM_CPUSET
 int		do_memreserved_adjustment;
 #endif	/* MOM_CPUSET */
@@ -162,6 +172,8 @@ extern  int	nice_val;
 extern	int			rm_errno;
 extern	int			reqnum;
 extern	double	cputfactor;
+extern	int	cgroup_accounting;
+extern	char	cgroup_prefix[];
 extern	double	wallfactor;
 extern  pid_t	mom_pid;
 extern	int	num_acpus;
@@ -4544,33 +4556,6 @@ proc_get_btime(void)
 	return;
 }
 
-static char	stat_str_pre[] =
-"%%d "		/* 1  pid %d The process id */
-"(%%[^)]) "	/* 2  comm %s The filename of the executable */
-"%%c "		/* 3  state %c "RSDZTW" */
-"%%d "		/* 4  ppid %d The PID of the parent */
-"%%d "		/* 5  pgrp %d The process group ID */
-"%%d "		/* 6  session %d The session ID */
-"%%*d "		/* 7  ignored:  tty_nr */
-"%%*d "		/* 8  ignored:  tpgid */
-"%s "		/* 9  flags - %u or %lu */
-"%%*lu "	/* 10 ignored:  minflt */
-"%%*lu "	/* 11 ignored:  cminflt */
-"%%*lu "	/* 12 ignored:  majflt */
-"%%*lu "	/* 13 ignored:  cmajflt */
-"%%lu "		/* 14 utime %lu */
-"%%lu "		/* 15 stime %lu */
-"%%ld "		/* 16 cutime %ld */
-"%%ld "		/* 17 cstime %ld */
-"%%*ld "	/* 18 ignored:  priority %ld */
-"%%*ld "	/* 19 ignored:  nice %ld */
-"%%*ld "	/* 20 ignored:  num_threads %ld */
-"%%*ld "	/* 21 ignored:  itrealvalue %ld - no longer maintained */
-"%%llu "	/* 22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
-"%%lu "		/* 23 vsize (bytes) */
-"%%ld "		/* 24 rss (number of pages) */
-  ;
-
 /**
  * @brief
  *	returns the process memory (used,free,total).
@@ -5066,30 +5051,35 @@ end_proc(void)
 
 /**
  * @brief
- *	 Scan a list of tasks and return true if one of them matches sid
+ *	Tell whether a task is the first task of its job with its session
+ *	id, so that processes of a session shared by several tasks are only
+ *	counted once.  A task whose session has exited simply has no
+ *	processes left in the session index.
  *
  * @param[in] pjob - job pointer
- * @param[in] sid - session id
+ * @param[in] ptask - task of the job
  *
  * @return	Bool
- * @retval	TRUE
- * @retval	FALSE	Error
+ * @retval	TRUE	count the processes of the task's session
+ * @retval	FALSE	the task has no session id, or an earlier task
+ *			has the same session
  *
  */
 static int
-injob(job *pjob, pid_t sid)
+first_task_of_sid(job *pjob, task *ptask)
 {
-	task	*ptask;
+	task	*pt;
+	pid_t	sid = ptask->ti_qs.ti_sid;
 
-	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
-		ptask;
-		ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
-		if (ptask->ti_qs.ti_sid <= 1)
-			continue;
-		if (ptask->ti_qs.ti_sid == sid)
-			return TRUE;
+	if (sid <= 1)
+		return FALSE;
+	for (pt = (task *)GET_NEXT(pjob->ji_tasks);
+		pt != ptask;
+		pt = (task *)GET_NEXT(pt->ti_jobtask)) {
+		if (pt->ti_qs.ti_sid == sid)
+			return FALSE;
 	}
-	return FALSE;
+	return TRUE;
 }
 
 /**
@@ -5128,13 +5118,10 @@ cput_sum(job *pjob)
 		active_tasks++;
 		tcput = 0;
 		taskprocs = 0;
-		for (i=0; i<nproc; i++) {
+		for (i = sess_next(-1, ptask->ti_qs.ti_sid); i != -1;
+			i = sess_next(i, ptask->ti_qs.ti_sid)) {
 			ps = &proc_info[i];
 
-			/* is this process part of the task? */
-			if (ptask->ti_qs.ti_sid != ps->session)
-				continue;
-
 			nps++;
 			taskprocs++;
 
@@ -5274,18 +5261,25 @@ mem_sum(job *pjob)
 	int		i;
 	ulong		segadd;
 	proc_stat_t	*ps;
+	task		*ptask;
 
 	segadd = 0;
 
-	for (i=0; i<nproc; i++) {
-
-		ps = &proc_info[i];
+	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+		ptask != NULL;
+		ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
 
-		if (!injob(pjob, ps->session))
+		if (!first_task_of_sid(pjob, ptask))
 			continue;
-		segadd += ps->vsize;
-		DBPRT(("%s: pid: %d  pr_size: %lu  total: %lu\n",
-			__func__, ps->pid, (ulong)ps->vsize, segadd))
+
+		for (i = sess_next(-1, ptask->ti_qs.ti_sid); i != -1;
+			i = sess_next(i, ptask->ti_qs.ti_sid)) {
+
+			ps = &proc_info[i];
+			segadd += ps->vsize;
+			DBPRT(("%s: pid: %d  pr_size: %lu  total: %lu\n",
+				__func__, ps->pid, (ulong)ps->vsize, segadd))
+		}
 	}
 
 	return (segadd);
@@ -5309,26 +5303,33 @@ resi_sum(job *pjob)
 	ulong		resisize;
 	long		wm;		/* Altix weighted RSS replacement */
 	proc_stat_t	*ps;
+	task		*ptask;
 
 	resisize = 0;
-	for (i=0; i<nproc; i++) {
-
-		ps = &proc_info[i];
+	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+		ptask != NULL;
+		ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
 
-		if (!injob(pjob, ps->session))
+		if (!first_task_of_sid(pjob, ptask))
 			continue;
 
-		/*
-		 *	Certain Altix ProPack releases (or patches) add an
-		 *	interface to replace the value reported by /proc via
-		 *	the RSS field in the process's stat file.  If the
-		 *	value is available, we use it;  if get_wm() returns
-		 *	-1 indicating an error, we proceed using the old rss
-		 *	value that we read from /proc/<pid>/stat.
-		 */
-		if ((wm = get_wm(ps->pid)) != -1)
-			ps->rss = wm;
-		resisize += ps->rss * pagesize;
+		for (i = sess_next(-1, ptask->ti_qs.ti_sid); i != -1;
+			i = sess_next(i, ptask->ti_qs.ti_sid)) {
+
+			ps = &proc_info[i];
+
+			/*
+			 *	Certain Altix ProPack releases (or patches) add an
+			 *	interface to replace the value reported by /proc via
+			 *	the RSS field in the process's stat file.  If the
+			 *	value is available, we use it;  if get_wm() returns
+			 *	-1 indicating an error, we proceed using the old rss
+			 *	value that we read from /proc/<pid>/stat.
+			 */
+			if ((wm = get_wm(ps->pid)) != -1)
+				ps->rss = wm;
+			resisize += ps->rss * pagesize;
+		}
 	}
 
 	return (resisize);
@@ -5535,6 +5536,176 @@ mom_open_poll(void)
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ *	Read the next number of a /proc/<pid>/stat line.
+ *
+ * @param[in]	p - where to start reading, leading blanks are skipped
+ * @param[out]	val - the number
+ *
+ * @return	char *
+ * @retval	just past the number	Success
+ * @retval	NULL			no number at p
+ *
+ */
+static char *
+stat_field(char *p, long long *val)
+{
+	unsigned long long	v = 0;
+	int			neg = 0;
+
+	while (*p == ' ')
+		p++;
+	if (*p == '-') {
+		neg = 1;
+		p++;
+	}
+	if (!isdigit(*p))
+		return NULL;
+	while (isdigit(*p))
+		v = v * 10 + (*p++ - '0');
+	*val = neg ? -(long long)v : (long long)v;
+	return p;
+}
+
+/**
+ * @brief
+ *	Parse the fields mom samples out of a /proc/<pid>/stat line.
+ *
+ * @par
+ *	The command name is everything between the first '(' and the last
+ *	')', as it may itself contain blanks and parentheses.  Fields 4 to 24
+ *	are plain numbers; flags (9) is read the same whether the kernel
+ *	prints it as %u or %lu.
+ *
+ * @param[in]	buf - the nul terminated line
+ * @param[out]	ps - process entry to fill in
+ * @param[out]	comm - command name
+ * @param[in]	commsz - size of comm
+ * @param[out]	starttime - start time in jiffies after boot
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	malformed line
+ *
+ */
+static int
+parse_proc_stat(char *buf, proc_stat_t *ps, char *comm, size_t commsz,
+	unsigned long long *starttime)
+{
+	char		*p;
+	char		*ce;
+	long long	 v;
+	int		 field;
+	size_t		 len;
+
+	if ((p = stat_field(buf, &v)) == NULL)
+		return -1;
+	ps->pid = (pid_t)v;
+
+	if (((p = strchr(p, '(')) == NULL) || ((ce = strrchr(p, ')')) == NULL))
+		return -1;
+	p++;
+	len = ce - p;
+	if (len >= commsz)
+		len = commsz - 1;
+	memcpy(comm, p, len);
+	comm[len] = '\0';
+
+	p = ce + 1;
+	while (*p == ' ')
+		p++;
+	if (*p == '\0')
+		return -1;
+	ps->state = *p++;
+
+	for (field = 4; field <= 24; field++) {
+		if ((p = stat_field(p, &v)) == NULL)
+			return -1;
+		switch (field) {
+			case 4: ps->ppid = (pid_t)v; break;
+			case 5: ps->pgrp = (pid_t)v; break;
+			case 6: ps->session = (pid_t)v; break;
+			case 9: ps->flags = (ulong)v; break;
+			case 14: ps->utime = (ulong)v; break;
+			case 15: ps->stime = (ulong)v; break;
+			case 16: ps->cutime = (ulong)v; break;
+			case 17: ps->cstime = (ulong)v; break;
+			case 22: *starttime = (unsigned long long)v; break;
+			case 23: ps->vsize = (ulong)v; break;
+			case 24: ps->rss = (ulong)v; break;
+			default: break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Rebuild the session index of proc_info[] after a sample.
+ *
+ * @return	Void
+ *
+ */
+static void
+sess_index_build(void)
+{
+	int	i;
+	int	h;
+	void	*hold;
+
+	/* keep at least a bucket per process */
+	if (sess_nbuckets < max_proc) {
+		h = (sess_nbuckets > 0) ? sess_nbuckets : 64;
+		while (h < max_proc)
+			h <<= 1;
+		hold = realloc(sess_head, h * sizeof(int));
+		assert(hold != NULL);
+		sess_head = (int *)hold;
+		sess_nbuckets = h;
+	}
+	if (sess_nnext < max_proc) {
+		hold = realloc(proc_sess_next, max_proc * sizeof(int));
+		assert(hold != NULL);
+		proc_sess_next = (int *)hold;
+		sess_nnext = max_proc;
+	}
+
+	for (h = 0; h < sess_nbuckets; h++)
+		sess_head[h] = -1;
+	/* insert backwards so each chain is in proc_info[] order */
+	for (i = nproc - 1; i >= 0; i--) {
+		h = SESS_HASH(proc_info[i].session);
+		proc_sess_next[i] = sess_head[h];
+		sess_head[h] = i;
+	}
+}
+
+/**
+ * @brief
+ *	Step through the processes of a session in proc_info[].
+ *
+ * @param[in]	i - the previous process of the session, -1 to start
+ * @param[in]	sid - session id
+ *
+ * @return	int
+ * @retval	index in proc_info[] of the next process of the session
+ * @retval	-1 when there are no more
+ *
+ */
+static int
+sess_next(int i, pid_t sid)
+{
+	if (sess_nbuckets == 0)
+		return -1;
+	i = (i == -1) ? sess_head[SESS_HASH(sid)] : proc_sess_next[i];
+	for (; i != -1; i = proc_sess_next[i]) {
+		if (proc_info[i].session == sid)
+			return i;
+	}
+	return -1;
+}
+
 /**
  * @brief
  * 	Declare start of polling loop.
@@ -5548,8 +5719,10 @@ int
 mom_get_sample(void)
 {
 	struct dirent		*dent = NULL;
-	FILE			*fd = NULL;
+	int			fd;
+	ssize_t			len;
 	static char		path[1024];
+	static char		statbuf[1024];
 	char			procname[256];
 	struct stat		sb;
 	proc_stat_t		*ps = NULL;
@@ -5563,7 +5736,6 @@ mom_get_sample(void)
 	unsigned long long 	starttime;
 	int			nskipped = 0;
 	extern time_t		time_last_sample;
-	char			*stat_str = NULL;
 
 	DBPRT(("%s: entered\n", __func__))
 	if (pdir == NULL)
@@ -5581,7 +5753,6 @@ mom_get_sample(void)
 #endif /* MOM_CPUSET */
 	rewinddir(pdir);
 	nproc = 0;
-	fd = NULL;
 	if (hz == 0)
 		hz = sysconf(_SC_CLK_TCK);
 	time_last_sample = time(0);
@@ -5613,54 +5784,30 @@ mom_get_sample(void)
 #endif	/* MOM_CPUSET */
 		sprintf(procname, "/proc/%s/stat", dent->d_name);
 
-		if ((fd = fopen(procname, "r")) == NULL) {
+		if ((fd = open(procname, O_RDONLY)) == -1) {
 			ncantstat++;
 			continue;
 		}
+		if ((len = pread(fd, statbuf, sizeof(statbuf) - 1, 0)) <= 0) {
+			ncantstat++;
+			close(fd);
+			continue;
+		}
+		statbuf[len] = '\0';
 
 		ps = &proc_info[nproc];
-		stat_str = choose_procflagsfmt();
-		if (stat_str == NULL) {
-			log_err(errno, __func__, "choose_procflagsfmt allocation failed");
-			return PBSE_INTERNAL;
-		}
-		if (fscanf(fd, stat_str,
-			   &ps->pid,		/* "%d "	1  pid %d The process id */
-			   path,		/* "(%[^)]) "	2  comm %s The filename of the executable */
-			   &ps->state,		/* "%c "	3  state %c "RSDZTW" */
-			   &ps->ppid,		/* "%d "	4  ppid %d The PID of the parent */
-			   &ps->pgrp,		/* "%d "	5  pgrp %d The process group ID */
-			   &ps->session,	/* "%d "	6  session %d The session ID */
-				   		/* "%*d "	7  ignored:  tty_nr */
-	 		   			/* "%*d "	8  ignored:  tpgid */
-			   &ps->flags,		/* "%u or %lu"	9  flags */
-					   	/* "%*lu "	10 ignored:  minflt */
-					   	/* "%*lu "	11 ignored:  cminflt */
-					   	/* "%*lu "	12 ignored:  majflt */
-					   	/* "%*lu "	13 ignored:  cmajflt */
-			   &ps->utime,		/* "%lu "	14 utime %lu */
-			   &ps->stime,		/* "%lu "	15 stime %lu */
-			   &ps->cutime,		/* "%ld "	16 cutime %ld */
-			   &ps->cstime,		/* "%ld "	17 cstime %ld */
-				   		/* "%*ld "	18 ignored:  priority %ld */
-			   			/* "%*ld "	19 ignored:  nice %ld */
-			   			/* "%*ld "	20 ignored:  num_threads %ld */
-			   			/* "%*ld "	21 ignored:  itrealvalue %ld - no longer maintained */
-			   &starttime,		/* "%llu "	22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
-			   &ps->vsize,		/* "%lu "	23 vsize (bytes) */
-			   &ps->rss		/* "%ld "	24 rss (number of pages) */
-			) != 14) {
+		if (parse_proc_stat(statbuf, ps, path, sizeof(path), &starttime) != 0) {
 			ncantstat++;
-			fclose(fd);
+			close(fd);
 			continue;
 		}
 
-		if (fstat(fileno(fd), &sb) == -1) {
-			fclose(fd);
+		if (fstat(fd, &sb) == -1) {
+			close(fd);
 			continue;
 		}
 		ps->uid = sb.st_uid;
-		fclose(fd);
+		close(fd);
 
 		/*
 		 ** A .pid thread shows the memory of the process
@@ -5691,6 +5838,7 @@ mom_get_sample(void)
 	}
 	if (errno != 0 && errno != ENOENT)
 		log_err(errno, __func__, "readdir");
+	sess_index_build();
 	sampletime_ceil = time_last_sample;
 	sprintf(log_buffer,
 		"nprocs:  %d, cantstat:  %d, nomem:  %d, skipped:  %d, "
@@ -5705,6 +5853,144 @@ mom_get_sample(void)
 	return (PBSE_NONE);
 }
 
+/*
+ * Job cgroups made by the cgroups hook live in
+ * <mount>/<cgroup_prefix>/<jobid> under the cpuacct and memory mounts,
+ * which are found once from /proc/mounts.  A "noprefix" mount drops the
+ * controller name from the file names.
+ */
+static char	*cg_cpu_mnt = NULL;
+static char	*cg_cpu_pfx = "cpuacct.";
+static char	*cg_mem_mnt = NULL;
+static char	*cg_mem_pfx = "memory.";
+static int	cg_mounts_read = 0;
+
+/* what cg_job_usage() found */
+#define	CG_CPUT	0x1
+#define	CG_MEM	0x2
+#define	CG_VMEM	0x4
+
+/**
+ * @brief
+ *	Find the cpuacct and memory cgroup mount points.
+ *
+ * @return	Void
+ *
+ */
+static void
+cg_find_mounts(void)
+{
+	FILE		*fp;
+	struct mntent	*mp;
+
+	cg_mounts_read = 1;
+	if ((fp = setmntent("/proc/mounts", "r")) == NULL)
+		return;
+	while ((mp = getmntent(fp)) != NULL) {
+		if (strcmp(mp->mnt_type, "cgroup") != 0)
+			continue;
+		if ((cg_cpu_mnt == NULL) && (hasmntopt(mp, "cpuacct") != NULL)) {
+			cg_cpu_mnt = strdup(mp->mnt_dir);
+			if (hasmntopt(mp, "noprefix") != NULL)
+				cg_cpu_pfx = "";
+		}
+		if ((cg_mem_mnt == NULL) && (hasmntopt(mp, "memory") != NULL)) {
+			cg_mem_mnt = strdup(mp->mnt_dir);
+			if (hasmntopt(mp, "noprefix") != NULL)
+				cg_mem_pfx = "";
+		}
+	}
+	endmntent(fp);
+}
+
+/**
+ * @brief
+ *	Read the number held in a job cgroup file.
+ *
+ * @param[in]	mnt - controller mount point
+ * @param[in]	jobid - job whose cgroup to read
+ * @param[in]	pfx - file name prefix of the controller
+ * @param[in]	name - file name without its prefix
+ * @param[out]	val - the number
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	no such file or no number in it
+ *
+ */
+static int
+cg_read_num(char *mnt, char *jobid, char *pfx, char *name, long long *val)
+{
+	char	path[MAXPATHLEN+1];
+	char	buf[64];
+	int	fd;
+	ssize_t	len;
+
+	snprintf(path, sizeof(path), "%s/%s/%s/%s%s",
+		mnt, cgroup_prefix, jobid, pfx, name);
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return -1;
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return -1;
+	buf[len] = '\0';
+	if (stat_field(buf, val) == NULL || *val < 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Get the usage the kernel keeps for a job's cgroup.
+ *
+ * @par
+ *	The cgroup counts every process that ever ran in the job, so reading
+ *	it replaces summing over the job's processes.  cput is in seconds,
+ *	mem and vmem are the peak usage in bytes; vmem is memory plus swap and
+ *	is only there when swap accounting is on.
+ *
+ * @param[in]	pjob - job in question
+ * @param[out]	cput - cpu time
+ * @param[out]	mem - peak memory
+ * @param[out]	vmem - peak memory plus swap
+ *
+ * @return	int
+ * @retval	mask of CG_CPUT, CG_MEM and CG_VMEM for the values found
+ *
+ */
+static int
+cg_job_usage(job *pjob, ulong *cput, ulong *mem, ulong *vmem)
+{
+	char		*jobid = pjob->ji_qs.ji_jobid;
+	long long	val;
+	int		found = 0;
+
+	if (!cgroup_accounting)
+		return 0;
+	if (!cg_mounts_read)
+		cg_find_mounts();
+
+	if ((cg_cpu_mnt != NULL) &&
+		(cg_read_num(cg_cpu_mnt, jobid, cg_cpu_pfx, "usage", &val) == 0)) {
+		*cput = (ulong)(val / 1000000000LL);	/* from nanoseconds */
+		found |= CG_CPUT;
+	}
+	if (cg_mem_mnt != NULL) {
+		if (cg_read_num(cg_mem_mnt, jobid, cg_mem_pfx,
+			"max_usage_in_bytes", &val) == 0) {
+			*mem = (ulong)val;
+			found |= CG_MEM;
+		}
+		if (cg_read_num(cg_mem_mnt, jobid, cg_mem_pfx,
+			"memsw.max_usage_in_bytes", &val) == 0) {
+			*vmem = (ulong)val;
+			found |= CG_VMEM;
+		}
+	}
+	return found;
+}
+
 /**
  * @brief
  * 	Update the resources used.<attributes> of a job.
@@ -5718,6 +6004,8 @@ mom_get_sample(void)
  *	If a resource attribute has been set in a mom hook, then its value
  *	will not be updated here. This allows a mom  hook to override
  *	resource value.
+ *	When the job has a cgroup from the cgroups hook, cput, mem and vmem
+ *	come from the cgroup's counters instead of the job's processes.
  *
  * @return int
  * @retval PBSE_NONE	for success.
@@ -5733,6 +6021,8 @@ mom_set_use(job *pjob)
 	u_Long 		*lp_sz, lnum_sz;
 	ulong		*lp, lnum, oldcput;
 	long		ncpus_req;
+	ulong		cg_cput = 0, cg_mem = 0, cg_vmem = 0;
+	int		cg;
 
 	assert(pjob != NULL);
 	at = &pjob->ji_wattr[(int)JOB_ATR_resc_used];
@@ -5745,6 +6035,8 @@ mom_set_use(job *pjob)
 
 	at->at_flags |= (ATR_VFLAG_MODIFY|ATR_VFLAG_SET);
 
+	cg = cg_job_usage(pjob, &cg_cput, &cg_mem, &cg_vmem);
+
 	rd = find_resc_def(svr_resc_def, "ncpus", svr_resc_size);
 	assert(rd != NULL);
 	pres = find_resc_entry(at, rd);
@@ -5780,7 +6072,10 @@ mom_set_use(job *pjob)
 	}
 	lp = (ulong *)&pres->rs_value.at_val.at_long;
 	oldcput = *lp;
+	/* cput_sum() also notices tasks whose processes are all gone */
 	lnum = cput_sum(pjob);
+	if (cg & CG_CPUT)
+		lnum = (ulong)((double)cg_cput * cputfactor);
 	lnum = MAX(*lp, lnum);
 	if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		/* don't conflict with hook setting a value */
@@ -5814,7 +6109,10 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (mem_sum(pjob) + 1023) >> 10;		/* as KB */
+		if (cg & CG_VMEM)
+			lnum_sz = (cg_vmem + 1023) >> 10;	/* as KB */
+		else
+			lnum_sz = (mem_sum(pjob) + 1023) >> 10;	/* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
 	}
 
@@ -5832,7 +6130,10 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
+		if (cg & CG_MEM)
+			lnum_sz = (cg_mem + 1023) >> 10;	/* as KB */
+		else
+			lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
 	}
 
@@ -6129,11 +6430,9 @@ cput_job(pid_t jobid)
 	proc_stat_t	*ps;
 
 	cputime = 0.0;
-	for (i=0; i<nproc; i++) {
+	for (i = sess_next(-1, jobid); i != -1; i = sess_next(i, jobid)) {
 
 		ps = &proc_info[i];
-		if (jobid != ps->session)
-			continue;
 
 		found = 1;
 		addtime = dsecs(ps->cutime) + dsecs(ps->cstime);
@@ -6252,12 +6551,9 @@ mem_job(pid_t sid)
 	memsize = 0;
 
 	mom_get_sample();
-	for (i=0; i<nproc; i++) {
+	for (i = sess_next(-1, sid); i != -1; i = sess_next(i, sid)) {
 
 		ps = &proc_info[i];
-
-		if (sid != ps->session)
-			continue;
 		memsize += ps->vsize;
 	}
 
@@ -6369,13 +6665,10 @@ resi_job(pid_t jobid)
 	resisize = 0;
 	mom_get_sample();
 
-	for (i=0; i<nproc; i++) {
+	for (i = sess_next(-1, jobid); i != -1; i = sess_next(i, jobid)) {
 
 		ps = &proc_info[i];
 
-		if (jobid != ps->session)
-			continue;
-
 		found = 1;
 		/*
 		 *	Certain Altix ProPack releases (or patches) add an
@@ -6825,138 +7118,6 @@ availmem(struct rm_attribute *attrib)
 	return ret_string;
 }
 
-/**
- * @brief	find and remember the current Linux release number
- * @param[in]	struct utsname *
- *
- * @return	value returned by uname(2)'s utsname release[] member
- */
-static char *
-uname2release(struct utsname *u)
-{
-	static char	*u_release = NULL;
-
-	if (u_release != NULL)
-		return (u_release);
-	else if ((u_release = malloc(strlen(u->release) + 1)) != NULL) {
-		memcpy(u_release, u->release, strlen(u->release) + 1);
-		sprintf(log_buffer, "uname release:  %s", u_release);
-		log_event(PBSEVENT_DEBUG4, 0, LOG_DEBUG, __func__, log_buffer);
-		return (u_release);
-	} else
-		return NULL;
-}
-
-/**
- * @brief	choose the format for the /proc "flags" field
- * @param[in]	release
- * @param[out]	stdio format string
- *
- * @return	"%lu" for /proc before Linux version 2.6.22
- * @return	"%u" for  /proc Linux version 2.6.22 and later
- * *
- * @note	To derive release information, we're at the mercy of whoever
- *		configures the kernel's UTS_RELEASE value when it's built.
- *		We hope that the version information is in the format
- *		<major>.<minor>.<micro>, or - if not - that at least we can
- *		depend on sscanf() to throw away extraneous characters and
- *		derive a number for the "micro" version that can be used to
- *		leverage proc(5)'s "%u (%lu before Linux 2.6.22)" flags
- *		field format specification.
- *
- *		This code is not designed to work for Linux versions < 2.
- *
- * @par MT-Safe:	yes
- */
-static char *
-procflagsfmt(char *release)
-{
-	char	*p;
-	char	*ver_begin = release;
-	char	rfseparator_dot = '.';
-	char	rfseparator_dash = '-';
-	int	nseparators_seen = 0;
-	int	major, minor, micro, ver;
-	static char	before[] = "%lu";
-	static char	after[] = "%u";
-
-	for (p = release; *p != '\0'; p++) {
-		if ((*p == rfseparator_dot) || (*p == rfseparator_dash)) {
-			p++;
-			if (sscanf(ver_begin, "%d", &ver) == 1) {
-				if (nseparators_seen == 0) {
-					major = ver;
-					if (major > 2)
-						return (after);
-				} else if (nseparators_seen == 1) {
-					minor = ver;
-					if (minor > 6)
-						return (after);
-				} else {
-					micro = ver;
-					 /* "flags %u (%lu before Linux 2.6.22)" */
-					if ((minor == 6) && (micro >= 22))
-						return (after);
-					else
-						return (before);
-				}
-			}
-			ver_begin = p;
-			nseparators_seen++;
-		}
-	}
-
-	return NULL;
-}
-
-/**
- * @brief	return the stdio format directive for the /proc flags field
- *
- * @param[out]	format string for the /proc flags field
- *
- * @return	static char *
- *
- * @see	procflagsfmt
- * @see	uname2release
- */
-static char *
-choose_procflagsfmt(void)
-{
-	char		buf[1024];
-	static char	*fmtstr = NULL;
-	static int	initialized = 0;
-	struct utsname	u;
-
-	if (initialized)
-		return (fmtstr);
-
-	if (uname(&u) == -1) {
-		log_err(errno, __func__, "uname");
-		return NULL;
-	} else {
-		char	*release;
-		char	*fffs;		/* the flags field format string */
-
-		if ((release = uname2release(&u)) == NULL) {
-			log_err(-1, __func__, "uname2release returned NULL");
-			return NULL;
-		}
-		else if ((fffs = procflagsfmt(release)) == NULL) {
-			log_err(-1, __func__, "procflagsfmt returned NULL");
-			return NULL;
-		} else {
-			sprintf(buf, stat_str_pre, fffs);
-			if ((fmtstr = strdup(buf)) == NULL) {
-				log_err(-1, __func__, "strdup returned NULL");
-				return NULL;
-			} else {
-				initialized = 1;
-				return (fmtstr);
-			}
-		}
-	}
-}
-
 #else	/* PBSMOM_HTUNIT */
 
 /*
@@ -144,8 +144,6 @@ extern	int		num_acpus;
 extern	int		num_pcpus;
 extern	int		svr_delay_entry;
 
-extern	pbs_list_head	task_list_event;
-
 #if	MOM_CPUSET || MOM_ALPS
 extern	char		*path_jobs;
 char *get_versioned_libname(int sotype);
@@ -2433,15 +2431,11 @@ scan_for_terminated(void)
 
 
 		/* Check for other task lists */
-		wtask = (struct work_task *)GET_NEXT(task_list_event);
-		while (wtask) {
-			if ((wtask->wt_type == WORK_Deferred_Child) &&
-				(wtask->wt_event == pid)) {
-				wtask->wt_type = WORK_Deferred_Cmp;
-				wtask->wt_aux = (int)exiteval; /* exit status */
-				svr_delay_entry++;	/* see next_task() */
-			}
-			wtask = (struct work_task *)GET_NEXT(wtask->wt_linkall);
+		while ((wtask = find_work_task(WORK_Deferred_Child,
+			(long)pid, NULL)) != NULL) {
+			wtask->wt_type = WORK_Deferred_Cmp;
+			wtask->wt_aux = (int)exiteval; /* exit status */
+			svr_delay_entry++;	/* see next_task() */
 		}
 
 		pjob = (job *)GET_NEXT(svr_alljobs);
@@ -54,6 +54,10 @@
 
 #include <memory.h>
 #include <fcntl.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -89,6 +93,13 @@
 
 /* Global Data items */
 static int	run_exit = 0;	/* run exit of child */
+#ifndef WIN32
+static pid_t	hook_pool_pid = 0;	/* pbs_python --hook-pool */
+static time_t	hook_pool_started = 0;
+#define	HOOK_POOL_RETRY	60	/* seconds before restarting a dead pool */
+extern int	hook_pool_enabled;
+extern pid_t	mom_pid;
+#endif
 
 extern int       resc_access_perm;
 extern	char		*path_hooks;
@@ -613,6 +624,136 @@ vnl_add_vnode_entries(vnl_t *vnl, vmpiprocs *vnode_entry, int num_vnodes,
 	return (0);
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	Make sure the pbs_python hook pool is running, starting it if not.
+ *	A pool that died is not restarted until HOOK_POOL_RETRY seconds
+ *	after it was started, so one that can not come up costs little.
+ *
+ * @param[in] pypath - path to pbs_python
+ *
+ * @return int
+ * @retval 0	the pool is, or is being, started
+ * @retval -1	could not start it
+ *
+ */
+static int
+hook_pool_check(char *pypath)
+{
+	char	sockpath[MAXPATHLEN+1];
+	pid_t	pid;
+	int	fd;
+
+	if ((hook_pool_pid > 0) && (kill(hook_pool_pid, 0) == 0))
+		return 0;
+	if ((hook_pool_started != 0) &&
+		(time_now < hook_pool_started + HOOK_POOL_RETRY))
+		return -1;
+
+	snprintf(sockpath, sizeof(sockpath), FMT_HOOK_POOL_SOCK,
+		path_hooks_workdir);
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork");
+		hook_pool_pid = 0;
+		return -1;
+	}
+	if (pid == 0) {
+		(void)setsid();
+		fd = sysconf(_SC_OPEN_MAX);
+		while (--fd > 2)
+			(void)close(fd);
+		if (pbs_conf.pbs_conf_file != NULL)
+			(void)setenv("PBS_CONF_FILE", pbs_conf.pbs_conf_file, 1);
+		(void)unsetenv(PBS_HOOK_CONFIG_FILE);
+		execl(pypath, pypath, HOOK_POOL_MODE, sockpath, NULL);
+		_exit(1);
+	}
+	hook_pool_pid = pid;
+	hook_pool_started = time_now;
+	snprintf(log_buffer, sizeof(log_buffer),
+		"started hook pool pid=%d", (int)pid);
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK, LOG_INFO,
+		__func__, log_buffer);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Have the hook pool run pbs_python with args, in place of exec'ing
+ *	it, and exit with the hook's status.
+ *
+ * @par
+ *	Called in the child forked by run_hook().  If the pool can not take
+ *	the request, e.g. it has not finished starting, this returns and the
+ *	caller execs pbs_python as before.  Once the request is sent, the
+ *	result is the pool's.
+ *
+ * @param[in] args - pbs_python arguments, NULL terminated
+ * @param[in] hook_config - hook config file, "" if none
+ *
+ * @return Void, only returns if the pool did not take the request
+ *
+ */
+static void
+hook_pool_run(char **args, char *hook_config)
+{
+	struct sockaddr_un	addr;
+	char			req[HOOK_POOL_MAXREQ];
+	char			cwd[MAXPATHLEN+1];
+	char			*p;
+	int			len = 0;
+	int			fd;
+	int			i;
+	int			status;
+	size_t			n;
+	ssize_t			got;
+
+	if (getcwd(cwd, sizeof(cwd)) == NULL)
+		return;
+	for (i = -2; (i < 0) || (args[i] != NULL); i++) {
+		p = (i == -2) ? cwd : ((i == -1) ? hook_config : args[i]);
+		n = strlen(p) + 1;
+		if (len + n > sizeof(req))
+			return;
+		memcpy(req + len, p, n);
+		len += n;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), FMT_HOOK_POOL_SOCK,
+		path_hooks_workdir);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return;
+	if ((connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) ||
+		(write(fd, &len, sizeof(len)) != sizeof(len)) ||
+		(write(fd, req, len) != len)) {
+		(void)close(fd);
+		return;
+	}
+
+	p = (char *)&status;
+	for (n = 0; n < sizeof(status); n += got) {
+		got = read(fd, p + n, sizeof(status) - n);
+		if ((got == -1) && (errno == EINTR)) {
+			got = 0;
+			continue;
+		}
+		if (got <= 0) {
+			log_err(-1, __func__, "hook pool did not return a status");
+			exit(255);
+		}
+	}
+	if (WIFSIGNALED(status)) {
+		(void)signal(WTERMSIG(status), SIG_DFL);
+		(void)kill(getpid(), WTERMSIG(status));
+	}
+	exit(WIFEXITED(status) ? WEXITSTATUS(status) : 255);
+}
+#endif	/* !WIN32 */
+
 /**
  * @brief
  *	Runs the hook 'phook' in a child process in response to 'event_type'
@@ -694,6 +835,9 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 	char		*pc;
 	int		keeping = 0;
 	char		*std_file = NULL;
+#ifndef WIN32
+	int		use_pool = 0;
+#endif
 
 	if ((phook == NULL) || (req_user == NULL) || (req_host == NULL)) {
 		log_err(-1, __func__, "Bad input received!");
@@ -757,6 +901,10 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 		runas_jobuser = 1;
 
 #ifndef WIN32
+	/* hooks run as root from MoM itself can go to the hook pool */
+	if (hook_pool_enabled && !runas_jobuser && (getpid() == mom_pid))
+		use_pool = (hook_pool_check(pypath) == 0);
+
 	child = fork();
 	if (child > 0) {	/* parent */
 
@@ -1331,6 +1479,9 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 		}
 	}
 
+	if (use_pool)
+		hook_pool_run(arg, hook_config_path);
+
 	execve(pypath, arg, environ);
 run_hook_exit:
 	if (fp != NULL) {
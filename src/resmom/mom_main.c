@@ -188,12 +188,22 @@ extern void	mom_vnlp_report(vnl_t *vnl, char *header);
 
 int		alien_attach = 0;		/* attach alien procs */
 int		alien_kill = 0;			/* kill alien procs */
+#ifndef	WIN32
+int		hook_pool_enabled = 1;		/* run hooks via pbs_python pool */
+#endif
+#ifdef	linux
+int		cgroup_accounting = 1;		/* read usage from job cgroups */
+char		cgroup_prefix[PBS_MAXHOSTNAME+1] = "pbspro";
+#endif	/* linux */
 #if	defined(MOM_CPUSET) && (CPUSET_VERSION >= 4)
 char		*cpuset_error_action = "offline";
 #endif	/* MOM_CPUSET && CPUSET_VERSION >= 4 */
 int		lockfds;
 float		max_load_val   = -1.0;
 int		max_poll_downtime_val = PBS_MAX_POLL_DOWNTIME;
+float		resc_update_threshold = 0.0;	/* percent change worth an update */
+int		resc_update_full = PBS_RESC_UPDATE_FULL;
+int		rused_full_gen = 0;	/* bumped to resend all resources_used */
 char	       *mom_domain;
 char           *mom_home;
 char		mom_host[PBS_MAXHOSTNAME+1];
@@ -472,6 +482,13 @@ static handler_ret_t	set_alps_confirm_switch_timeout(char *);
 static handler_ret_t	set_attach_allow(char *);
 static handler_ret_t	set_checkpoint_path(char *);
 static handler_ret_t	set_enforcement(char *);
+#ifdef	linux
+static handler_ret_t	set_cgroup_accounting(char *);
+static handler_ret_t	set_cgroup_prefix(char *);
+#endif	/* linux */
+#ifndef	WIN32
+static handler_ret_t	set_hook_pool(char *);
+#endif
 static handler_ret_t	set_jobdir_root(char *);
 static handler_ret_t	set_kbd_idle(char *);
 static handler_ret_t	set_max_check_poll(char *);
@@ -481,6 +498,8 @@ static handler_ret_t	set_momport(char *);
 #ifdef	WIN32
 static handler_ret_t	set_nrun_factor(char *);
 #endif
+static handler_ret_t	set_resc_update_full(char *);
+static handler_ret_t	set_resc_update_threshold(char *);
 static handler_ret_t	set_restart_background(char *);
 static handler_ret_t	set_restart_transmogrify(char *);
 static handler_ret_t	set_restrict_user(char *);
@@ -539,6 +558,10 @@ static struct	specials {
 #if	MOM_BGL
 	{ "bgl_reserve_partitions",	set_bgl_reserve_partitions },
 #endif	/* MOM_BGL */
+#ifdef	linux
+	{ "cgroup_accounting",		set_cgroup_accounting },
+	{ "cgroup_prefix",		set_cgroup_prefix },
+#endif	/* linux */
 	{ "checkpoint_path",		set_checkpoint_path },
 #if	defined(__sgi)
 	{ "checkpoint_upgrade",		set_checkpoint_upgrade },
@@ -550,6 +573,9 @@ static struct	specials {
 	{ "cpuset_error_action",	set_cpuset_error_action },
 #endif	/* MOM_CPUSET && CPUSET_VERSION >= 4 */
 	{ "enforce",			set_enforcement },
+#ifndef	WIN32
+	{ "hook_pool",			set_hook_pool },
+#endif
 	{ "ideal_load",			setidealload },
 	{ "jobdir_root",		set_jobdir_root },
 	{ "kbd_idle",			set_kbd_idle },
@@ -564,6 +590,8 @@ static struct	specials {
 #endif
 	{ "port",			set_momport },
 	{ "prologalarm",		prologalarm },
+	{ "resc_update_full",		set_resc_update_full },
+	{ "resc_update_threshold",	set_resc_update_threshold },
 	{ "restart_background",		set_restart_background },
 	{ "restart_transmogrify",	set_restart_transmogrify },
 	{ "restrict_user",		set_restrict_user },
@@ -3610,6 +3638,80 @@ set_tmpdir(char *value)
 	return HANDLER_SUCCESS;
 }
 
+#ifndef	WIN32
+/**
+ * @brief
+ *	process $hook_pool directive in config file:
+ *	$hook_pool <true|false>
+ *
+ *	When true, hooks that run as root are handed to a long running
+ *	pbs_python rather than each exec'ing its own.
+ *
+ * @param[in] value - boolean value
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_FAIL            Failure
+ * @retval      HANDLER_SUCCESS         Success
+ *
+ */
+static handler_ret_t
+set_hook_pool(char *value)
+{
+	return (set_boolean(__func__, value, &hook_pool_enabled));
+}
+#endif	/* !WIN32 */
+
+#ifdef	linux
+/**
+ * @brief
+ *	process $cgroup_accounting directive in config file:
+ *	$cgroup_accounting <true|false>
+ *
+ *	When true, cput and mem of a job that has its own cgroup are read
+ *	from the cgroup rather than summed over the job's processes.
+ *
+ * @param[in] value - boolean value
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_FAIL            Failure
+ * @retval      HANDLER_SUCCESS         Success
+ *
+ */
+static handler_ret_t
+set_cgroup_accounting(char *value)
+{
+	return (set_boolean(__func__, value, &cgroup_accounting));
+}
+
+/**
+ * @brief
+ *	process $cgroup_prefix directive in config file:
+ *	$cgroup_prefix pbspro
+ *
+ *	Names the directory under each cgroup mount that holds the job
+ *	cgroups; it must match cgroup_prefix of the cgroups hook.
+ *
+ * @param[in] value - directory name
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_FAIL            Failure
+ * @retval      HANDLER_SUCCESS         Success
+ *
+ */
+static handler_ret_t
+set_cgroup_prefix(char *value)
+{
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,
+		LOG_INFO, __func__, value);
+	if ((value == NULL) || (*value == '\0') ||
+		(strchr(value, '/') != NULL) ||
+		(strlen(value) > sizeof(cgroup_prefix) - 1))
+		return HANDLER_FAIL;
+	strcpy(cgroup_prefix, value);
+	return HANDLER_SUCCESS;
+}
+#endif	/* linux */
+
 /**
  * @brief
  *      sets job dirctory
@@ -3773,6 +3875,48 @@ set_float(const char *id, char *value, float *var)
 	return HANDLER_SUCCESS;
 }
 
+/**
+ * @brief
+ *	process $resc_update_threshold directive in config file:
+ *	$resc_update_threshold 5
+ *
+ *	Periodic resources_used updates to the server leave out a numeric
+ *	value that changed by this percent or less since it was last sent.
+ *
+ * @param[in] value - value for threshold, in percent
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_FAIL            Failure
+ * @retval      HANDLER_SUCCESS         Success
+ *
+ */
+static handler_ret_t
+set_resc_update_threshold(char *value)
+{
+	return (set_float(__func__, value, &resc_update_threshold));
+}
+
+/**
+ * @brief
+ *	process $resc_update_full directive in config file:
+ *	$resc_update_full 10
+ *
+ *	Every this many periodic resources_used updates, a job's update
+ *	carries all of its values whether or not they changed.
+ *
+ * @param[in] value - number of update cycles
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_FAIL            Failure
+ * @retval      HANDLER_SUCCESS         Success
+ *
+ */
+static handler_ret_t
+set_resc_update_full(char *value)
+{
+	return (set_int(__func__, value, &resc_update_full));
+}
+
 /**
  * @brief
  *	Set the configuration flag that defines whether the restart nunction
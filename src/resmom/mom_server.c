@@ -101,6 +101,7 @@ extern	char		*path_jobs;
 extern	int		pbs_errno;
 extern	int		next_sample_time;
 extern	int		min_check_poll;
+extern	int		rused_full_gen;
 extern	unsigned int	pbs_mom_port;
 extern	unsigned int	pbs_rm_port;
 extern	unsigned int	pbs_tm_port;
@@ -928,6 +929,7 @@ is_request(int stream, int version)
 			 * does "vnodes".
 			 */
 			server_stream = stream;		/* save stream to server */
+			rused_full_gen++;		/* server needs all resources_used again */
 			next_sample_time = min_check_poll;
 			reply_hello4(stream);
 			internal_state_update = UPDATE_MOM_STATE;
@@ -941,6 +943,7 @@ is_request(int stream, int version)
 			DBPRT(("%s: IS_HELLO_NO_INVENTORY, state=0x%x stream=%d\n", __func__,
 				internal_state, stream))
 			server_stream = stream;         /* save stream to server */
+			rused_full_gen++;
 			next_sample_time = min_check_poll;
 			reply_hello4(stream);
 			internal_state_update = UPDATE_MOM_STATE;
@@ -59,8 +59,13 @@
 
 /* usage file "magic number" - needs to be 8 chars */
 #define USAGE_MAGIC "PBS_MAG!"
+#ifdef WIN32
 #define USAGE_VERSION 2
+#else
+#define USAGE_VERSION 3		/* mapped hash table, see group_node_usage_v3_head */
+#endif
 #define USAGE_NAME_MAX 50
+#define USAGE_MIN_SLOTS 1024	/* smallest hash table in a version 3 usage file */
 
 #define UNKNOWN_GROUP_NAME "unknown"
 
@@ -143,6 +148,7 @@
 #define PARSE_STRICT_ORDERING "strict_ordering"
 #define PARSE_RES_UNSET_INFINITE "resource_unset_infinite"
 #define PARSE_SELECT_PROVISION "provision_policy"
+#define PARSE_ARRAY_BATCH_SIZE "array_batch_size"
 
 #ifdef NAS
 /* localmod 034 */
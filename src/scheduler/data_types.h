@@ -892,6 +892,19 @@ struct group_node_usage_v2
 	usage_t usage;
 };
 
+/* Usage file version 3 is this header followed by an open addressing hash
+ * table of nslots group_node_usage_v2 slots keyed on the entity name.  An
+ * empty name marks a free slot.  The scheduler keeps the file mapped and
+ * updates the usage of the entities in place.
+ */
+struct group_node_usage_v3_head
+{
+	struct group_node_header head;
+	time_t last_decay;	/* time of the last decay of the tree */
+	int nslots;		/* number of slots, a power of 2 */
+	int nused;		/* number of slots in use */
+};
+
 struct usage_info
 {
 	char *name;			/* name of the user */
@@ -1058,6 +1071,7 @@ struct config
 	int preempt_queue_prio;			/* Queue priority that defines an express queue */
 	int max_preempt_attempts;		/* max num of preempt attempts per cyc*/
 	int max_jobs_to_check;			/* max number of jobs to check in cyc*/
+	int array_batch_size;			/* max subjobs of an array run in a row */
 	long dflt_opt_backfill_fuzzy;		/* default time for the fuzzy backfill optimization */
 	char ded_prefix[PBS_MAXQUEUENAME +1];	/* prefix to dedicated queues */
 	char pt_prefix[PBS_MAXQUEUENAME +1];	/* prefix to primetime queues */
@@ -57,11 +57,20 @@
  * 	decay_fairshare_tree()
  * 	compare_path()
  * 	print_fairshare()
+ * 	usage_hash()
+ * 	usage_map_find()
+ * 	usage_map_close()
+ * 	usage_map_open()
+ * 	usage_map_build()
+ * 	rec_update_usage()
+ * 	count_usage_entities()
  * 	write_usage()
  * 	rec_write_usage()
  * 	read_usage()
  * 	read_usage_v1()
  * 	read_usage_v2()
+ * 	read_usage_v3()
+ * 	load_entity_usage()
  * 	new_group_path()
  * 	free_group_path_list()
  * 	create_group_path()
@@ -81,6 +90,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/param.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 #include <log.h>
 
@@ -103,6 +120,24 @@
 
 extern time_t last_decay;
 
+static void load_entity_usage(struct group_node_usage_v2 *grp, int flags, group_info *root);
+#ifndef WIN32
+static int read_usage_v3(int flags, group_info *root);
+#endif
+
+#ifndef WIN32
+/* the version 3 usage file this process has mapped */
+static struct {
+	char *addr;		/* start of the mapping, NULL if none */
+	size_t len;		/* length of the mapping */
+	dev_t dev;		/* device and inode of the file, to notice */
+	ino_t ino;		/* when it is replaced (e.g. by pbsfs) */
+} usage_map = {NULL, 0, 0, 0};
+
+#define USAGE_MAP_HEAD	((struct group_node_usage_v3_head *)usage_map.addr)
+#define USAGE_MAP_SLOTS	((struct group_node_usage_v2 *)(USAGE_MAP_HEAD + 1))
+#endif
+
 /**
  * @brief
  *		add_child - add a group_info to the resource group tree
@@ -585,6 +620,269 @@ compare_path(struct group_path *gp1, struct group_path *gp2)
 	return rc;
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *		usage_hash - hash of an entity name for the version 3 usage file
+ *
+ * @param[in]	name	-	entity name, at most USAGE_NAME_MAX characters are used
+ *
+ * @return	the hash
+ */
+static unsigned int
+usage_hash(char *name)
+{
+	unsigned int h = 5381;
+	int i;
+
+	for (i = 0; i < USAGE_NAME_MAX && name[i] != '\0'; i++)
+		h = h * 33 + (unsigned char)name[i];
+	return h;
+}
+
+/**
+ * @brief
+ *		usage_map_find - find the slot of an entity in the mapped usage file
+ *
+ * @param[in]	name	-	entity name
+ * @param[in]	alloc	-	add the entity if it is not there yet
+ *
+ * @return	struct group_node_usage_v2 *
+ * @retval	the slot of the entity
+ * @retval	NULL	: not found, or no room to add it without growing the table
+ */
+static struct group_node_usage_v2 *
+usage_map_find(char *name, int alloc)
+{
+	struct group_node_usage_v3_head *uh = USAGE_MAP_HEAD;
+	struct group_node_usage_v2 *slots = USAGE_MAP_SLOTS;
+	unsigned int mask = uh->nslots - 1;
+	unsigned int i;
+	int n;
+	size_t len;
+
+	for (i = usage_hash(name) & mask, n = 0; n < uh->nslots; i = (i + 1) & mask, n++) {
+		if (slots[i].name[0] == '\0')
+			break;
+		if (strncmp(slots[i].name, name, USAGE_NAME_MAX) == 0)
+			return &slots[i];
+	}
+	/* keep the table at most half full so that probes stay short */
+	if (!alloc || n == uh->nslots || (uh->nused + 1) * 2 > uh->nslots)
+		return NULL;
+
+	len = strlen(name);
+	if (len > USAGE_NAME_MAX)
+		len = USAGE_NAME_MAX;
+	memset(slots[i].name, 0, USAGE_NAME_MAX);
+	memcpy(slots[i].name, name, len);
+	slots[i].usage = 1;
+	uh->nused++;
+	return &slots[i];
+}
+
+/**
+ * @brief
+ *		usage_map_close - unmap the mapped usage file, if any
+ *
+ * @return	void
+ */
+static void
+usage_map_close(void)
+{
+	if (usage_map.addr != NULL) {
+		(void)munmap(usage_map.addr, usage_map.len);
+		usage_map.addr = NULL;
+		usage_map.len = 0;
+	}
+}
+
+/**
+ * @brief
+ *		usage_map_open - map a version 3 usage file for reading and
+ *		in place updates, unmapping the previous one
+ *
+ * @param[in]	filename	-	usage file
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: the file does not exist or is not a valid version 3 file
+ */
+static int
+usage_map_open(char *filename)
+{
+	struct group_node_usage_v3_head *uh;
+	struct stat sb;
+	char *addr;
+	int fd;
+
+	usage_map_close();
+
+	if ((fd = open(filename, O_RDWR)) == -1)
+		return 0;
+	if (fstat(fd, &sb) == -1 || sb.st_size < sizeof(struct group_node_usage_v3_head)) {
+		close(fd);
+		return 0;
+	}
+	addr = mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+		return 0;
+
+	uh = (struct group_node_usage_v3_head *)addr;
+	if (strncmp(uh->head.tag, USAGE_MAGIC, sizeof(uh->head.tag)) != 0 ||
+		uh->head.version != 3 ||
+		uh->nslots <= 0 || (uh->nslots & (uh->nslots - 1)) != 0 ||
+		uh->nused < 0 || uh->nused >= uh->nslots ||
+		sb.st_size < sizeof(struct group_node_usage_v3_head) +
+		(size_t)uh->nslots * sizeof(struct group_node_usage_v2)) {
+		(void)munmap(addr, sb.st_size);
+		return 0;
+	}
+
+	usage_map.addr = addr;
+	usage_map.len = sb.st_size;
+	usage_map.dev = sb.st_dev;
+	usage_map.ino = sb.st_ino;
+	return 1;
+}
+
+/**
+ * @brief
+ *		rec_update_usage - recursive helper function which will update the
+ *			  usage of all the entities of the resgroup tree in
+ *			  the mapped usage file
+ *
+ * @param[in]	root	-	the root of the current subtree
+ * @param[out]	full	-	set to 1 if an entity did not fit in the table
+ * @param[out]	found	-	incremented for each entity which has a slot
+ *
+ * @return nothing
+ *
+ */
+static void
+rec_update_usage(group_info *root, int *full, int *found)
+{
+	struct group_node_usage_v2 *grp;
+
+	if (root == NULL)
+		return;
+
+	/* only the leaves of the tree (fairshare entities) are kept.  Usage
+	 * defaults to 1, so an entity is only added once its usage differs,
+	 * but an entity already in the file is updated back to 1.
+	 */
+#ifdef NAS /* localmod 043 */
+	if (root->child == NULL) {
+		grp = usage_map_find(root->name, 1);
+#else
+	if (root->child == NULL && strcmp(root->name, UNKNOWN_GROUP_NAME) != 0) {
+		grp = usage_map_find(root->name, root->usage != 1);
+#endif /* localmod 043 */
+		if (grp != NULL) {
+			grp->usage = root->usage;
+			(*found)++;
+		} else if (root->usage != 1)
+			*full = 1;
+	}
+
+	rec_update_usage(root->sibling, full, found);
+	rec_update_usage(root->child, full, found);
+}
+
+/**
+ * @brief
+ *		count_usage_entities - count the leaves of the resgroup tree
+ *
+ * @param[in]	root	-	the root of the current subtree
+ *
+ * @return	the number of leaves
+ */
+static int
+count_usage_entities(group_info *root)
+{
+	if (root == NULL)
+		return 0;
+
+	return (root->child == NULL) + count_usage_entities(root->sibling) +
+		count_usage_entities(root->child);
+}
+
+/**
+ * @brief
+ *		usage_map_build - write a new version 3 usage file for the
+ *		resgroup tree, sized for twice its entities, and map it
+ *
+ * @param[in]	filename	-	usage file
+ * @param[in]	fhead	-	Pointer to fairshare_head structure.
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+usage_map_build(char *filename, fairshare_head *fhead)
+{
+	char tmpname[MAXPATHLEN + 1];
+	struct group_node_usage_v3_head *uh;
+	struct stat sb;
+	size_t len;
+	char *addr;
+	int nslots = USAGE_MIN_SLOTS;
+	int nent;
+	int full = 0;
+	int found = 0;
+	int fd;
+
+	usage_map_close();
+
+	nent = count_usage_entities(fhead->root);
+	while (nslots < 2 * (nent + 1))
+		nslots *= 2;
+	len = sizeof(struct group_node_usage_v3_head) +
+		(size_t)nslots * sizeof(struct group_node_usage_v2);
+
+	snprintf(tmpname, sizeof(tmpname), "%s.new", filename);
+	if ((fd = open(tmpname, O_RDWR | O_CREAT | O_TRUNC, 0666)) == -1) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Error opening file %.*s", LOG_BUF_SIZE - 32, tmpname);
+		log_err(errno, "write_usage", log_buffer);
+		return 0;
+	}
+	if (ftruncate(fd, len) == -1 || fstat(fd, &sb) == -1 ||
+		(addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Error writing file %.*s", LOG_BUF_SIZE - 32, tmpname);
+		log_err(errno, "write_usage", log_buffer);
+		close(fd);
+		unlink(tmpname);
+		return 0;
+	}
+	close(fd);
+
+	/* the file is zero filled: all slots are free */
+	uh = (struct group_node_usage_v3_head *)addr;
+	strcpy(uh->head.tag, USAGE_MAGIC);
+	uh->head.version = 3;
+	uh->last_decay = fhead->last_decay;
+	uh->nslots = nslots;
+	uh->nused = 0;
+
+	usage_map.addr = addr;
+	usage_map.len = len;
+	usage_map.dev = sb.st_dev;
+	usage_map.ino = sb.st_ino;
+	rec_update_usage(fhead->root, &full, &found);
+
+	if (msync(addr, len, MS_SYNC) == -1 || rename(tmpname, filename) == -1) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Error writing file %s", filename);
+		log_err(errno, "write_usage", log_buffer);
+		usage_map_close();
+		unlink(tmpname);
+		return 0;
+	}
+	return 1;
+}
+#endif /* WIN32 */
+
 /**
  * @brief
  *		write_usage - write the usage information to the usage file
@@ -599,8 +897,14 @@ compare_path(struct group_path *gp1, struct group_path *gp2)
 int
 write_usage(char *filename, fairshare_head *fhead)
 {
+#ifndef WIN32
+	struct stat sb;
+	int full = 0;
+	int found = 0;
+#else
 	FILE *fp;		/* file pointer to usage file */
 	struct group_node_header head;
+#endif
 
 	if (fhead == NULL)
 		return 0;
@@ -608,6 +912,32 @@ write_usage(char *filename, fairshare_head *fhead)
 	if (filename == NULL)
 		filename = USAGE_FILE;
 
+#ifndef WIN32
+	/* version 3: update the usage in place in the mapped file, unless
+	 * the file was replaced or removed under us.  The whole file is only
+	 * written again when there is no (valid) file or the table is full.
+	 */
+	if (usage_map.addr == NULL || stat(filename, &sb) == -1 ||
+		sb.st_dev != usage_map.dev || sb.st_ino != usage_map.ino) {
+		if (!usage_map_open(filename))
+			return usage_map_build(filename, fhead);
+	}
+
+	USAGE_MAP_HEAD->last_decay = fhead->last_decay;
+	rec_update_usage(fhead->root, &full, &found);
+	/* rebuild if the table is full, or if slots are held by entities
+	 * which are no longer in the tree, e.g. trimmed by pbsfs -e
+	 */
+	if (full || found < USAGE_MAP_HEAD->nused)
+		return usage_map_build(filename, fhead);
+
+	if (msync(usage_map.addr, usage_map.len, MS_ASYNC) == -1) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Error writing file %s", filename);
+		log_err(errno, "write_usage", log_buffer);
+		return 0;
+	}
+	return 1;
+#else
 	if ((fp = fopen(filename, "wb")) == NULL) {
 		sprintf(log_buffer, "Error opening file %s", filename);
 		log_err(errno, "write_usage", log_buffer);
@@ -630,6 +960,7 @@ write_usage(char *filename, fairshare_head *fhead)
 	rec_write_usage(fhead->root, fp);
 	fclose(fp);
 	return 1;
+#endif /* WIN32 */
 }
 
 /**
@@ -696,6 +1027,11 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
 	if (filename == NULL)
 		filename = USAGE_FILE;
 
+#ifndef WIN32
+	/* the file may have been replaced since it was mapped, e.g. by pbsfs */
+	usage_map_close();
+#endif
+
 	if ((fp = fopen(filename, "r")) == NULL) {
 		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING, "fairshare usage",
 			"Creating usage database for fairshare");
@@ -717,6 +1053,19 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
 				if (!error)
 					read_usage_v2(fp, flags, fhead->root);
 			}
+#ifndef WIN32
+			else if (head.version == 3) {
+				if (usage_map_open(filename)) {
+					last = USAGE_MAP_HEAD->last_decay;
+					if (last == 0 || last > 946713600) {
+						fhead->last_decay = last;
+						read_usage_v3(flags, fhead->root);
+					} else
+						error = 1;
+				} else
+					error = 1;
+			}
+#endif
 			else
 				error = 1;
 
@@ -796,44 +1145,96 @@ int
 read_usage_v2(FILE *fp, int flags, group_info *root)
 {
 	struct group_node_usage_v2 grp;
-	group_info *ginfo;
-	struct group_path *gpath;
 
 	if (fp == NULL)
 		return 0;
 
-	while (fread(&grp, sizeof(struct group_node_usage_v2), 1, fp)) {
-		if (grp.usage >= 0 && is_valid_pbs_name(grp.name, USAGE_NAME_MAX)) {
-			/* if we're trimming the tree, don't add any new nodes which are not
-			 * already in the resource_group file
-			 */
-			if (flags & FS_TRIM)
-				ginfo = find_group_info(grp.name, root);
-			else
-				ginfo = find_alloc_ginfo(grp.name, root);
+	while (fread(&grp, sizeof(struct group_node_usage_v2), 1, fp))
+		load_entity_usage(&grp, flags, root);
 
-			if (ginfo != NULL) {
-				ginfo->usage = grp.usage;
-				ginfo->temp_usage = grp.usage;
-				if (ginfo->child == NULL) {
-					gpath = ginfo->gpath;
-					/* add usage down the path from the root to our parent */
-					while (gpath->next != NULL) {
-						gpath->ginfo->usage += grp.usage;
-						gpath->ginfo->temp_usage += grp.usage;
-						gpath = gpath->next;
-					}
-				}
-			}
-		}
-		else
-			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING,
-				"fairshare usage", "Invalid entity");
+	return 1;
+}
+
+#ifndef WIN32
+/**
+ * @brief
+ * 		read version 3 usage file, which usage_map_open() has mapped
+ *
+ * @param[in]	flags	- flags to check whether to trim or not.
+ * @param[in]	root	- root of the fairshare tree
+ *
+ *	@retval 1 success
+ *	@retval 0 failure
+ *
+ */
+static int
+read_usage_v3(int flags, group_info *root)
+{
+	struct group_node_usage_v2 *slots;
+	int i;
 
+	if (usage_map.addr == NULL)
+		return 0;
+
+	slots = USAGE_MAP_SLOTS;
+	for (i = 0; i < USAGE_MAP_HEAD->nslots; i++) {
+		if (slots[i].name[0] != '\0')
+			load_entity_usage(&slots[i], flags, root);
 	}
 
 	return 1;
 }
+#endif /* WIN32 */
+
+/**
+ * @brief
+ * 		load the usage of one entity read from a usage file into the
+ * 		fairshare tree
+ *
+ * @param[in]	grp	- the entity and its usage
+ * @param[in]	flags	- flags to check whether to trim or not.
+ * @param[in]	root	- root of the fairshare tree
+ *
+ * @return void
+ */
+static void
+load_entity_usage(struct group_node_usage_v2 *grp, int flags, group_info *root)
+{
+	char name[USAGE_NAME_MAX + 1];
+	group_info *ginfo;
+	struct group_path *gpath;
+
+	if (grp->usage >= 0 && is_valid_pbs_name(grp->name, USAGE_NAME_MAX)) {
+		/* the name is not terminated if it is USAGE_NAME_MAX long */
+		strncpy(name, grp->name, USAGE_NAME_MAX);
+		name[USAGE_NAME_MAX] = '\0';
+
+		/* if we're trimming the tree, don't add any new nodes which are not
+		 * already in the resource_group file
+		 */
+		if (flags & FS_TRIM)
+			ginfo = find_group_info(name, root);
+		else
+			ginfo = find_alloc_ginfo(name, root);
+
+		if (ginfo != NULL) {
+			ginfo->usage = grp->usage;
+			ginfo->temp_usage = grp->usage;
+			if (ginfo->child == NULL) {
+				gpath = ginfo->gpath;
+				/* add usage down the path from the root to our parent */
+				while (gpath->next != NULL) {
+					gpath->ginfo->usage += grp->usage;
+					gpath->ginfo->temp_usage += grp->usage;
+					gpath = gpath->next;
+				}
+			}
+		}
+	}
+	else
+		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING,
+			"fairshare usage", "Invalid entity");
+}
 
 /**
  * @brief
@@ -49,6 +49,8 @@
  * 	schedule()
  * 	intermediate_schedule()
  * 	scheduling_cycle()
+ * 	reuse_subjob_nspecs()
+ * 	run_array_batch()
  * 	main_sched_loop()
  * 	end_cycle_tasks()
  * 	update_last_running()
@@ -791,6 +793,290 @@ scheduling_cycle(int sd, char *jobid)
 	return 0;
 }
 
+/**
+ * @brief
+ * 		place the next subjob of an array on the same vnodes as the
+ *		previous one, if they still have room for it.  This saves the
+ *		node search of is_ok_to_run() for the identical subjobs of a batch.
+ *		The limits and the queue and server resources are still checked,
+ *		since each subjob of the batch counts against them.  The checks of
+ *		is_ok_to_run() that only depend on the array and the time, such as
+ *		dedicated and prime time, do not change within a batch.
+ *		Placements are only reused where the node search would come
+ *		up with the same vnodes, see below.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	sinfo	-	the server
+ * @param[in]	qinfo	-	the queue the array is in
+ * @param[in]	array	-	the array
+ * @param[in]	prev	-	uncombined placement of the previous subjob
+ * @param[out]	err	-	error struct, only used as scratch
+ *
+ * @return	nspec **
+ * @retval	placement for the next subjob
+ * @retval	NULL	: the placement can not be reused, call is_ok_to_run()
+ */
+static nspec **
+reuse_subjob_nspecs(status *policy, server_info *sinfo, queue_info *qinfo,
+	resource_resv *array, nspec **prev, schd_error *err)
+{
+	int i;
+	int j;
+
+	if (prev == NULL || array->job->resv != NULL ||
+		array->node_set_str != NULL || array->aoename != NULL)
+		return NULL;
+
+	/* the node search would pick the same vnodes only if the node order
+	 * does not change as jobs are run: no sorting on unused or assigned
+	 * resources, packed placement and no node grouping
+	 */
+	if (conf.node_sort_unused || policy->smp_dist != SMP_NODE_PACK ||
+		sinfo->node_group_enable || conf.prime_lb ||
+		conf.non_prime_lb)
+		return NULL;
+
+	/* jobs or reservations due to start while the subjob would run need
+	 * the calendar simulation of is_ok_to_run() and the node search
+	 */
+	if (exists_resv_event(sinfo->calendar,
+		sinfo->server_time + array->hard_duration) ||
+		exists_run_event(sinfo->calendar,
+		sinfo->server_time + array->hard_duration))
+		return NULL;
+
+	if (check_limits(sinfo, qinfo, array, err, CHECK_LIMIT))
+		return NULL;
+
+	if ((sinfo->has_nonCPU_licenses == 0) &&
+		(array->select->total_cpus > sinfo->flt_lic))
+		return NULL;
+
+	if (check_avail_resources(qinfo->qres, array->resreq, NO_FLAGS,
+		policy->resdef_to_check, INSUFFICIENT_QUEUE_RESOURCE, err) == 0)
+		return NULL;
+
+	if (check_avail_resources(sinfo->res, array->resreq, NO_FLAGS,
+		policy->resdef_to_check, INSUFFICIENT_SERVER_RESOURCE, err) == 0)
+		return NULL;
+
+	for (i = 0; prev[i] != NULL; i++) {
+		/* chunks sharing a vnode would have to be checked together */
+		for (j = 0; j < i; j++)
+			if (prev[j]->ninfo == prev[i]->ninfo)
+				return NULL;
+		if (!is_vnode_eligible(prev[i]->ninfo, array, array->place_spec, err))
+			return NULL;
+		if (check_avail_resources(prev[i]->ninfo->res, prev[i]->resreq,
+			ONLY_COMP_CONS, NULL, INSUFFICIENT_RESOURCE, err) == 0)
+			return NULL;
+	}
+
+	return dup_nspecs(prev, sinfo->nodes);
+}
+
+/**
+ * @brief
+ * 		run more subjobs of an array right after one of its subjobs was
+ *		run, up to array_batch_size subjobs in all.  The jobs are not
+ *		re-sorted and next_job() is not called between them.  A subjob
+ *		reuses the placement of the previous one when its vnodes still
+ *		have room, else it goes through is_ok_to_run().  Each subjob is
+ *		run in our cache as it is placed, and the whole batch is then sent
+ *		to the server as one run request for the range of subjobs, with
+ *		one exec_vnode per subjob.
+ *
+ * @par
+ *		If the server rejects the request, the array is not considered
+ *		again this cycle.  The subjobs of the batch stay running in our
+ *		cache until the next cycle queries the server again.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	sd	-	connection descriptor to server or
+ *		   	  			SIMULATE_SD if we're simulating
+ * @param[in]	sinfo	-	the server
+ * @param[in]	qinfo	-	the queue the array is in
+ * @param[in]	array	-	the array whose subjob was just run
+ * @param[in]	first_ns	-	uncombined placement of that subjob, or NULL;
+ *							freed here
+ * @param[out]	err	-	error struct to return errors
+ *
+ * @retval	1	: the batch ended normally
+ * @retval	0	: the batch failed to run (see err for more info)
+ * @retval -1	: error
+ */
+static int
+run_array_batch(status *policy, int sd, server_info *sinfo,
+	queue_info *qinfo, resource_resv *array, nspec **first_ns,
+	schd_error *err)
+{
+	nspec **ns_arr;
+	nspec **prev_ns = first_ns;
+	resource_resv *tj;
+	int num_run = 1;	/* the subjob our caller ran */
+	int num_reused = 0;
+	int num_ns;
+	int ret = 1;
+	int rs = -1;		/* current run of consecutive indices */
+	int re = -1;
+	int pfxlen;
+	int rc;
+	size_t destlen = 0;
+	size_t len;
+	char *execvnode = NULL;
+	char *destins = NULL;
+	char *tmp;
+	char *sfx;
+	char idx[PBS_MAXSVRJOBID + 1] = {'\0'};
+	char jobid[PBS_MAXSVRJOBID + 1];
+	char buf[MAX_LOG_SIZE];
+
+	/* the subjob ids of the batch are "seq[" idx "].server" */
+	pfxlen = strcspn(array->name, "[");
+	sfx = strchr(array->name, ']');
+	if (array->name[pfxlen] == '\0' || sfx == NULL) {
+		free_nspecs(first_ns);
+		return 1;
+	}
+
+	while (num_run < conf.array_batch_size && !array->can_not_run &&
+		range_next_value(array->job->queued_subjobs, -1) >= 0) {
+		/* room for the closed runs, the current run and one more index */
+		if (pfxlen + 1 + strlen(idx) + 24 + strlen(sfx) >= sizeof(jobid))
+			break;
+
+		clear_schd_error(err);
+		err->status_code = NOT_RUN;
+		ns_arr = reuse_subjob_nspecs(policy, sinfo, qinfo, array, prev_ns, err);
+		if (ns_arr != NULL)
+			num_reused++;
+		else {
+			clear_schd_error(err);
+			err->status_code = NOT_RUN;
+			ns_arr = is_ok_to_run(policy, sd, sinfo, qinfo, array, NO_FLAGS, err);
+		}
+		if (ns_arr == NULL) {
+			/* next_job() will hand us the array again to sort this out */
+			clear_schd_error(err);
+			break;
+		}
+		tj = queue_subjob(array, sinfo, qinfo);
+		if (tj == NULL) {
+			free_nspecs(ns_arr);
+			set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
+			ret = -1;
+			break;
+		}
+
+		/* the execvnode and the placement to reuse are taken before
+		 * run_update_resresv() combines the chunks on each vnode
+		 */
+		num_ns = count_array((void **) ns_arr);
+		if (num_ns > 1)
+			qsort(ns_arr, num_ns, sizeof(nspec *), cmp_nspec);
+		if (sd != SIMULATE_SD) {
+			execvnode = create_execvnode(ns_arr);
+			if (execvnode != NULL)
+				execvnode = strdup(execvnode);
+			if (execvnode == NULL) {
+				free_nspecs(ns_arr);
+				set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
+				ret = -1;
+				break;
+			}
+		}
+		free_nspecs(prev_ns);
+		prev_ns = dup_nspecs(ns_arr, sinfo->nodes);
+
+		ret = run_update_resresv(policy, SIMULATE_SD, sinfo, qinfo, tj,
+			ns_arr, RURR_ADD_END_EVENT, err);
+		if (ret <= 0)
+			break;
+		num_run++;
+
+		/* out of memory: the subjob stays running in our cache only,
+		 * which the next cycle corrects
+		 */
+		if (execvnode != NULL) {
+			len = strlen(execvnode);
+			tmp = realloc(destins, destlen + len + 2);
+			if (tmp == NULL) {
+				free(execvnode);
+				execvnode = NULL;
+				set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
+				ret = -1;
+				num_run--;
+				break;
+			}
+			destins = tmp;
+			if (destlen > 0)
+				destins[destlen++] = '\n';
+			strcpy(destins + destlen, execvnode);
+			destlen += len;
+			free(execvnode);
+			execvnode = NULL;
+		}
+
+		if (rs >= 0 && tj->job->array_index == re + 1)
+			re = tj->job->array_index;
+		else {
+			if (rs >= 0) {
+				len = strlen(idx);
+				if (rs == re)
+					snprintf(idx + len, sizeof(idx) - len, "%d,", rs);
+				else
+					snprintf(idx + len, sizeof(idx) - len, "%d-%d,", rs, re);
+			}
+			rs = re = tj->job->array_index;
+		}
+	}
+	free_nspecs(prev_ns);
+	free(execvnode);
+
+	if (num_run > 1 && sd != SIMULATE_SD) {
+		len = strlen(idx);
+		if (rs == re)
+			snprintf(idx + len, sizeof(idx) - len, "%d", rs);
+		else
+			snprintf(idx + len, sizeof(idx) - len, "%d-%d", rs, re);
+		snprintf(jobid, sizeof(jobid), "%.*s[%s%s", pfxlen, array->name,
+			idx, sfx);
+
+		if (sinfo->throughput_mode)
+			rc = pbs_asyrunjob(sd, jobid, destins, NULL);
+		else
+			rc = pbs_runjob(sd, jobid, destins, NULL);
+		if (rc) {
+			char *errbuf;
+
+			array->can_not_run = 1;
+			clear_schd_error(err);
+			set_schd_error_codes(err, NOT_RUN, RUN_FAILURE);
+			errbuf = pbs_geterrmsg(sd);
+			set_schd_error_arg(err, ARG1, errbuf != NULL ? errbuf : "");
+			snprintf(buf, sizeof(buf), "%d", pbs_errno);
+			set_schd_error_arg(err, ARG2, buf);
+			snprintf(buf, sizeof(buf), "Failed to run subjobs %s: %d",
+				jobid, pbs_errno);
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING,
+				array->name, buf);
+			ret = 0;
+		}
+	}
+	free(destins);
+
+	if (num_run > 1) {
+		snprintf(buf, sizeof(buf),
+			"Ran %d subjobs in one batch, %d placements reused",
+			num_run, num_reused);
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			array->name, buf);
+	}
+	if (num_run > 1 && range_next_value(array->job->queued_subjobs, -1) < 0)
+		update_accruetype(sd, sinfo, ACCRUE_MAKE_INELIGIBLE, SUCCESS, array);
+	return ret;
+}
+
 /**
  * @brief
  * 		the main scheduler loop
@@ -900,10 +1186,23 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				tj = njob;
 
 			if (rc != SCHD_ERROR) {
+				nspec **batch_ns = NULL;
+
+				/* run_update_resresv() combines the chunks of ns_arr */
+				if (njob->job->is_array && conf.array_batch_size > 1 &&
+					sinfo->qrun_job == NULL && !njob->is_shrink_to_fit)
+					batch_ns = dup_nspecs(ns_arr, sinfo->nodes);
 				if(run_update_resresv(policy, sd, sinfo, qinfo, tj, ns_arr, RURR_ADD_END_EVENT, err) > 0 ) {
 					rc = SUCCESS;
 					sort_again = MAY_RESORT_JOBS;
+					if (njob->job->is_array && conf.array_batch_size > 1 &&
+						sinfo->qrun_job == NULL && !njob->is_shrink_to_fit) {
+						if (run_array_batch(policy, sd, sinfo, qinfo, njob,
+							batch_ns, err) <= 0)
+							rc = err->error_code;
+					}
 				} else {
+					free_nspecs(batch_ns);
 					/* if run_update_resresv() returns 0 and pbs_errno == PBSE_HOOKERROR,
 					 * then this job is required to be ignored in this scheduling cycle
 					 */
@@ -844,6 +844,14 @@ parse_config(char *fname)
 					conf.max_preempt_attempts = num;
 				else if(!strcmp(config_name, PARSE_OPT_BACKFILL_FUZZY_TIME))
 					conf.dflt_opt_backfill_fuzzy = num;
+				else if (!strcmp(config_name, PARSE_ARRAY_BATCH_SIZE)) {
+					if (num < 1) {
+						error = 1;
+						sprintf(errbuf, "%s: Invalid value: %s.  Valid values are 1 or more.", PARSE_ARRAY_BATCH_SIZE, config_value);
+					}
+					else
+						conf.array_batch_size = num;
+				}
 				else if (!strcmp(config_name, PARSE_MAX_JOB_CHECK)) {
 					if (!strcmp(config_value, "ALL_JOBS"))
 						conf.max_jobs_to_check = SCHD_INFINITY;
@@ -1068,6 +1076,7 @@ init_config()
 
 	conf.max_preempt_attempts = SCHD_INFINITY;
 	conf.max_jobs_to_check = SCHD_INFINITY;
+	conf.array_batch_size = 1;
 
 	/* default value for ignore_res is the pseudo resources */
 	conf.ignore_res = ignore;
@@ -46,6 +46,9 @@
  *	acct_open()
  *	acct_record()
  *	acct_close()
+ *	acct_flush()
+ *	acct_sync()
+ *	write_json_record()
  */
 
 
@@ -54,6 +57,7 @@
 #include "portability.h"
 #ifndef  WIN32
 #include <sys/param.h>
+#include <unistd.h>
 #endif
 #include <sys/types.h>
 #include <string.h>
@@ -76,10 +80,20 @@
 #include "server.h"
 #include "svrfunc.h"
 #include "libutil.h"
+#include "work_task.h"
+#include "pbs_internal.h"
+
+#define ACCT_JSON_SUFFIX	".json"
+#define ACCT_IOBUF_SIZE		(256 * 1024)	/* stream buffer with PBS_ACCT_FLUSH */
 
 /* Local Data */
 
 static FILE	    *acctfile;		/* open stream for log file */
+static FILE	    *acctjson;		/* open stream for JSON lines records */
+static int	     acct_idx_fd = -1;	/* job index of acctfile, see log_index_open() */
+static char	     acct_iobuf[ACCT_IOBUF_SIZE];
+static char	     acct_json_iobuf[ACCT_IOBUF_SIZE];
+static struct work_task *acct_flush_task = NULL;
 static volatile int  acct_opened = 0;
 static int	     acct_opened_day;
 static int	     acct_auto_switch = 0;
@@ -918,7 +932,9 @@ acct_open(char *filename)
 	char  filen[_POSIX_PATH_MAX];
 	char  logmsg[_POSIX_PATH_MAX+80];
 #endif
-	FILE *newacct;
+	char  jsonname[sizeof(filen) + sizeof(ACCT_JSON_SUFFIX)];
+	FILE *newacct = NULL;
+	FILE *newjson = NULL;
 	time_t now;
 	struct tm *ptm;
 
@@ -942,23 +958,64 @@ acct_open(char *filename)
 	} else if (*filename != '/') {
 		return (-1);		/* not absolute */
 	}
-	if ((newacct = fopen(filename, "a")) == NULL) {
-		log_err(errno, "acct_open", filename);
-		return (-1);
+	if (pbs_conf.pbs_acct_format & PBS_ACCT_FORMAT_TEXT) {
+		if ((newacct = fopen(filename, "a")) == NULL) {
+			log_err(errno, "acct_open", filename);
+			return (-1);
+		}
+#ifdef WIN32
+		secure_file(filename, "Administrators", READS_MASK|WRITES_MASK|STANDARD_RIGHTS_REQUIRED);
+#endif
 	}
-
+	if (pbs_conf.pbs_acct_format & PBS_ACCT_FORMAT_JSON) {
+		if (strlen(filename) >= sizeof(filen)) {
+			if (newacct)
+				(void)fclose(newacct);
+			return (-1);
+		}
+		(void)sprintf(jsonname, "%s%s", filename, ACCT_JSON_SUFFIX);
+		if ((newjson = fopen(jsonname, "a")) == NULL) {
+			log_err(errno, "acct_open", jsonname);
+			if (newacct)
+				(void)fclose(newacct);
+			return (-1);
+		}
 #ifdef WIN32
-	secure_file(filename, "Administrators", READS_MASK|WRITES_MASK|STANDARD_RIGHTS_REQUIRED);
-	(void)setvbuf(newacct, NULL, _IONBF, 0); /* no buffering to get instant
-						  log*/
-#else
-	(void)setvbuf(newacct, NULL, _IOLBF, 0); /* set line buffering */
+		secure_file(jsonname, "Administrators", READS_MASK|WRITES_MASK|STANDARD_RIGHTS_REQUIRED);
 #endif
+	}
 
 	if (acct_opened > 0) 		/* if acct was open, close it */
-		(void)fclose(acctfile);
+		acct_close();
+
+	/*
+	 * With PBS_ACCT_FLUSH, records collect in a stream buffer which
+	 * acct_flush() writes out at most that many seconds later, so a
+	 * busy server writes its records in a few large writes.
+	 * The buffers are set only now that the previous files are closed.
+	 */
+	if (newacct) {
+		if (pbs_conf.pbs_acct_flush > 0)
+			(void)setvbuf(newacct, acct_iobuf, _IOFBF, sizeof(acct_iobuf));
+		else
+#ifdef WIN32
+			(void)setvbuf(newacct, NULL, _IONBF, 0); /* no buffering to get instant
+								  log*/
+#else
+			(void)setvbuf(newacct, NULL, _IOLBF, 0); /* set line buffering */
+#endif
+	}
+	if (newjson) {
+		if (pbs_conf.pbs_acct_flush > 0)
+			(void)setvbuf(newjson, acct_json_iobuf, _IOFBF, sizeof(acct_json_iobuf));
+		else
+			(void)setvbuf(newjson, NULL, _IOLBF, 0);
+	}
 
 	acctfile = newacct;
+	acctjson = newjson;
+	if (acctfile)
+		acct_idx_fd = log_index_open(filename, fileno(acctfile));
 	acct_opened = 1;			/* note that file is open */
 	(void)sprintf(logmsg, "Account file %s opened", filename);
 	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
@@ -977,11 +1034,172 @@ void
 acct_close()
 {
 	if (acct_opened == 1) {
-		(void)fclose(acctfile);
+		if (acctfile) {
+			(void)fclose(acctfile);
+			acctfile = NULL;
+		}
+		if (acctjson) {
+			(void)fclose(acctjson);
+			acctjson = NULL;
+		}
+		if (acct_idx_fd >= 0) {
+			(void)close(acct_idx_fd);
+			acct_idx_fd = -1;
+		}
 		acct_opened = 0;
 	}
 }
 
+/**
+ * @brief
+ * acct_flush - work task writing out the accounting records held in
+ *	the stream buffers, see PBS_ACCT_FLUSH
+ *
+ * @param[in]	ptask - work task
+ *
+ * @return	void
+ */
+static void
+acct_flush(struct work_task *ptask)
+{
+	acct_flush_task = NULL;
+	acct_sync();
+}
+
+/**
+ * @brief
+ * acct_sync - write out the accounting records held in the stream
+ *	buffers now.  Called before the server forks, so that a child
+ *	leaving through exit() does not write the inherited records again.
+ *
+ * @return	void
+ */
+void
+acct_sync(void)
+{
+	if (acct_opened == 0)
+		return;
+	if (acctfile)
+		(void)fflush(acctfile);
+	if (acctjson)
+		(void)fflush(acctjson);
+}
+
+/**
+ * @brief
+ * json_put_str - write a string as a quoted JSON string
+ *
+ * @param[in]	fp - stream to write to
+ * @param[in]	s - string
+ * @param[in]	len - length of s
+ *
+ * @return	void
+ */
+static void
+json_put_str(FILE *fp, char *s, size_t len)
+{
+	unsigned char c;
+
+	putc('"', fp);
+	for (; len > 0; s++, len--) {
+		c = (unsigned char)*s;
+		if (c == '"' || c == '\\') {
+			putc('\\', fp);
+			putc(c, fp);
+		} else if (c < 0x20) {
+			fprintf(fp, "\\u%04x", c);
+		} else {
+			putc(c, fp);
+		}
+	}
+	putc('"', fp);
+}
+
+/**
+ * @brief
+ * write_json_record - write an accounting record as one JSON line
+ *
+ * @par Functionality:
+ *	The "key=value key=value ..." text of the record becomes the
+ *	"record" object, with the quotes added by cpy_quote_value() removed.
+ *	Values stay strings, as they are in the text record.  A text that is
+ *	not in that form is written as a "text" string instead.
+ *
+ * @param[in]	acctype - accounting record type
+ * @param[in]	id - accounting record id
+ * @param[in]	text - text of the record
+ *
+ * @return	void
+ */
+static void
+write_json_record(int acctype, char *id, char *text)
+{
+	char *p;
+	char *key;
+	char *val;
+	char *end;
+	int   nkeys = 0;
+
+	/* check the text is all key=value pairs before writing any */
+	for (p = text; *p != '\0'; ) {
+		while (*p == ' ')
+			p++;
+		if (*p == '\0')
+			break;
+		key = p;
+		while (*p != '\0' && *p != '=' && *p != ' ')
+			p++;
+		if (*p != '=' || p == key)
+			break;
+		val = ++p;
+		if (*val == '"' || *val == '\'') {
+			if ((end = strchr(val + 1, *val)) == NULL)
+				break;
+			p = end + 1;
+		} else {
+			while (*p != '\0' && *p != ' ')
+				p++;
+		}
+		if (*p != '\0' && *p != ' ')
+			break;
+		nkeys++;
+	}
+
+	fprintf(acctjson, "{\"time\":%ld,\"type\":\"%c\",\"id\":",
+		(long)time_now, (char)acctype);
+	json_put_str(acctjson, id, strlen(id));
+
+	if (*p != '\0' || nkeys == 0) {
+		fputs(",\"text\":", acctjson);
+		json_put_str(acctjson, text, strlen(text));
+		fputs("}\n", acctjson);
+		return;
+	}
+
+	fputs(",\"record\":{", acctjson);
+	for (p = text; nkeys > 0; nkeys--) {
+		while (*p == ' ')
+			p++;
+		key = p;
+		p = strchr(p, '=');
+		json_put_str(acctjson, key, p - key);
+		putc(':', acctjson);
+		val = ++p;
+		if (*val == '"' || *val == '\'') {
+			end = strchr(val + 1, *val);
+			json_put_str(acctjson, val + 1, end - val - 1);
+			p = end + 1;
+		} else {
+			while (*p != '\0' && *p != ' ')
+				p++;
+			json_put_str(acctjson, val, p - val);
+		}
+		if (nkeys > 1)
+			putc(',', acctjson);
+	}
+	fputs("}}\n", acctjson);
+}
+
 /**
  * @brief
  * write_account_record - write basic accounting record
@@ -996,6 +1214,7 @@ void
 write_account_record(int acctype, char *id, char *text)
 {
 	struct tm *ptm;
+	int	   rc;
 
 	if (acct_opened == 0)
 		return;		/* file not open, don't bother */
@@ -1008,14 +1227,29 @@ write_account_record(int acctype, char *id, char *text)
 		acct_close();
 		acct_open(NULL);
 	}
+	if (acct_opened == 0)
+		return;		/* reopen failed */
 	if (text == NULL)
 		text = "";
 
-	(void)fprintf(acctfile,
-		"%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
-		ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
-		ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
-		(char)acctype, id, text);
+	if (acctfile) {
+		rc = fprintf(acctfile,
+			"%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
+			ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
+			ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
+			(char)acctype, id, text);
+
+		/* ftell() counts what is still in the stream buffer */
+		if ((rc > 0) && (acct_idx_fd >= 0))
+			log_index_write(acct_idx_fd, id,
+				(long long)ftell(acctfile) - rc);
+	}
+	if (acctjson)
+		write_json_record(acctype, id, text);
+
+	if ((pbs_conf.pbs_acct_flush > 0) && (acct_flush_task == NULL))
+		acct_flush_task = set_task(WORK_Timed,
+			(long)(time_now + pbs_conf.pbs_acct_flush), acct_flush, NULL);
 }
 
 /**
@@ -324,6 +324,209 @@ find_arrayparent(char *subjobid)
 		strcat(idbuf, pc);
 	return (find_job(idbuf));
 }
+/**
+ * @brief
+ * 		ajq_find - find the run of queued subjobs which starts at or before
+ *		a table offset, by binary search
+ *
+ * @param[in]	q - runs of queued subjobs
+ * @param[in]	offset - subjob table offset
+ *
+ * @return	int
+ * @retval	index of the last run whose first offset is <= offset
+ * @retval	-1 if offset is before every run
+ */
+static int
+ajq_find(struct ajqueued *q, int offset)
+{
+	int lo = 0;
+	int hi = q->aq_nruns - 1;
+	int mid;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (q->aq_runs[mid].ar_first <= offset)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return hi;
+}
+
+/**
+ * @brief
+ * 		ajq_drop - discard the runs of queued subjobs of an Array Job,
+ *		they are rebuilt from the tracking table when next needed
+ *
+ * @param[in,out]	parent - pointer to parent job.
+ *
+ * @return	void
+ */
+static void
+ajq_drop(job *parent)
+{
+	if (parent->ji_ajqueued) {
+		free(parent->ji_ajqueued);
+		parent->ji_ajqueued = NULL;
+	}
+}
+
+/**
+ * @brief
+ * 		ajq_build - return the runs of queued subjobs of an Array Job,
+ *		building them from the tracking table if not already present
+ *
+ * @param[in,out]	parent - pointer to parent job.
+ *
+ * @return	struct ajqueued *
+ * @retval	runs of queued subjobs
+ * @retval	NULL on error, caller must walk the tracking table instead
+ */
+static struct ajqueued *
+ajq_build(job *parent)
+{
+	struct ajtrkhd	*t = parent->ji_ajtrk;
+	struct ajqueued	*q;
+	int		 nruns = 0;
+	int		 i;
+
+	if (parent->ji_ajqueued)
+		return parent->ji_ajqueued;
+	if (t == NULL)
+		return NULL;
+
+	for (i = 0; i < t->tkm_ct; i++) {
+		if ((t->tkm_tbl[i].trk_status == JOB_STATE_QUEUED) &&
+			((i == 0) || (t->tkm_tbl[i-1].trk_status != JOB_STATE_QUEUED)))
+			nruns++;
+	}
+
+	q = (struct ajqueued *)malloc(sizeof(struct ajqueued) +
+		nruns * sizeof(struct ajrun));
+	if (q == NULL)
+		return NULL;
+	q->aq_size = nruns + 1;
+	q->aq_nruns = 0;
+	for (i = 0; i < t->tkm_ct; i++) {
+		if (t->tkm_tbl[i].trk_status != JOB_STATE_QUEUED)
+			continue;
+		if ((q->aq_nruns > 0) &&
+			(q->aq_runs[q->aq_nruns-1].ar_last == i - 1)) {
+			q->aq_runs[q->aq_nruns-1].ar_last = i;
+		} else {
+			q->aq_runs[q->aq_nruns].ar_first = i;
+			q->aq_runs[q->aq_nruns].ar_last  = i;
+			q->aq_nruns++;
+		}
+	}
+	parent->ji_ajqueued = q;
+	return q;
+}
+
+/**
+ * @brief
+ * 		ajq_insert - open a slot for a new run at position "pos"
+ *
+ * @param[in,out]	parent - pointer to parent job.
+ * @param[in]	pos - position of the new run
+ *
+ * @return	struct ajqueued *
+ * @retval	runs of queued subjobs, with the slot at pos unset
+ * @retval	NULL if the runs could not be grown, they were discarded
+ */
+static struct ajqueued *
+ajq_insert(job *parent, int pos)
+{
+	struct ajqueued *q = parent->ji_ajqueued;
+
+	if (q->aq_nruns == q->aq_size) {
+		int newsize = q->aq_size * 2;
+
+		q = (struct ajqueued *)realloc(q, sizeof(struct ajqueued) +
+			(newsize - 1) * sizeof(struct ajrun));
+		if (q == NULL) {
+			ajq_drop(parent);
+			return NULL;
+		}
+		q->aq_size = newsize;
+		parent->ji_ajqueued = q;
+	}
+	memmove(&q->aq_runs[pos+1], &q->aq_runs[pos],
+		(q->aq_nruns - pos) * sizeof(struct ajrun));
+	q->aq_nruns++;
+	return q;
+}
+
+/**
+ * @brief
+ * 		ajq_update - record that the subjob at "offset" entered or left the
+ *		queued state in the runs of queued subjobs, if they have been built
+ *
+ * @param[in,out]	parent - pointer to parent job.
+ * @param[in]	offset - subjob table offset
+ * @param[in]	queued - non-zero if the subjob is now queued
+ *
+ * @return	void
+ */
+static void
+ajq_update(job *parent, int offset, int queued)
+{
+	struct ajqueued *q = parent->ji_ajqueued;
+	struct ajrun	*r;
+	int		 i;
+
+	if (q == NULL)
+		return;
+
+	i = ajq_find(q, offset);
+	r = (i >= 0) ? &q->aq_runs[i] : NULL;
+
+	if (!queued) {
+		if ((r == NULL) || (offset > r->ar_last)) {
+			/* not in any run, out of step with the table */
+			ajq_drop(parent);
+		} else if (r->ar_first == r->ar_last) {
+			memmove(r, r + 1, (q->aq_nruns - i - 1) * sizeof(struct ajrun));
+			q->aq_nruns--;
+		} else if (offset == r->ar_first) {
+			r->ar_first++;
+		} else if (offset == r->ar_last) {
+			r->ar_last--;
+		} else {
+			/* split the run around offset */
+			if ((q = ajq_insert(parent, i + 1)) == NULL)
+				return;
+			q->aq_runs[i+1].ar_first = offset + 1;
+			q->aq_runs[i+1].ar_last  = q->aq_runs[i].ar_last;
+			q->aq_runs[i].ar_last    = offset - 1;
+		}
+		return;
+	}
+
+	if ((r != NULL) && (offset <= r->ar_last))
+		return;		/* already in a run */
+
+	if ((r != NULL) && (r->ar_last == offset - 1)) {
+		r->ar_last = offset;
+		if ((i + 1 < q->aq_nruns) &&
+			(q->aq_runs[i+1].ar_first == offset + 1)) {
+			/* joins two runs */
+			r->ar_last = q->aq_runs[i+1].ar_last;
+			memmove(r + 1, r + 2,
+				(q->aq_nruns - i - 2) * sizeof(struct ajrun));
+			q->aq_nruns--;
+		}
+	} else if ((i + 1 < q->aq_nruns) &&
+		(q->aq_runs[i+1].ar_first == offset + 1)) {
+		q->aq_runs[i+1].ar_first = offset;
+	} else {
+		if ((q = ajq_insert(parent, i + 1)) == NULL)
+			return;
+		q->aq_runs[i+1].ar_first = offset;
+		q->aq_runs[i+1].ar_last  = offset;
+	}
+}
+
 /**
  * @brief
  * 		set_subjob_tblstate - set the subjob tracking table state field for
@@ -360,6 +563,11 @@ set_subjob_tblstate(job *parent, int offset, int newstate)
 	ptbl->tkm_subjsct[oldstate]--;
 	ptbl->tkm_subjsct[newstate]++;
 
+	if (oldstate == JOB_STATE_QUEUED)
+		ajq_update(parent, offset, 0);
+	else if (newstate == JOB_STATE_QUEUED)
+		ajq_update(parent, offset, 1);
+
 	/* set flags in attribute so stat_job will update the attr string */
 	parent->ji_wattr[(int)JOB_ATR_array_indices_remaining].at_flags |=
 		ATR_VFLAG_MODCACHE;
@@ -425,7 +633,7 @@ chk_array_doneness(job *parent)
 		/* Before we do a full save of parent, recalculate "JOB_ATR_array_indices_remaining" here*/
 		attribute *premain = &parent->ji_wattr[(int)JOB_ATR_array_indices_remaining];
 		if (premain->at_flags & ATR_VFLAG_MODCACHE) {
-			char *pnewstr = cvt_range(parent->ji_ajtrk, JOB_STATE_QUEUED);
+			char *pnewstr = cvt_range(parent, JOB_STATE_QUEUED);
 			if (pnewstr == NULL)
 				pnewstr = "-";
 			job_attr_def[JOB_ATR_array_indices_remaining].at_free(premain);
@@ -666,6 +874,7 @@ setup_arrayjob_attrs(attribute *pattr, void *pobj, int mode)
 		int pbs_error = PBSE_BADATVAL;
 		if (pjob->ji_ajtrk)
 			free(pjob->ji_ajtrk);
+		ajq_drop(pjob);
 		if ((pjob->ji_ajtrk = mk_subjob_index_tbl(pjob->ji_wattr[(int)JOB_ATR_array_indices_submitted].at_val.at_str,
 			                                      JOB_STATE_QUEUED, &pbs_error)) == NULL)
 			return pbs_error;
@@ -1006,19 +1215,29 @@ mk_subjob_id(job *parent, int offset)
  * 		cvt-range - convert entries in subjob index table which are in "state"
  * 		to a range of indices of subjobs.  range will be of form:
  * 		X,X-Y:Z,...
- * @param[in]	t - pointer to subjob index table
+ *
+ * @par	Functionality:
+ *		For the queued state the range is encoded from the runs of queued
+ *		subjobs kept by set_subjob_tblstate(), so the cost follows the
+ *		number of runs rather than the size of the array.
+ *
+ * @param[in]	parent - pointer to parent Array Job
  * @param[in]	state -  job state.
  * @return	Pointer to static buffer
  * @par	MT-safe: No - uses a global buffer, "buf" and "buflen".
  */
 char *
-cvt_range(struct ajtrkhd *t, int state)
+cvt_range(job *parent, int state)
 {
 	unsigned int f;	/* first of a pair or range   */
 	unsigned int n;  /* next one we are looking at */
 	unsigned int l;
 	int pcomma = 0;
+	int i;
 	char *b2;
+	char *pc;
+	struct ajtrkhd *t = parent->ji_ajtrk;
+	struct ajqueued *q = NULL;
 	static char *buf = NULL;
 	static size_t   buflen = 0;
 
@@ -1031,6 +1250,37 @@ cvt_range(struct ajtrkhd *t, int state)
 			return NULL;
 	}
 	*buf = '\0';	/* initialize buf to empty */
+
+	if (state == JOB_STATE_QUEUED)
+		q = ajq_build(parent);
+	if (q != NULL) {
+		pc = buf;
+		for (i = 0; i < q->aq_nruns; i++) {
+			if ((buflen - (pc - buf)) < 50) {
+				/* expand buf */
+				buflen += 500 + q->aq_nruns * 10;
+				b2 = realloc(buf, buflen);
+				if (b2 == NULL)
+					return NULL;
+				pc = b2 + (pc - buf);
+				buf = b2;
+			}
+			f = q->aq_runs[i].ar_first;
+			l = q->aq_runs[i].ar_last;
+			pc += sprintf(pc, "%s%d", (i > 0) ? "," : "",
+				t->tkm_tbl[f].trk_index);
+			if (l > (f+1)) {
+				if (t->tkm_step > 1)
+					pc += sprintf(pc, "-%d:%d", t->tkm_tbl[l].trk_index, t->tkm_step);
+				else
+					pc += sprintf(pc, "-%d", t->tkm_tbl[l].trk_index);
+			} else if (l > f) {
+				pc += sprintf(pc, ",%d", t->tkm_tbl[l].trk_index);
+			}
+		}
+		return buf;
+	}
+
 	f = 0;
 	while (f < t->tkm_ct) {
 
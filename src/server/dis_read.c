@@ -544,6 +544,10 @@ dis_request_read(int sfds, struct batch_request *request)
 			rc = decode_DIS_QueueJob(sfds, request);
 			break;
 
+		case PBS_BATCH_SubmitJobs:
+			rc = decode_DIS_SubmitJobs(sfds, request);
+			break;
+
 		case PBS_BATCH_JobCred:
 			rc = decode_DIS_JobCred(sfds, request);
 			break;
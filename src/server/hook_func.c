@@ -102,7 +102,10 @@
 #ifndef WIN32
 #include <unistd.h>
 #include <sys/param.h>
+#include <sys/time.h>
 #include <dirent.h>
+#else
+#include <sys/timeb.h>
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -129,6 +132,7 @@
 #include "credential.h"
 #include "batch_request.h"
 #include "job.h"
+#include "acct.h"
 #include "reservation.h"
 #include "queue.h"
 #include "pbs_nodes.h"
@@ -1448,6 +1452,12 @@ mgr_hook_import(struct batch_request *preq)
 
 	phook->hook_script_checksum = crc_file(output_path);
 
+	/* statistics gathered so far belong to the old script */
+	if (phook->stats != NULL) {
+		free(phook->stats);
+		phook->stats = NULL;
+	}
+
 	if (phook->event & HOOK_EVENT_PROVISION)
 		set_srv_prov_attributes(); /* check and set prov attributes */
 
@@ -2370,6 +2380,13 @@ status_hook(hook *phook, struct batch_request *preq, pbs_list_head *pstathd, cha
 				strcpy(val_str, hook_debug_as_string(phook->debug));
 			} else if (strcmp(pal->al_name, HOOKATT_FAIL_ACTION) == 0) {
 				strcpy(val_str, hook_fail_action_as_string(phook->fail_action));
+			} else if (strcmp(pal->al_name, HOOKATT_STATS) == 0) {
+				/* stats can be longer than val_str */
+				if (attrlist_add(&pstat->brp_attr, pal->al_name,
+					hook_stats_as_string(phook)) != 0)
+					return (PBSE_INTERNAL);
+				pal = (svrattrl *)GET_NEXT(pal->al_link);
+				continue;
 			} else {
 				snprintf(hook_msg, msg_len-1,
 					"unknown hook attribute %s", pal->al_name);
@@ -3926,6 +3943,81 @@ process_hooks(struct batch_request *preq, char *hook_msg, size_t msg_len,
 		return (2);
 	return 1;
 }
+/**
+ * @brief
+ *		Return the current wall clock time in seconds, with sub-second
+ *		resolution, for timing hook executions.
+ *
+ * @return	double
+ */
+static double
+hook_wall_time(void)
+{
+#ifdef WIN32
+	struct _timeb	tval;
+
+	_ftime_s(&tval);
+	return ((double)tval.time + (double)tval.millitm / 1000.0);
+#else
+	struct timeval	tval;
+
+	gettimeofday(&tval, NULL);
+	return ((double)tval.tv_sec + (double)tval.tv_usec / 1000000.0);
+#endif
+}
+
+/**
+ * @brief
+ *		Add one execution of hook 'phook' on 'hook_event' to the hook's
+ *		statistics, as reported by the read-only "stats" hook attribute.
+ *
+ * @param[in]	phook	   - the hook that ran
+ * @param[in]	hook_event - the HOOK_EVENT_* the hook ran on
+ * @param[in]	t_start	   - time the hook execution began
+ * @param[in]	t_run	   - time the hook script was started
+ * @param[in]	t_end	   - time the hook script returned
+ * @param[in]	rc	   - return value of pbs_python_run_code_in_namespace()
+ *
+ * @return void
+ */
+static void
+hook_stats_record(hook *phook, unsigned int hook_event, double t_start,
+	double t_run, double t_end, int rc)
+{
+	struct hook_stats	*ps;
+	double			elapsed;
+	int			i;
+
+	for (i = 0; i < HOOK_STATS_NEVENTS; i++) {
+		if (hook_event & (1 << i))
+			break;
+	}
+	if (i == HOOK_STATS_NEVENTS)
+		return;
+
+	if (phook->stats == NULL) {
+		phook->stats = (struct hook_stats *)calloc(HOOK_STATS_NEVENTS,
+			sizeof(struct hook_stats));
+		if (phook->stats == NULL)
+			return;
+	}
+	ps = &phook->stats[i];
+
+	elapsed = t_end - t_start;
+	ps->count++;
+	ps->total += elapsed;
+	if (elapsed > ps->max)
+		ps->max = elapsed;
+	ps->setup += t_run - t_start;
+	ps->run += t_end - t_run;
+
+	if ((rc == -2) || (rc == -3) ||
+		((rc == 0) && (pbs_python_event_get_accept_flag() == FALSE)))
+		ps->rejects++;
+	else if (rc == 0)
+		ps->accepts++;
+}
+
 /**
  * @brief
  *
@@ -3982,6 +4074,10 @@ int server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 	pid_t 			mypid;
 	pbs_list_head 		event_vnode;
 	pbs_list_head 		event_resv;
+	double			t_start;
+	double			t_run;
+
+	t_start = hook_wall_time();
 
 	if (req_ptr == NULL) {
 		snprintf(log_buffer, sizeof(log_buffer),
@@ -4312,9 +4408,12 @@ int server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 	}
 
 	/* let rc pass through */
+	t_run = hook_wall_time();
 	if (rc==0)
 		rc=pbs_python_run_code_in_namespace(&svr_interp_data,
 			phook->script, 0);
+	hook_stats_record(phook, hook_event, t_start, t_run,
+		hook_wall_time(), rc);
 
 	if (fp_debug != NULL) {
 		fclose(fp_debug);
@@ -6466,6 +6565,7 @@ bg_sync_mom_hookfiles(void)
 	}
 
 #ifndef WIN32
+	acct_sync();
 	pid = fork();
 
 	if (pid == -1) {	/* Error on fork */
@@ -6814,6 +6914,7 @@ bg_delete_mom_hooks(void *minfo)
 	}
 
 #ifndef WIN32
+	acct_sync();
 	pid = fork();
 
 	if (pid == -1) {	/* Error on fork */
@@ -7567,6 +7668,7 @@ run_periodic_hook(struct work_task *ptask)
 	}
 
 #ifndef WIN32
+	acct_sync();
 	pid = fork();
 
 	if (pid == -1) {	/* Error on fork */
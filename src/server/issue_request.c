@@ -80,7 +80,6 @@
 /* Global Data Items: */
 
 extern struct connect_handle connection[];
-extern pbs_list_head task_list_event;
 extern time_t	time_now;
 extern char	*msg_issuebad;
 extern char     *msg_norelytomom;
@@ -354,7 +353,7 @@ add_mom_deferred_list(int stream, mominfo_t *minfo, void (*func)(), char *msgid,
 	/* remove this task from the event list, as we will be adding to deferred list anyway
 	 * and there is no child process whose exit needs to be reaped
 	 */
-	delete_link(&ptask->wt_linkall);
+	unlink_task_event(ptask);
 
 	/* append to the moms deferred command list */
 	append_link(&(((mom_svrinfo_t *) (minfo->mi_data))->msr_deferred_cmds), &ptask->wt_linkobj2, ptask);
@@ -720,7 +719,7 @@ issue_Drequest(int conn,
 			 * since its an rpp delayed task, remove it from the task_event list
 			 * caller will add to moms deferred cmd list
 			 */
-			delete_link(&ptask->wt_linkall);
+			unlink_task_event(ptask);
 		}
 		ptask->wt_aux2 = rpp; /* 0 in case of non-TPP */
 		*ppwt = ptask;
@@ -756,8 +755,6 @@ process_Dreply(int sock)
 
 	/* find the work task for the socket, it will point us to the request */
 
-	ptask = (struct work_task *)GET_NEXT(task_list_event);
-
 #ifdef WIN32
 	handle = -1;
 	for (i=0;i < PBS_MAX_CONNECTIONS; i++) {
@@ -770,12 +767,7 @@ process_Dreply(int sock)
 	handle = conn->cn_handle;
 #endif
 
-	while (ptask) {
-		if ((ptask->wt_type == WORK_Deferred_Reply) &&
-			(ptask->wt_event == handle))
-			break;
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
+	ptask = find_work_task(WORK_Deferred_Reply, handle, NULL);
 	if (!ptask) {
 		close_conn(sock);
 		return;
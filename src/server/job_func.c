@@ -339,6 +339,9 @@ job_alloc(void)
 
 #ifdef	PBS_MOM
 	CLEAR_HEAD(pj->ji_tasks);
+	CLEAR_HEAD(pj->ji_rused_sent);
+	pj->ji_rused_gen = -1;
+	pj->ji_rused_cycles = 0;
 	pj->ji_taskid = TM_INIT_TASK;
 	pj->ji_numnodes = 0;
 	pj->ji_numrescs = 0;
@@ -374,6 +377,13 @@ job_alloc(void)
 	pj->ji_deletehistory = 0;
 	pj->ji_newjob = 0;
 	pj->ji_script = NULL;
+	CLEAR_LINK(pj->ji_statejobs);
+	CLEAR_LINK(pj->ji_histjobs);
+	CLEAR_LINK(pj->ji_histwarm);
+	pj->ji_histpack = NULL;
+	pj->ji_histpacklen = 0;
+	CLEAR_LINK(pj->ji_ownerjobs);
+	pj->ji_owneridx = NULL;
 #endif
 	pj->ji_qs.ji_jsversion = JSVERSION;
 	pj->ji_momhandle = -1;		/* mark mom connection invalid */
@@ -490,6 +500,7 @@ job_free(job *pj)
 	}
 #endif
 
+	free_attrlist(&pj->ji_rused_sent);
 #endif
 
 	/* remove any malloc working attribute space */
@@ -553,6 +564,10 @@ job_free(job *pj)
 		free(pj->ji_ajtrk);
 		pj->ji_ajtrk = NULL;
 	}
+	if (pj->ji_ajqueued) {
+		free(pj->ji_ajqueued);
+		pj->ji_ajqueued = NULL;
+	}
 	pj->ji_parentaj = NULL;
 	if (pj->ji_discard)
 		free(pj->ji_discard);
@@ -562,6 +577,8 @@ job_free(job *pj)
 		free(pj->ji_clterrmsg);
 	if (pj->ji_script)
 		free(pj->ji_script);
+	if (pj->ji_histpack)
+		free(pj->ji_histpack);
 
 #else	/* PBS_MOM  Mom Only */
 
@@ -982,6 +999,8 @@ job_purge(job *pjob)
  *		"foo.bar" will not match "foo.bar.com".
  *
  *		If server, then search in AVL tree otherwise Linked list.
+ *		A history job found with its attributes packed is unpacked,
+ *		see job_hist_unpack().
  *
  * @param[in]	jobid - job ID string.
  *
@@ -1081,6 +1100,8 @@ find_job(char *jobid)
 		if (avl_find_key(pkey, AVL_jctx) == AVL_IX_OK)
 			pj = (job *) pkey->recptr;
 		free(pkey);
+		if ((pj != NULL) && (pj->ji_histpack != NULL))
+			(void)job_hist_unpack(pj);
 		return (pj);
 	}
 #endif
@@ -1090,6 +1111,10 @@ find_job(char *jobid)
 			break;
 		pj = (job *)GET_NEXT(pj->ji_alljobs);
 	}
+#ifndef PBS_MOM
+	if ((pj != NULL) && (pj->ji_histpack != NULL))
+		(void)job_hist_unpack(pj);
+#endif
 	return (pj);  /* may be a null pointer */
 }
 
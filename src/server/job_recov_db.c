@@ -346,6 +346,10 @@ job_save_db(job *pjob, int updatetype)
 		pjob->ji_wattr[JOB_ATR_mtime].at_flags |= ATR_VFLAG_MODCACHE;
 	}
 
+	/* a full save writes all the attributes, none may be left packed */
+	if (pjob->ji_histpack != NULL)
+		(void)job_hist_unpack(pjob);
+
 	if (pjob->ji_qs.ji_jsversion != JSVERSION) {
 		/* version of job structure changed, force full write */
 		pjob->ji_qs.ji_jsversion = JSVERSION;
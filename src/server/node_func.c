@@ -334,11 +334,48 @@ chk_characteristic(struct pbsnode *pnode, int *pneed_todo)
 
 
 
+/**
+ * @brief
+ * 		nodeattr_cacheable - can the encoded value of a node attribute be
+ *		kept between status requests
+ *
+ * @par
+ *		The svrattrl cache of an attribute is only as good as the
+ *		ATR_VFLAG_MODCACHE flag.  Resource values are adjusted in place
+ *		all over the node code without flagging the attribute, and state,
+ *		ntype, jobs, resvs and sharing are encoded from the node structure
+ *		or temporarily masked, so those are always encoded afresh.
+ *
+ * @param[in]	index	- index of the node attribute
+ * @param[in]	padef	- definition of the node attribute
+ *
+ * @return	int
+ * @retval	1	- the cached encoding may be used
+ * @retval	0	- the attribute must be encoded on every request
+ */
+static int
+nodeattr_cacheable(int index, attribute_def *padef)
+{
+	switch (index) {
+		case ND_ATR_state:
+		case ND_ATR_ntype:
+		case ND_ATR_jobs:
+		case ND_ATR_resvs:
+		case ND_ATR_Sharing:
+			return 0;
+		default:
+			break;
+	}
+	return (padef->at_type != ATR_TYPE_RESC);
+}
+
 /**
  * @brief
  * 	 	status_nodeattrib() - add status of each requested (or all) node-attribute to
  *			 the status reply.
  *		if a node-attribute is incorrectly specified, *bad is set to the node-attribute's ordinal position.
+ *		Attributes for which nodeattr_cacheable() holds are linked in from
+ *		their cached svrattrl encoding, see svrcached().
  * @see
  * 		status_node
  * @param[in,out]	pal	- the node to check
@@ -378,7 +415,10 @@ status_nodeattrib(svrattrl *pal, attribute_def *padef, struct pbsnode *pnode, in
 				rc = PBSE_UNKNODEATR;
 				break;
 			}
-			if ((padef+index)->at_flags & priv) {
+			if (((padef+index)->at_flags & priv) &&
+				nodeattr_cacheable(index, padef+index)) {
+				svrcached(&pnode->nd_attr[index], phead, padef+index);
+			} else if ((padef+index)->at_flags & priv) {
 				rc = (padef+index)->at_encode(&pnode->nd_attr[index],
 					phead,
 					(padef+index)->at_name, NULL,
@@ -398,7 +438,10 @@ status_nodeattrib(svrattrl *pal, attribute_def *padef, struct pbsnode *pnode, in
 		 **	return all readable attributes
 		 */
 		for (index = 0; index < limit; index++) {
-			if ((padef+index)->at_flags & priv) {
+			if (((padef+index)->at_flags & priv) &&
+				nodeattr_cacheable(index, padef+index)) {
+				svrcached(&pnode->nd_attr[index], phead, padef+index);
+			} else if ((padef+index)->at_flags & priv) {
 				rc = (padef+index)->at_encode(
 					&pnode->nd_attr[index],
 					phead, (padef+index)->at_name,
@@ -2631,6 +2674,7 @@ set_node_topology(attribute *new, void *pobj, int op)
 					 *	if enough licenses are available else we reset the 
 					 *	node's License and LicenseInfo attributes.
 					 */
+					free_svrcache(ppnl);
 					clear_attr(ppnl, pnadl);
 					pnode->nd_modified |= NODE_UPDATE_OTHERS;
 					sockets_release(ppnli->at_val.at_long);
@@ -2660,6 +2704,7 @@ set_node_topology(attribute *new, void *pobj, int op)
 					 *	done in pbsd_init(), q.v.
 					 */
 					/* mark node as using node-locked licenses */
+					free_svrcache(ppnl);
 					clear_attr(ppnl, pnadl);
 					ppnl->at_val.at_char = ND_LIC_TYPE_locked;
 					ppnl->at_flags  |= ATR_VFLAG_SET |
@@ -2678,6 +2723,7 @@ set_node_topology(attribute *new, void *pobj, int op)
 				 *	licenses - mark node as using node-locked
 				 *	licenses ...
 				 */
+				free_svrcache(ppnl);
 				clear_attr(ppnl, pnadl);
 				ppnl->at_val.at_char = ND_LIC_TYPE_locked;
 				ppnl->at_flags  |= ATR_VFLAG_SET |
@@ -2686,6 +2732,7 @@ set_node_topology(attribute *new, void *pobj, int op)
 				 *	... and remember the number of socket
 				 *	licenses consumed.
 				 */
+				free_svrcache(ppnli);
 				clear_attr(ppnli, pnadli);
 				ppnli->at_val.at_long = node_nsockets;
 				ppnli->at_flags  |= ATR_VFLAG_SET |
@@ -2704,7 +2751,9 @@ set_node_topology(attribute *new, void *pobj, int op)
 				 * We don't have to re-evaluate topology if license file
 				 * is updated using qmgr
 				 */
+				free_svrcache(ppnl);
 				clear_attr(ppnl, pnadl);
+				free_svrcache(ppnli);
 				clear_attr(ppnli, pnadli);
 				ppnli->at_val.at_long = node_nsockets;
 				ppnli->at_flags  |= ATR_VFLAG_SET |
@@ -2275,6 +2275,47 @@ decode_stat_update(int stream, struct resc_used_update *prused)
 }
 
 
+/**
+ * @brief
+ *		Check whether any resources_used value differs between two
+ *		copies of the attribute.
+ *
+ * @param[in]	old	-	resources_used before an update
+ * @param[in]	new	-	resources_used after the update
+ *
+ * @return	int
+ * @retval	1	-	some value differs
+ * @retval	0	-	same values
+ */
+static int
+resc_used_differ(attribute *old, attribute *new)
+{
+	resource	*newr;
+	resource	*oldr;
+	int		 nold = 0;
+	int		 nnew = 0;
+
+	for (oldr = (resource *)GET_NEXT(old->at_val.at_list); oldr;
+		oldr = (resource *)GET_NEXT(oldr->rs_link))
+		nold++;
+
+	for (newr = (resource *)GET_NEXT(new->at_val.at_list); newr;
+		newr = (resource *)GET_NEXT(newr->rs_link)) {
+		nnew++;
+		oldr = find_resc_entry(old, newr->rs_defin);
+		if (oldr == NULL)
+			return 1;
+		if ((oldr->rs_value.at_flags | newr->rs_value.at_flags) & ATR_VFLAG_INDIRECT)
+			return 1;
+		if ((oldr->rs_value.at_flags & ATR_VFLAG_SET) != (newr->rs_value.at_flags & ATR_VFLAG_SET))
+			return 1;
+		if ((newr->rs_value.at_flags & ATR_VFLAG_SET) &&
+			(newr->rs_defin->rs_comp(&oldr->rs_value, &newr->rs_value) != 0))
+			return 1;
+	}
+	return (nold != nnew);
+}
+
 /**
  * @brief
  *		Update job resource usage based on information sent from Mom.
@@ -2303,6 +2344,8 @@ stat_update(int stream)
 	struct resc_used_update	 rused = {0};
 	svrattrl		*sattrl;
 	mominfo_t		*mp;
+	attribute		 old_used;
+	int			 old_used_mod;
 
 	njobs = disrui(stream, &rc);	/* number of jobs in update */
 	if (rc)
@@ -2334,6 +2377,15 @@ stat_update(int stream)
 			if (pjob->ji_wattr[(int)JOB_ATR_session_id].at_flags & ATR_VFLAG_SET)
 				old_sid = pjob->ji_wattr[(int)JOB_ATR_session_id].at_val.at_long;
 
+			/* keep the old usage to tell whether it really changed */
+			memset(&old_used, 0, sizeof(old_used));
+			old_used.at_type = ATR_TYPE_RESC;
+			CLEAR_HEAD(old_used.at_val.at_list);
+			old_used_mod = pjob->ji_wattr[(int)JOB_ATR_resc_used].at_flags & ATR_VFLAG_MODIFY;
+			if (pjob->ji_wattr[(int)JOB_ATR_resc_used].at_flags & ATR_VFLAG_SET)
+				(void)job_attr_def[(int)JOB_ATR_resc_used].at_set(&old_used,
+					&pjob->ji_wattr[(int)JOB_ATR_resc_used], SET);
+
 			/* update all the attributes sent from Mom */
 			sattrl = (svrattrl *)GET_NEXT(rused.ru_attr);
 			if(sattrl != NULL) {
@@ -2390,9 +2442,15 @@ stat_update(int stream)
 				/* session id was set to same old value   */
 				/* so only need to save things to disk    */
 				/* if something other than the session id */
-				/* or resources_used was modified         */
+				/* was modified, or resources_used values */
+				/* actually changed (Mom resends them all */
+				/* periodically)			  */
 
 				pjob->ji_wattr[(int)JOB_ATR_session_id].at_flags &= ~ATR_VFLAG_MODIFY;
+				if (!old_used_mod &&
+					(pjob->ji_wattr[(int)JOB_ATR_resc_used].at_flags & ATR_VFLAG_MODIFY) &&
+					!resc_used_differ(&old_used, &pjob->ji_wattr[(int)JOB_ATR_resc_used]))
+					pjob->ji_wattr[(int)JOB_ATR_resc_used].at_flags &= ~ATR_VFLAG_MODIFY;
 				for (i=0; i<JOB_ATR_LAST; ++i) {
 					if (pjob->ji_wattr[i].at_flags & ATR_VFLAG_MODIFY) {
 						job_save(pjob, SAVEJOB_FULL);
@@ -2401,6 +2459,7 @@ stat_update(int stream)
 				}
 				pjob->ji_modified = 0;
 			}
+			job_attr_def[(int)JOB_ATR_resc_used].at_free(&old_used);
 		}
 		(void)free(rused.ru_comment);
 		rused.ru_comment = NULL;
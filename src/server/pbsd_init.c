@@ -976,6 +976,7 @@ pbsd_init(int type)
 	} else {
 		/* Now, for each job found ... */
 		numjobs = 0;
+		svr_histjobs_recov(1);
 		while ((rc = pbs_db_cursor_next(conn, state, &obj)) == 0) {
 			if ((pjob = job_recov(dbjob.ji_jobid)) == NULL) {
 				if ((type == RECOV_COLD) || (type == RECOV_CREATE)) {
@@ -1022,6 +1023,7 @@ pbsd_init(int type)
 				(void)update_svrlive();
 			}
 		}
+		svr_histjobs_recov(0);
 
 		sprintf(log_buffer, msg_init_exptjobs,
 			server.sv_qs.sv_numjobs);
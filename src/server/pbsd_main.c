@@ -279,6 +279,9 @@ int             ping_nodes_rate = SVR_DEFAULT_PING_RATE; /* time between ping no
 pbs_list_head	svr_deferred_req;
 pbs_list_head	svr_queues;            /* list of queues                   */
 pbs_list_head	svr_alljobs;           /* list of all jobs in server       */
+pbs_list_head	svr_jobs_by_state[PBS_NUMJOBSTATE]; /* svr_alljobs by state */
+pbs_list_head	svr_histjobs;          /* history jobs, oldest history_timestamp first */
+pbs_list_head	svr_histwarm;          /* history jobs not yet packed, see job_hist_pack() */
 pbs_list_head	svr_newjobs;           /* list of incomming new jobs       */
 pbs_list_head	svr_allresvs;          /* all reservations in server */
 pbs_list_head	svr_newresvs;          /* temporary list for new resv jobs */
@@ -410,6 +413,7 @@ go_to_background()
 	int	rc;
 
 	lock_out(lockfds, F_UNLCK);
+	acct_sync();
 	rc = fork();
 	if (rc == -1) { /* fork failed */
 		log_err(errno, msg_daemonname, "fork failed");
@@ -613,13 +617,16 @@ static void
 clear_exec_vnode()
 {
 	job *pjob;
-
-	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob;
-		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
-		if ((pjob->ji_qs.ji_state != JOB_STATE_RUNNING) &&
-			(pjob->ji_qs.ji_state != JOB_STATE_FINISHED) &&
-			(pjob->ji_qs.ji_state != JOB_STATE_MOVED) &&
-			(pjob->ji_qs.ji_state != JOB_STATE_EXITING)) {
+	int  state;
+
+	for (state = 0; state < PBS_NUMJOBSTATE; state++) {
+		if ((state == JOB_STATE_RUNNING) ||
+			(state == JOB_STATE_FINISHED) ||
+			(state == JOB_STATE_MOVED) ||
+			(state == JOB_STATE_EXITING))
+			continue;
+		for (pjob = (job *)GET_NEXT(svr_jobs_by_state[state]); pjob;
+			pjob = (job *)GET_NEXT(pjob->ji_statejobs)) {
 			if (((pjob->ji_wattr[(int)JOB_ATR_exec_vnode].at_flags &
 				ATR_VFLAG_SET) != 0) &&
 				((pjob->ji_qs.ji_svrflags & JOB_SVFLG_CHKPT) == 0)) {
@@ -781,20 +788,12 @@ reap_child(void)
 			reap_child_flag = 0;
 			return;
 		}
-		ptask = (struct work_task *)GET_NEXT(task_list_event);
-		while (ptask) {
-			if ((ptask->wt_type == WORK_Deferred_Child) &&
-#ifdef WIN32
-				((HANDLE)ptask->wt_event == pid))
-#else
-				(ptask->wt_event == pid))
-#endif
-			{
-				ptask->wt_type = WORK_Deferred_Cmp;
-				ptask->wt_aux = (int)statloc;	/* exit status */
-				svr_delay_entry++;	/* see next_task() */
-			}
-			ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+		/* a task no longer matches once marked complete */
+		while ((ptask = find_work_task(WORK_Deferred_Child,
+			(long)pid, NULL)) != NULL) {
+			ptask->wt_type = WORK_Deferred_Cmp;
+			ptask->wt_aux = (int)statloc;	/* exit status */
+			svr_delay_entry++;	/* see next_task() */
 		}
 	}
 }
@@ -1266,6 +1265,10 @@ main(int argc, char **argv)
 	CLEAR_HEAD(task_list_event);
 	CLEAR_HEAD(svr_queues);
 	CLEAR_HEAD(svr_alljobs);
+	for (i = 0; i < PBS_NUMJOBSTATE; i++)
+		CLEAR_HEAD(svr_jobs_by_state[i]);
+	CLEAR_HEAD(svr_histjobs);
+	CLEAR_HEAD(svr_histwarm);
 	CLEAR_HEAD(svr_newjobs);
 	CLEAR_HEAD(svr_allresvs);
 	CLEAR_HEAD(svr_newresvs);
@@ -1754,6 +1757,10 @@ try_db_again:
 	/* Protect from being killed by kernel */
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
 
+	/* now that we are detached, log from a writer thread if asked to */
+	if (log_async_start() != 0)
+		log_err(errno, msg_daemonname, "unable to start asynchronous logging");
+
 #ifdef _POSIX_MEMLOCK
 	if (do_mlockall == 1) {
 		if (mlockall(MCL_CURRENT|MCL_FUTURE) == -1) {
@@ -2406,9 +2413,12 @@ start_hot_jobs()
 	char        *nodename;
 
 	job *pjob;
+	job *nxpjob;
 
-	pjob = (job *)GET_NEXT(svr_alljobs);
+	pjob = (job *)GET_NEXT(svr_jobs_by_state[JOB_STATE_QUEUED]);
 	while (pjob) {
+		/* starting the job moves it off the queued state list */
+		nxpjob = (job *)GET_NEXT(pjob->ji_statejobs);
 		if ((pjob->ji_qs.ji_substate == JOB_SUBSTATE_QUEUED) &&
 			(pjob->ji_qs.ji_svrflags & JOB_SVFLG_HOTSTART)) {
 			if ((pjob->ji_wattr[(int)JOB_ATR_exec_vnode].at_flags &
@@ -2430,7 +2440,7 @@ start_hot_jobs()
 				pjob->ji_qs.ji_svrflags &= ~JOB_SVFLG_HOTSTART;
 			}
 		}
-		pjob = (job *)GET_NEXT(pjob->ji_alljobs);
+		pjob = nxpjob;
 	}
 	return (ct);
 }
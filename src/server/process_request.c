@@ -134,6 +134,7 @@ extern void   req_stat_hook(struct batch_request *);
 static void freebr_manage(struct rq_manage *);
 static void freebr_cpyfile(struct rq_cpyfile *);
 static void freebr_cpyfile_cred(struct rq_cpyfile_cred *);
+static void freebr_submitjobs(struct rq_submitjobs *);
 static void close_quejob(int sfds);
 
 #ifdef	PBS_CRED_DCE_KRB5
@@ -695,6 +696,7 @@ process_request(int sfds)
 			case PBS_BATCH_UserMigrate:
 			case PBS_BATCH_MoveJob:
 			case PBS_BATCH_QueueJob:
+			case PBS_BATCH_SubmitJobs:
 			case PBS_BATCH_RunJob:
 			case PBS_BATCH_StageIn:
 			case PBS_BATCH_jobscript:
@@ -929,6 +931,10 @@ dispatch_request(int sfds, struct batch_request *request)
 			break;
 
 #ifndef PBS_MOM
+		case PBS_BATCH_SubmitJobs:
+			req_submitjobs(request);
+			break;
+
 		case PBS_BATCH_SubmitResv:
 			req_resvSub(request);
 			break;
@@ -1592,6 +1598,9 @@ free_br(struct batch_request *preq)
 			if (preq->rq_ind.rq_jobfile.rq_data)
 				free(preq->rq_ind.rq_jobfile.rq_data);
 			break;
+		case PBS_BATCH_SubmitJobs:
+			freebr_submitjobs(&preq->rq_ind.rq_submitjobs);
+			break;
 
 #ifndef PBS_MOM		/* Server Only */
 
@@ -1678,6 +1687,28 @@ freebr_cpyfile_cred(struct rq_cpyfile_cred *pcfc)
 	if (pcfc->rq_pcred)
 		free(pcfc->rq_pcred);
 }
+/**
+ * @brief
+ * 		remove the list of jobs of a SubmitJobs request along with
+ *		their attributes and scripts, and the shared script.
+ *
+ * @param[in]	psj - rq_submitjobs structure
+ */
+static void
+freebr_submitjobs(struct rq_submitjobs *psj)
+{
+	struct rq_submitjob *pjob;
+
+	while ((pjob = (struct rq_submitjob *)GET_NEXT(psj->rq_jobs)) != NULL) {
+		delete_link(&pjob->rq_link);
+		free_attrlist(&pjob->rq_attr);
+		if (pjob->rq_script)
+			(void)free(pjob->rq_script);
+		(void)free(pjob);
+	}
+	if (psj->rq_script)
+		free(psj->rq_script);
+}
 
 /**
  * @brief
@@ -83,7 +83,6 @@ extern char *msg_daemonname;
 extern char *msg_system;
 
 #ifndef PBS_MOM
-extern pbs_list_head task_list_event;
 extern pbs_list_head task_list_immed;
 char   *resc_in_err = NULL;
 #endif	/* PBS_MOM */
@@ -272,16 +271,12 @@ reply_send(struct batch_request *request)
 		 * for freeing the batch_request structure.
 		 */
 
-		ptask = (struct work_task *)GET_NEXT(task_list_event);
-		while (ptask) {
-			if ((ptask->wt_type == WORK_Deferred_Local) &&
-				(ptask->wt_parm1 == (void *)request)) {
-				delete_link(&ptask->wt_linkall);
-				append_link(&task_list_immed,
-					&ptask->wt_linkall, ptask);
-				return (0);
-			}
-			ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+		ptask = find_work_task(WORK_Deferred_Local,
+			PBS_LOCAL_CONNECTION, (void *)request);
+		if (ptask) {
+			unlink_task_event(ptask);
+			append_link(&task_list_immed, &ptask->wt_linkall, ptask);
+			return (0);
 		}
 
 		/* Uh Oh, should have found a task and didn't */
@@ -4215,6 +4215,7 @@ mgr_resource_delete(struct batch_request *preq)
 			free(prdef);
 			prdef = NULL;
 			svr_resc_size--;
+			reset_resc_def_idx();
 			break;
 		}
 	}
@@ -41,7 +41,8 @@
  *
  * @brief
  * 		Functions relating to the Queue Job Batch Request sequence, including
- * 		Queue Job, Job Script, Ready to Commit, and Commit.
+ * 		Queue Job, Job Script, Ready to Commit, and Commit, and to the
+ * 		Submit Jobs request which runs that sequence for several jobs.
  *
  * Included functions are:
  * 	validate_perm_res_in_select()
@@ -57,6 +58,10 @@
  *	req_mvjobfile()
  *	req_commit()
  *	locate_new_job()
+ *	submitjobs_subreq()
+ *	submitjobs_reply()
+ *	submitjobs_purge()
+ *	req_submitjobs()
  *	req_resvSub()
  *	get_queue_for_reservation()
  *	ignore_attr()
@@ -1870,7 +1875,8 @@ req_jobscript(struct batch_request *preq)
 	u_Long size;
 #endif
 
-	pj = locate_new_job(preq, NULL);
+	pj = locate_new_job(preq, (preq->rq_ind.rq_jobfile.rq_jobid[0] != '\0') ?
+		preq->rq_ind.rq_jobfile.rq_jobid : NULL);
 	if (pj == NULL) {
 		req_reject(PBSE_IVALREQ, 0, preq);
 		return;
@@ -2496,8 +2502,9 @@ req_commit(struct batch_request *preq)
  *		This function is used by the sub-requests which make up the global
  *		"Queue Job Request" to locate the job structure.
  *
- *		If the jobid is specified (will be for rdytocommit and commit, but not
- *		for script), we search for a matching jobid.
+ *		If the jobid is specified (will be for rdytocommit and commit, and for
+ *		script when the job is named, as by req_submitjobs()), we search for
+ *		a matching jobid.
  *
  *		The job must (also) match the socket specified and the host associated
  *		with the socket unless ji_fromsock == -1, then its a recovery situation.
@@ -2549,6 +2556,242 @@ locate_new_job(struct batch_request *preq, char *jobid)
 
 
 #ifndef PBS_MOM	/* SERVER only */
+/**
+ * @brief
+ *		Make a sub-request of a SubmitJobs request.
+ *
+ * @par Functionality:
+ *		The sub-request comes from the same user and connection as the
+ *		SubmitJobs request.  Its reference count is held at one so that
+ *		reply_send() keeps its reply for submitjobs_reply() instead of
+ *		sending it to the client.
+ *
+ * @param[in]	preq	-	the SubmitJobs request
+ * @param[in]	type	-	type of the sub-request
+ *
+ * @return	struct batch_request *
+ * @retval	the sub-request	- success
+ * @retval	NULL	- out of memory
+ */
+
+static struct batch_request *
+submitjobs_subreq(struct batch_request *preq, int type)
+{
+	struct batch_request *psub;
+
+	if ((psub = alloc_br(type)) == NULL)
+		return NULL;
+
+	psub->rq_perm = preq->rq_perm;
+	psub->rq_fromsvr = preq->rq_fromsvr;
+	psub->rq_conn = preq->rq_conn;
+	psub->rq_orgconn = preq->rq_orgconn;
+	psub->rq_time = preq->rq_time;
+	psub->isrpp = preq->isrpp;
+	(void)strcpy(psub->rq_user, preq->rq_user);
+	(void)strcpy(psub->rq_host, preq->rq_host);
+	psub->rq_refct = 1;
+	return psub;
+}
+
+/**
+ * @brief
+ *		Collect the reply of a processed sub-request of a SubmitJobs
+ *		request and free the sub-request.
+ *
+ * @par Functionality:
+ *		If the sub-request failed, its reply becomes the reply of the
+ *		SubmitJobs request.
+ *
+ * @param[in,out]	preq	-	the SubmitJobs request
+ * @param[in]	psub	-	the sub-request
+ * @param[out]	jobid	-	if not NULL, set to the job id a Queue Job
+ *					sub-request replied with
+ *
+ * @return	int
+ * @retval	0	- the sub-request succeeded
+ * @retval	!=0	- PBS error code of the sub-request
+ */
+
+static int
+submitjobs_reply(struct batch_request *preq, struct batch_request *psub,
+	char *jobid)
+{
+	int rc = psub->rq_reply.brp_code;
+
+	if (rc != 0) {
+		reply_free(&preq->rq_reply);
+		preq->rq_reply = psub->rq_reply;
+		psub->rq_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+	} else if (jobid != NULL) {
+		if (psub->rq_reply.brp_choice == BATCH_REPLY_CHOICE_Queue)
+			(void)strcpy(jobid, psub->rq_reply.brp_un.brp_jid);
+		else
+			rc = PBSE_SYSTEM;
+	}
+	psub->rq_refct = 0;
+	free_br(psub);
+	return rc;
+}
+
+/**
+ * @brief
+ *		Purge the jobs a SubmitJobs request has committed so far and
+ *		free their list.
+ *
+ * @param[in]	psel	-	list of the job ids
+ */
+
+static void
+submitjobs_purge(struct brp_select *psel)
+{
+	struct brp_select	*pnext;
+	job			*pj;
+
+	for (; psel != NULL; psel = pnext) {
+		pnext = psel->brp_next;
+		if ((pj = find_job(psel->brp_jobid)) != NULL)
+			job_purge(pj);
+		free(psel);
+	}
+}
+
+/**
+ * @brief
+ *		"SubmitJobs" Batch Request processing routine
+ *
+ * @par Functionality:
+ *		Each job of the request goes through req_quejob(), req_jobscript()
+ *		and req_commit(), as if the Queue Job, Job Script and Commit
+ *		requests of the job had come over the connection one after the
+ *		other, and all of the jobs are saved in one database transaction.
+ *		If any job is rejected, the jobs committed so far are purged, the
+ *		transaction is rolled back and the request gets the reply of the
+ *		rejected step.  Otherwise the reply is the list of the new job ids.
+ *
+ * @param[in]	preq	-	ptr to the decoded request
+ */
+
+void
+req_submitjobs(struct batch_request *preq)
+{
+	struct rq_submitjobs	*psj = &preq->rq_ind.rq_submitjobs;
+	struct rq_submitjob	*pjs;
+	struct batch_request	*psub;
+	struct brp_select	*psel = NULL;
+	struct brp_select	*sel_head = NULL;
+	struct brp_select	**sel_tail = &sel_head;
+	char			 jobid[PBS_MAXSVRJOBID+1];
+	job			*pj;
+	int			 rc = 0;
+	pbs_db_conn_t		*conn = (pbs_db_conn_t *) svr_db_conn;
+
+	if (preq->rq_fromsvr || (psj->rq_numjobs == 0)) {
+		req_reject(PBSE_IVALREQ, 0, preq);
+		return;
+	}
+
+	/* the saves in req_commit() nest in this transaction */
+	pbs_db_begin_trx(conn, 0, 0);
+
+	for (pjs = (struct rq_submitjob *)GET_NEXT(psj->rq_jobs); pjs != NULL;
+		pjs = (struct rq_submitjob *)GET_NEXT(pjs->rq_link)) {
+
+		jobid[0] = '\0';
+		psel = (struct brp_select *)malloc(sizeof(struct brp_select));
+		if (psel == NULL) {
+			rc = PBSE_SYSTEM;
+			break;
+		}
+
+		/* Queue Job */
+		if ((psub = submitjobs_subreq(preq, PBS_BATCH_QueueJob)) == NULL) {
+			rc = PBSE_SYSTEM;
+			break;
+		}
+		(void)strcpy(psub->rq_ind.rq_queuejob.rq_destin, pjs->rq_destin);
+		CLEAR_HEAD(psub->rq_ind.rq_queuejob.rq_attr);
+		list_move(&pjs->rq_attr, &psub->rq_ind.rq_queuejob.rq_attr);
+		req_quejob(psub);
+		if ((rc = submitjobs_reply(preq, psub, jobid)) != 0)
+			break;
+
+		/* Job Script, the job's own or the shared one */
+		if ((pjs->rq_script != NULL) || (psj->rq_scriptsz > 0)) {
+			if ((psub = submitjobs_subreq(preq, PBS_BATCH_jobscript)) == NULL) {
+				rc = PBSE_SYSTEM;
+				break;
+			}
+			(void)strcpy(psub->rq_ind.rq_jobfile.rq_jobid, jobid);
+			psub->rq_ind.rq_jobfile.rq_type = (int)JScript;
+			if (pjs->rq_script != NULL) {
+				psub->rq_ind.rq_jobfile.rq_data = pjs->rq_script;
+				psub->rq_ind.rq_jobfile.rq_size = pjs->rq_scriptsz;
+			} else {
+				psub->rq_ind.rq_jobfile.rq_data = psj->rq_script;
+				psub->rq_ind.rq_jobfile.rq_size = psj->rq_scriptsz;
+			}
+			req_jobscript(psub);
+			/* the script still belongs to the SubmitJobs request */
+			psub->rq_ind.rq_jobfile.rq_data = NULL;
+			if ((rc = submitjobs_reply(preq, psub, NULL)) != 0)
+				break;
+		}
+
+		/* Commit */
+		if ((psub = submitjobs_subreq(preq, PBS_BATCH_Commit)) == NULL) {
+			rc = PBSE_SYSTEM;
+			break;
+		}
+		(void)strcpy(psub->rq_ind.rq_commit, jobid);
+		req_commit(psub);
+		if ((rc = submitjobs_reply(preq, psub, NULL)) != 0) {
+			jobid[0] = '\0';	/* req_commit() purged it */
+			break;
+		}
+
+		(void)strcpy(psel->brp_jobid, jobid);
+		psel->brp_next = NULL;
+		*sel_tail = psel;
+		sel_tail = &psel->brp_next;
+		psel = NULL;
+	}
+
+	if (rc != 0) {
+		free(psel);
+		/* a job queued but not yet committed is still a new job */
+		if ((jobid[0] != '\0') &&
+			((pj = locate_new_job(preq, jobid)) != NULL)) {
+			delete_link(&pj->ji_alljobs);
+			job_purge(pj);
+		}
+		submitjobs_purge(sel_head);
+		(void)pbs_db_end_trx(conn, PBS_DB_ROLLBACK);
+		if (preq->rq_reply.brp_code == 0)
+			req_reject(rc, 0, preq);
+		else
+			(void)reply_send(preq);
+		return;
+	}
+
+	if (pbs_db_end_trx(conn, PBS_DB_COMMIT) != 0) {
+		submitjobs_purge(sel_head);
+		req_reject(PBSE_SYSTEM, 0, preq);
+		return;
+	}
+
+	sprintf(log_buffer, "%d jobs submitted in one request",
+		psj->rq_numjobs);
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_INFO,
+		__func__, log_buffer);
+
+	preq->rq_reply.brp_code = 0;
+	preq->rq_reply.brp_auxcode = 0;
+	preq->rq_reply.brp_choice = BATCH_REPLY_CHOICE_Select;
+	preq->rq_reply.brp_un.brp_select = sel_head;
+	(void)reply_send(preq);
+}
+
 /**
  * @brief
  *		"resvSub" Batch Request processing routine
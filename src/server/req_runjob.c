@@ -290,6 +290,13 @@ call_to_process_hooks(struct batch_request *preq, char *hook_msg, size_t msg_len
  * @par
  *		This request forces a job into execution.  Client must be privileged.
  *
+ * @par
+ *		For a range of subjobs the destination may hold one exec_vnode per
+ *		subjob index in the range, in index order and separated by newlines,
+ *		so that the Scheduler can run a batch of subjobs, each with its own
+ *		placement, in one request.  A destination without a newline is used
+ *		for every subjob of the range, as before.
+ *
  * @param[in]	preq	-	Run Job Requests
  */
 
@@ -307,6 +314,10 @@ req_runjob(struct batch_request *preq)
 	job		 *pjobsub = NULL;
 	job		 *parent  = NULL;
 	char		 *range;
+	char		 *destins;
+	char		 *nextdest = NULL;
+	int		  ndest = 0;
+	int		  nidx = 0;
 	int		  x, y, z;
 	struct deferred_request *pdefr;
 	char		  hook_msg[HOOK_MSG_SIZE];
@@ -406,6 +417,7 @@ req_runjob(struct batch_request *preq)
 				return;
 			} else if (i == 1)
 				break;	/* no more in the range */
+			nidx += j;
 			for (; x <= y; x += z) {
 				if ((i = numindex_to_offset(parent, x)) >= 0) {
 					if (get_subjob_state(parent, i) == JOB_STATE_QUEUED)
@@ -418,6 +430,18 @@ req_runjob(struct batch_request *preq)
 			req_reject(PBSE_BADSTATE, 0, preq);
 			return;
 		}
+
+		/* one exec_vnode per subjob index, or one for all of them */
+		destins = preq->rq_ind.rq_run.rq_destin;
+		if ((destins != NULL) && (strchr(destins, '\n') != NULL)) {
+			ndest = 1;
+			for (pc = destins; (pc = strchr(pc, '\n')) != NULL; pc++)
+				ndest++;
+			if (ndest != nidx) {
+				req_reject(PBSE_IVALREQ, 0, preq);
+				return;
+			}
+		}
 	}
 
 	/* At this point, we know the basic request to run the job */
@@ -556,6 +580,12 @@ req_runjob(struct batch_request *preq)
 		return;
 	}
 
+	/* with one exec_vnode per subjob, split them up in place; the */
+	/* requests made for the subjobs point into the parent's copy  */
+	destins = preq->rq_ind.rq_run.rq_destin;
+	if (ndest > 0)
+		nextdest = destins;
+
 	++preq->rq_refct;
 
 	while (1) {
@@ -565,6 +595,12 @@ req_runjob(struct batch_request *preq)
 		} else if (i == 1)
 			break;
 		for (; x <= y; x += z) {
+			if (nextdest != NULL) {
+				preq->rq_ind.rq_run.rq_destin = nextdest;
+				nextdest = strchr(nextdest, '\n');
+				if (nextdest != NULL)
+					*nextdest++ = '\0';
+			}
 			i = numindex_to_offset(parent, x);
 			if (i < 0) {
 				continue;
@@ -582,6 +618,7 @@ req_runjob(struct batch_request *preq)
 							pbs_python_set_interrupt) == 0) {
 						/* subjob reject from hook*/
 						job_purge(pjobsub);
+						preq->rq_ind.rq_run.rq_destin = destins;
 						reply_text(preq, PBSE_HOOKERROR, hook_msg);
 						return;
 					}
@@ -597,7 +634,7 @@ req_runjob(struct batch_request *preq)
 		}
 		range = pc;
 	}
-
+	preq->rq_ind.rq_run.rq_destin = destins;
 
 	/* if not waiting on any running subjobs, can reply; else */
 	/* it is taken care of when last running subjob responds  */
@@ -1567,6 +1604,7 @@ post_sendmom(struct work_task *pwt)
 					/* to issue a kill job signal to mom */
 					jobp->ji_qs.ji_state = JOB_STATE_QUEUED;
 					jobp->ji_qs.ji_substate = JOB_SUBSTATE_QUEUED;
+					svr_jobidx_state(jobp);
 					(void)job_abt(jobp, msg_hook_reject_deletejob);
 					break;
 				} else if ((r == SEND_JOB_HOOKERR) ||
@@ -100,7 +100,7 @@ build_selist(svrattrl *, int perm, struct  select_list **,
 	pbs_queue **, int *bad, char **pstate);
 static void free_sellist(struct select_list *pslist);
 static int  sel_attr(attribute *, struct select_list *);
-static int  select_job(job *, struct select_list *, int, int);
+static int  select_job(job *, struct select_list *, int, int, int *);
 static int  select_subjob(int, struct select_list *);
 
 
@@ -305,6 +305,114 @@ add_select_array_entries(job *pjob, int dosub, char *statelist,
 	return ct;
 }
 
+/**
+ * @brief
+ * 		cmp_job_qrank - compare two jobs by queue rank, for qsort()
+ *
+ * @param[in]	a	-	pointer to first job pointer
+ * @param[in]	b	-	pointer to second job pointer
+ *
+ * @return	int
+ * @retval	<0, 0, >0	: as qrank of a is less, equal or greater than b
+ */
+static int
+cmp_job_qrank(const void *a, const void *b)
+{
+	unsigned long ra;
+	unsigned long rb;
+
+	ra = (unsigned long)(*(job **)a)->ji_wattr[(int)JOB_ATR_qrank].at_val.at_long;
+	rb = (unsigned long)(*(job **)b)->ji_wattr[(int)JOB_ATR_qrank].at_val.at_long;
+	if (ra < rb)
+		return -1;
+	return (ra > rb);
+}
+
+/**
+ * @brief
+ * 		select_by_state - use the server's job state indexes to gather the
+ *		candidate jobs for a select request when the request cannot match
+ *		jobs in some states, so that svr_alljobs need not be walked.
+ *		The candidates are returned in queue rank order, the order of
+ *		svr_alljobs.  Only used when the candidates are a small part of
+ *		all jobs, e.g. when most jobs are history jobs.
+ *
+ * @param[in]	psel	-	selection list
+ * @param[in]	dosubjobs	-	as in req_selectjobs()
+ * @param[in]	dohistjobs	-	as in req_selectjobs()
+ * @param[out]	njobs	-	number of jobs in the returned array
+ *
+ * @return	job **
+ * @retval	NULL	: walk svr_alljobs instead
+ * @retval	!NULL	: malloc-ed array of *njobs candidate jobs
+ */
+static job **
+select_by_state(struct select_list *psel, int dosubjobs, int dohistjobs, int *njobs)
+{
+	int	 want[PBS_NUMJOBSTATE];
+	int	 nwant = PBS_NUMJOBSTATE;
+	int	 ct = 0;
+	int	 i;
+	job	*pjob;
+	job	**jobs;
+
+	for (i = 0; i < PBS_NUMJOBSTATE; i++)
+		want[i] = 1;
+
+	/* see select_job(), history jobs are skipped unless asked for */
+	if (!dohistjobs) {
+		want[JOB_STATE_FINISHED] = 0;
+		want[JOB_STATE_MOVED] = 0;
+		nwant -= 2;
+	}
+
+	/* an "equal" state selection limits the states, unless it applies to subjobs */
+	if (dosubjobs == 0) {
+		for (; psel; psel = psel->sl_next) {
+			if ((psel->sl_atindx != (int)JOB_ATR_state) || (psel->sl_op != EQ) ||
+				(psel->sl_attr.at_val.at_str == NULL))
+				continue;
+			for (i = 0; i < PBS_NUMJOBSTATE; i++) {
+				if (want[i] && (strchr(psel->sl_attr.at_val.at_str, statechars[i]) == NULL)) {
+					want[i] = 0;
+					nwant--;
+				}
+			}
+		}
+	}
+
+	if (nwant == PBS_NUMJOBSTATE)
+		return NULL;
+
+	for (i = 0; i < PBS_NUMJOBSTATE; i++) {
+		if (!want[i])
+			continue;
+		for (pjob = (job *)GET_NEXT(svr_jobs_by_state[i]); pjob;
+			pjob = (job *)GET_NEXT(pjob->ji_statejobs))
+			ct++;
+	}
+
+	/* not worth sorting when most jobs are candidates anyway */
+	if ((ct * 2) > server.sv_qs.sv_numjobs)
+		return NULL;
+
+	if ((jobs = (job **)malloc((ct + 1) * sizeof(job *))) == NULL)
+		return NULL;
+
+	ct = 0;
+	for (i = 0; i < PBS_NUMJOBSTATE; i++) {
+		if (!want[i])
+			continue;
+		for (pjob = (job *)GET_NEXT(svr_jobs_by_state[i]); pjob;
+			pjob = (job *)GET_NEXT(pjob->ji_statejobs))
+			jobs[ct++] = pjob;
+	}
+	qsort(jobs, ct, sizeof(job *), cmp_job_qrank);
+
+	*njobs = ct;
+	return jobs;
+}
+
 /**
  * @brief
  * 		req_selectjobs - service both the Select Job Request and the (special
@@ -334,6 +442,10 @@ req_selectjobs(struct batch_request *preq)
 	int		    rc;
 	struct select_list *selistp;
 	pbs_sched	   *psched;
+	job		  **seljobs = NULL;
+	int		    nseljobs = 0;
+	int		    isel = 0;
+	int		    packed;
 
 	/*
 	 * if the letter T (or t) is in the extend string,  select subjobs
@@ -398,9 +510,12 @@ req_selectjobs(struct batch_request *preq)
 
 	if (pque)
 		pjob = (job *)GET_NEXT(pque->qu_jobs);
+	else if ((seljobs = select_by_state(selistp, dosubjobs, dohistjobs, &nseljobs)) != NULL)
+		pjob = (nseljobs > 0) ? seljobs[0] : NULL;
 	else
 		pjob = (job *)GET_NEXT(svr_alljobs);
 	while (pjob) {
+		packed = 0;
 		if (server.sv_attr[(int)SRV_ATR_query_others].at_val.at_long ||
 			(svr_authorize_jobreq(preq, pjob) == 0)) {
 
@@ -411,7 +526,7 @@ req_selectjobs(struct batch_request *preq)
 			/* an Array Job, then the State is Not checked.  The State   */
 			/* must be checked against the state of each Subjob	     */
 
-			if (select_job(pjob, selistp, dosubjobs, dohistjobs)) {
+			if (select_job(pjob, selistp, dosubjobs, dohistjobs, &packed)) {
 
 				/* job is selected, include in reply */
 
@@ -447,12 +562,17 @@ req_selectjobs(struct batch_request *preq)
 				}
 			}
 		}
+		if (packed)
+			job_hist_pack(pjob);
 		if (pque)
 			pjob = (job *)GET_NEXT(pjob->ji_jobque);
+		else if (seljobs)
+			pjob = (++isel < nseljobs) ? seljobs[isel] : NULL;
 		else
 			pjob = (job *)GET_NEXT(pjob->ji_alljobs);
 	}
 out:
+	free(seljobs);
 	free_sellist(selistp);
 	if (rc)
 		req_reject(rc, 0, preq);
@@ -469,6 +589,9 @@ out:
  * @param[in]	dosubjobs	-	Does it needs to check the subjob.
  * @param[in]	dohistjobs	-	If not being asked for history jobs specifically,
  * 									then just skip them otherwise include them.
+ * @param[out]	packed	-	set to 1 if the packed attributes of a history
+ *							job were unpacked to check them; the caller
+ *							packs them again
  *
  * @return	int
  * @retval	0	: no match
@@ -476,8 +599,10 @@ out:
  */
 
 static int
-select_job(job *pjob, struct select_list *psel, int dosubjobs, int dohistjobs)
+select_job(job *pjob, struct select_list *psel, int dosubjobs, int dohistjobs,
+	int *packed)
 {
+	struct select_list *pl;
 
 	/*
 	 * If not being asked for history jobs specifically, then just skip
@@ -495,6 +620,16 @@ select_job(job *pjob, struct select_list *psel, int dosubjobs, int dohistjobs)
 		(pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob))
 		return 0;	/* don't bother to look at sub job */
 
+	/* unpack a history job only if a criterion needs a packed attribute */
+	if (pjob->ji_histpack != NULL) {
+		for (pl = psel; pl; pl = pl->sl_next) {
+			if (job_hist_is_cold(pl->sl_atindx)) {
+				*packed = job_hist_unpack(pjob);
+				break;
+			}
+		}
+	}
+
 	while (psel) {
 
 		if (psel->sl_atindx == (int)JOB_ATR_userlst) {
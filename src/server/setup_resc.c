@@ -367,6 +367,7 @@ expand_resc_array(char *rname, int rtype, int rflag)
 
 	pold->rs_next  = pnew;
 	svr_resc_size++;
+	reset_resc_def_idx();
 
 	return 0;
 }
@@ -96,7 +96,7 @@ extern char	     statechars[];
  *	need to obtain and cache new svrattrl values.
  */
 
-static void
+void
 svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 {
 	svrattrl *working = NULL;
@@ -250,6 +250,8 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	long oldtime = 0;
 	int old_elig_flags = 0;
 	int old_atyp_flags = 0;
+	int packed;
+	int rc;
 
 	/* see if the client is authorized to status this job */
 
@@ -265,7 +267,7 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 
 		premain = &pjob->ji_wattr[(int)JOB_ATR_array_indices_remaining];
 		if (premain->at_flags & ATR_VFLAG_MODCACHE) {
-			pnewstr = cvt_range(pjob->ji_ajtrk, JOB_STATE_QUEUED);
+			pnewstr = cvt_range(pjob, JOB_STATE_QUEUED);
 			if (pnewstr == NULL)
 				pnewstr = "-";
 			job_attr_def[JOB_ATR_array_indices_remaining].at_free(premain);
@@ -315,8 +317,12 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	/* add attributes to the status reply */
 
 	*bad = 0;
-	if (status_attrib(pal, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST,
-		preq->rq_perm, &pstat->brp_attr, bad))
+	packed = job_hist_unpack(pjob);
+	rc = status_attrib(pal, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST,
+		preq->rq_perm, &pstat->brp_attr, bad);
+	if (packed)
+		job_hist_pack(pjob);
+	if (rc)
 		return (PBSE_NOATTR);
 
 	/* reset eligible time, it was calctd on the fly, real calctn only when accrue_type changes */
@@ -368,6 +374,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 	int		   oldatypflags = 0;
 	int 		   subjob_state = -1;
 	char 		   *old_subjob_comment = NULL;
+	int		   packed;
 
 	/* see if the client is authorized to status this job */
 
@@ -385,6 +392,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 		/* if parent job state is F and 'x' is present in rq_extend then we set subjob state also as F */
 		if((pjob->ji_qs.ji_state == JOB_STATE_FINISHED) && strchr(preq->rq_extend, (int)'x')) {
 			psubjob->ji_qs.ji_state = JOB_STATE_FINISHED;
+			svr_jobidx_state(psubjob);
 			set_attr_svr(&psubjob->ji_wattr[(int)JOB_ATR_state], &job_attr_def[(int)JOB_ATR_state], &statechars[JOB_STATE_FINISHED]);
 		}
 		status_job(psubjob, preq, pal, pstathd, bad);
@@ -473,9 +481,12 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 		/* 	 not correctly check ATR_VFLAG_SET */
 	}
 
+	packed = job_hist_unpack(pjob);
 	if (status_attrib(pal, job_attr_def, pjob->ji_wattr, limit,
 		preq->rq_perm, &pstat->brp_attr, bad))
 		rc =  PBSE_NOATTR;
+	if (packed)
+		job_hist_pack(pjob);
 
 	/* Set the parent state back to what it really is */
 
@@ -5930,6 +5930,7 @@ start_vnode_provisioning(struct prov_vnode_info * prov_vnode_info)
 #else
 
 	/* Create child process to run TOP-LEVEL provisioning script */
+	acct_sync();
 	pid = fork();
 	if (pid == -1) { /* fork failed */
 		DBPRT(("%s: fork() failed\n", __func__))
@@ -160,6 +160,22 @@ static void running_jobs_count(struct work_task *);
 /** For faster job lookup through AVL tree */
 static void svr_avljob_oper(job *pjob, int delkey);
 
+/** Secondary job indexes by state and owner */
+static void svr_jobidx_add(job *pjob);
+static void svr_jobidx_del(job *pjob);
+static void svr_jobidx_hist(job *pjob);
+static void svr_histjobs_pack(time_t limit);
+
+struct jobidx_owner {
+	pbs_list_head	oi_jobs;	/* jobs of this owner */
+	int		oi_njobs;	/* number of jobs on oi_jobs */
+	char		oi_name[PBS_MAXUSER + 1];
+};
+
+static AVL_IX_DESC *jobidx_owner_tree = NULL;
+static int jobidx_state_ct[PBS_NUMJOBSTATE];
+static int jobidx_hist_recov = 0;	/* see svr_histjobs_recov() */
+
 /* Global Data Items: */
 extern char *msg_noloopbackif;
 extern char *msg_mombadmodify;
@@ -285,6 +301,7 @@ svr_enquejob(job *pjob)
 				 * faster compared to linked list traverse.
 				 */
 				svr_avljob_oper(pjob, 0);
+				svr_jobidx_add(pjob);
 			}
 			server.sv_qs.sv_numjobs++;
 			server.sv_jobstates[pjob->ji_qs.ji_state]++;
@@ -336,6 +353,7 @@ svr_enquejob(job *pjob)
 	 * faster compared to linked list traverse.
 	 */
 	svr_avljob_oper(pjob, 0);
+	svr_jobidx_add(pjob);
 
 	server.sv_qs.sv_numjobs++;
 	server.sv_jobstates[pjob->ji_qs.ji_state]++;
@@ -560,6 +578,7 @@ svr_dequejob(job *pjob)
 		 * added for faster job search i.e. find_job().
 		 */
 		svr_avljob_oper(pjob, 1);
+		svr_jobidx_del(pjob);
 
 		if (--server.sv_qs.sv_numjobs < 0)
 			bad_ct = 1;
@@ -726,6 +745,7 @@ svr_setjobstate(job *pjob, int newstate, int newsubstate)
 
 	pjob->ji_qs.ji_state = newstate;
 	pjob->ji_qs.ji_substate = newsubstate;
+	svr_jobidx_state(pjob);
 	pjob->ji_wattr[(int)JOB_ATR_substate].at_val.at_long = newsubstate;
 	pjob->ji_wattr[(int)JOB_ATR_substate].at_flags |= ATR_VFLAG_MODCACHE;
 
@@ -2896,20 +2916,21 @@ correct_ct(pbs_queue *pqj)
 	log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
 		msg_daemonname, log_buffer);
 
+	/* the server counts are those of the state indexes */
+	for (i=0; i<PBS_NUMJOBSTATE; ++i) {
+		server.sv_jobstates[i] = jobidx_state_ct[i];
+		server.sv_qs.sv_numjobs += jobidx_state_ct[i];
+	}
+
 	for (pque = (pbs_queue *)GET_NEXT(svr_queues); pque;
 		pque = (pbs_queue *)GET_NEXT(pque->qu_link)) {
 		pque->qu_numjobs = 0;
 		for (i=0; i<PBS_NUMJOBSTATE-4; ++i)
 			pque->qu_njstate[i] = 0;
-	}
-
-	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob;
-		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
-		server.sv_qs.sv_numjobs++;
-		server.sv_jobstates[pjob->ji_qs.ji_state]++;
-		if (pjob->ji_qhdr) {
-			(pjob->ji_qhdr)->qu_numjobs++;
-			(pjob->ji_qhdr)->qu_njstate[pjob->ji_qs.ji_state]++;
+		for (pjob = (job *)GET_NEXT(pque->qu_jobs); pjob;
+			pjob = (job *)GET_NEXT(pjob->ji_jobque)) {
+			pque->qu_numjobs++;
+			pque->qu_njstate[pjob->ji_qs.ji_state]++;
 		}
 	}
 	return;
@@ -5241,12 +5262,15 @@ svr_saveorpurge_finjobhist(job *pjob)
 		job_purge(pjob);
 	}
 }
+
 /**
  * @brief
  *		Function name: svr_clean_job_history
  * @par Purpose: Periodically checks for the history jobs in the server and
  *		 purge the history jobs whose history duration exceeds the
  *		 configured job_history_duration server attribute.
+ *		 The history jobs are visited oldest first (see svr_jobidx_hist()),
+ *		 so the walk stops at the first job still within the duration.
  * @par Functionality: It is a work_task and reschedule itself after 2 mins if
  *		 and only if job_history_enable is set.
  *		Output: None
@@ -5259,6 +5283,7 @@ svr_clean_job_history(struct work_task *pwt)
 	job 	*pjob = NULL;
 	job 	*nxpjob = NULL;
 	int 	walltime_used = 0;
+	int 	stamped;
 
 	/*
 	 * Keep track of time spent purging jobs, interrupts purge if necessary.
@@ -5278,16 +5303,17 @@ svr_clean_job_history(struct work_task *pwt)
 	end_time = begin_time;
 
 	/*
-	 * Traverse through the SERVER job list and find the history
-	 * jobs (job with state JOB_STATE_MOVED and JOB_STATE_FINISHED)
-	 * which exceed the configured job_history_duration value and
-	 * purge them immediately.
+	 * Traverse the history jobs (job with state JOB_STATE_MOVED,
+	 * JOB_STATE_FINISHED and JOB_STATE_EXPIRED) in history_timestamp
+	 * order and purge those which exceed the configured
+	 * job_history_duration value immediately.
 	 */
-	pjob = (job *)GET_NEXT(svr_alljobs);
+	pjob = (job *)GET_NEXT(svr_histjobs);
 
 	while (pjob != NULL) {
 		/* save the next job */
-		nxpjob = (job *)GET_NEXT(pjob->ji_alljobs);
+		nxpjob = (job *)GET_NEXT(pjob->ji_histjobs);
+		stamped = 0;
 
 		if ((pjob->ji_qs.ji_state == JOB_STATE_MOVED) ||
 			(pjob->ji_qs.ji_state == JOB_STATE_FINISHED) ||
@@ -5311,12 +5337,20 @@ svr_clean_job_history(struct work_task *pwt)
 				pjob->ji_modified = 1;
 				/* save the full job */
 				(void)job_save(pjob, SAVEJOB_FULL);
+
+				/* move it to its place in the history list */
+				delete_link(&pjob->ji_histjobs);
+				svr_jobidx_hist(pjob);
+				stamped = 1;
 			}
 
 			if (time_now >= (pjob->ji_wattr[(int) JOB_ATR_history_timestamp].at_val.at_long
 				+ svr_history_duration)) {
 				job_purge(pjob);
 				pjob = NULL;
+			} else if (!stamped) {
+				/* all the jobs after this one are more recent */
+				break;
 			}
 		}
 		/* restore the saved next in pjob */
@@ -5356,6 +5390,8 @@ svr_clean_job_history(struct work_task *pwt)
 		}
 	} /* end of while loop through jobs */
 
+	svr_histjobs_pack(begin_time + SVR_CLEAN_JOBHIST_SECS);
+
 	/* We purged everything necessary in this task if we get here.
 	 * set up another work task for next time period.
 	 */
@@ -5414,6 +5450,7 @@ svr_histjob_update(job * pjob, int newstate, int newsubstate)
 	/* set the job state and state char */
 	pjob->ji_qs.ji_state = newstate;
 	pjob->ji_qs.ji_substate = newsubstate;
+	svr_jobidx_state(pjob);
 	set_statechar(pjob);
 
 	/* For subjob update the state */
@@ -5902,6 +5939,578 @@ AVL_OP_FAIL:
 	}
 }
 
+/*
+ * Secondary job indexes.
+ *
+ * Every job on svr_alljobs is also linked, via ji_statejobs, on the list
+ * in svr_jobs_by_state[] for its current state and, via ji_ownerjobs, on
+ * the list for its owner kept in the jobidx_owner_tree AVL tree.  History
+ * jobs are also linked, via ji_histjobs, on svr_histjobs in the order they
+ * expire.  These allow paths which only care about a subset of the jobs
+ * (e.g. history jobs or a single user's jobs) to avoid walking the entire
+ * svr_alljobs list.
+ */
+
+/**
+ * @brief
+ *		jobidx_owner_name - copy the user name portion of the job's
+ *		Job_Owner attribute (user@host) into the supplied buffer.
+ *
+ * @param[in]	pjob	-	job structure
+ * @param[out]	name	-	buffer of at least PBS_MAXUSER+1 bytes
+ *
+ * @return	int
+ * @retval	0	: name set
+ * @retval	-1	: job has no owner
+ */
+static int
+jobidx_owner_name(job *pjob, char *name)
+{
+	char	*owner;
+	size_t	 len;
+
+	if ((pjob->ji_wattr[(int)JOB_ATR_job_owner].at_flags & ATR_VFLAG_SET) == 0)
+		return -1;
+	owner = pjob->ji_wattr[(int)JOB_ATR_job_owner].at_val.at_str;
+	if ((owner == NULL) || (*owner == '\0'))
+		return -1;
+
+	len = strcspn(owner, "@");
+	if (len > PBS_MAXUSER)
+		len = PBS_MAXUSER;
+	(void)strncpy(name, owner, len);
+	name[len] = '\0';
+	return 0;
+}
+
+/**
+ * @brief
+ *		svr_jobidx_add - link a job, just placed on svr_alljobs, onto the
+ *		state and owner indexes.
+ *
+ * @param[in]	pjob	-	job structure
+ *
+ * @see	svr_enquejob()
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+static void
+svr_jobidx_add(job *pjob)
+{
+	struct jobidx_owner *poi;
+	char	owner[PBS_MAXUSER + 1];
+	int	state = pjob->ji_qs.ji_state;
+
+	if ((state >= 0) && (state < PBS_NUMJOBSTATE) &&
+		(pjob->ji_statejobs.ll_next == &pjob->ji_statejobs)) {
+		append_link(&svr_jobs_by_state[state], &pjob->ji_statejobs, pjob);
+		pjob->ji_idxstate = state;
+		jobidx_state_ct[state]++;
+	}
+	svr_jobidx_hist(pjob);
+
+	if ((pjob->ji_owneridx != NULL) || (jobidx_owner_name(pjob, owner) != 0))
+		return;
+
+	if (jobidx_owner_tree == NULL) {
+		jobidx_owner_tree = create_tree(AVL_NO_DUP_KEYS, 0);
+		if (jobidx_owner_tree == NULL) {
+			log_err(errno, __func__, "no memory");
+			return;
+		}
+	}
+
+	poi = (struct jobidx_owner *)find_tree(jobidx_owner_tree, owner);
+	if (poi == NULL) {
+		poi = (struct jobidx_owner *)malloc(sizeof(struct jobidx_owner));
+		if (poi == NULL) {
+			log_err(errno, __func__, "no memory");
+			return;
+		}
+		CLEAR_HEAD(poi->oi_jobs);
+		poi->oi_njobs = 0;
+		(void)strcpy(poi->oi_name, owner);
+		if (tree_add_del(jobidx_owner_tree, poi->oi_name, poi, TREE_OP_ADD) != 0) {
+			log_err(-1, __func__, "failed to add owner to job index");
+			free(poi);
+			return;
+		}
+	}
+	append_link(&poi->oi_jobs, &pjob->ji_ownerjobs, pjob);
+	poi->oi_njobs++;
+	pjob->ji_owneridx = poi;
+}
+
+/**
+ * @brief
+ *		svr_jobidx_del - unlink a job, being removed from svr_alljobs,
+ *		from the state and owner indexes.
+ *
+ * @param[in]	pjob	-	job structure
+ *
+ * @see	svr_dequejob()
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+static void
+svr_jobidx_del(job *pjob)
+{
+	struct jobidx_owner *poi;
+
+	if (pjob->ji_statejobs.ll_next != &pjob->ji_statejobs) {
+		delete_link(&pjob->ji_statejobs);
+		jobidx_state_ct[pjob->ji_idxstate]--;
+	}
+	if (pjob->ji_histjobs.ll_next != &pjob->ji_histjobs)
+		delete_link(&pjob->ji_histjobs);
+	if (pjob->ji_histwarm.ll_next != &pjob->ji_histwarm)
+		delete_link(&pjob->ji_histwarm);
+
+	if ((poi = pjob->ji_owneridx) != NULL) {
+		delete_link(&pjob->ji_ownerjobs);
+		pjob->ji_owneridx = NULL;
+		if (--poi->oi_njobs <= 0) {
+			(void)tree_add_del(jobidx_owner_tree, poi->oi_name, NULL, TREE_OP_DEL);
+			free(poi);
+		}
+	}
+}
+
+/**
+ * @brief
+ *		svr_jobidx_state - move a job to the state index list matching
+ *		its current state.  Must be called whenever ji_qs.ji_state of a
+ *		job on svr_alljobs is changed.
+ *
+ * @param[in]	pjob	-	job structure
+ *
+ * @see	svr_setjobstate()
+ *		svr_histjob_update()
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+void
+svr_jobidx_state(job *pjob)
+{
+	int state = pjob->ji_qs.ji_state;
+
+	/* only jobs already in the index are moved, see svr_jobidx_add() */
+	if (pjob->ji_statejobs.ll_next == &pjob->ji_statejobs)
+		return;
+	if ((pjob->ji_idxstate != state) && (state >= 0) && (state < PBS_NUMJOBSTATE)) {
+		delete_link(&pjob->ji_statejobs);
+		jobidx_state_ct[pjob->ji_idxstate]--;
+		append_link(&svr_jobs_by_state[state], &pjob->ji_statejobs, pjob);
+		pjob->ji_idxstate = state;
+		jobidx_state_ct[state]++;
+	}
+	svr_jobidx_hist(pjob);
+}
+
+/**
+ * @brief
+ *		svr_jobidx_hist - keep a job on svr_histjobs, ordered by
+ *		history_timestamp, while it is a history job (state M, F or X),
+ *		so that svr_clean_job_history() finds the jobs to purge at the
+ *		head of the list.  A history job without a history_timestamp
+ *		(recovered from an older server) goes to the head, where
+ *		svr_clean_job_history() sets one.  A new history job is also
+ *		put on svr_histwarm to have its cold attributes packed.
+ *
+ * @param[in]	pjob	-	job structure
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+static void
+svr_jobidx_hist(job *pjob)
+{
+	job	*prev;
+	long	 stamp = 0;
+	int	 state = pjob->ji_qs.ji_state;
+
+	if ((state != JOB_STATE_MOVED) && (state != JOB_STATE_FINISHED) &&
+		(state != JOB_STATE_EXPIRED)) {
+		if (pjob->ji_histpack != NULL)
+			(void)job_hist_unpack(pjob);
+		if (pjob->ji_histwarm.ll_next != &pjob->ji_histwarm)
+			delete_link(&pjob->ji_histwarm);
+		if (pjob->ji_histjobs.ll_next != &pjob->ji_histjobs)
+			delete_link(&pjob->ji_histjobs);
+		return;
+	}
+	if (pjob->ji_histjobs.ll_next != &pjob->ji_histjobs)
+		return;
+
+	/* packed later by svr_histjobs_pack() */
+	if ((pjob->ji_histpack == NULL) &&
+		(pjob->ji_histwarm.ll_next == &pjob->ji_histwarm))
+		append_link(&svr_histwarm, &pjob->ji_histwarm, pjob);
+
+	if (jobidx_hist_recov) {
+		/* sorted once all the jobs are recovered */
+		append_link(&svr_histjobs, &pjob->ji_histjobs, pjob);
+		return;
+	}
+
+	if (pjob->ji_wattr[(int)JOB_ATR_history_timestamp].at_flags & ATR_VFLAG_SET)
+		stamp = pjob->ji_wattr[(int)JOB_ATR_history_timestamp].at_val.at_long;
+
+	/* jobs mostly become history in time order: search from the tail */
+	for (prev = (job *)GET_PRIOR(svr_histjobs); prev != NULL;
+		prev = (job *)GET_PRIOR(prev->ji_histjobs)) {
+		if (!(prev->ji_wattr[(int)JOB_ATR_history_timestamp].at_flags & ATR_VFLAG_SET) ||
+			(prev->ji_wattr[(int)JOB_ATR_history_timestamp].at_val.at_long <= stamp))
+			break;
+	}
+	if (prev != NULL)
+		insert_link(&prev->ji_histjobs, &pjob->ji_histjobs, pjob, LINK_INSET_AFTER);
+	else
+		insert_link(&svr_histjobs, &pjob->ji_histjobs, pjob, LINK_INSET_AFTER);
+}
+
+/* entry of the array svr_histjobs_recov() sorts */
+struct histjob_ent {
+	job	*he_job;
+	long	 he_stamp;
+	int	 he_set;
+	int	 he_seq;
+};
+
+/**
+ * @brief
+ *		histjob_cmp - qsort compare function ordering history jobs
+ *		as svr_jobidx_hist() does: jobs without a history_timestamp
+ *		first, then by history_timestamp, otherwise in list order.
+ *
+ * @param[in]	a	-	pointer to a struct histjob_ent
+ * @param[in]	b	-	pointer to a struct histjob_ent
+ *
+ * @return	int
+ * @retval	<0, 0, >0	: as for qsort()
+ */
+static int
+histjob_cmp(const void *a, const void *b)
+{
+	const struct histjob_ent *ha = (const struct histjob_ent *)a;
+	const struct histjob_ent *hb = (const struct histjob_ent *)b;
+
+	if (ha->he_set != hb->he_set)
+		return (ha->he_set - hb->he_set);
+	if (ha->he_set && (ha->he_stamp != hb->he_stamp))
+		return ((ha->he_stamp < hb->he_stamp) ? -1 : 1);
+	return (ha->he_seq - hb->he_seq);
+}
+
+/**
+ * @brief
+ *		svr_histjobs_recov - bracket the recovery of jobs at server
+ *		start.  Jobs are recovered in qrank order rather than in
+ *		history_timestamp order, so ordered insertion into svr_histjobs
+ *		would be quadratic; instead history jobs are appended while
+ *		recovering, and the list is sorted once at the end.
+ *
+ * @param[in]	start	-	1 before the jobs are recovered, 0 after
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+void
+svr_histjobs_recov(int start)
+{
+	struct histjob_ent *ents;
+	job	*pjob;
+	int	 ct = 0;
+	int	 i;
+
+	jobidx_hist_recov = start;
+	if (start)
+		return;
+
+	for (pjob = (job *)GET_NEXT(svr_histjobs); pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_histjobs))
+		ct++;
+	if (ct < 2)
+		return;
+
+	ents = (struct histjob_ent *)malloc(ct * sizeof(struct histjob_ent));
+	if (ents == NULL) {
+		log_err(errno, __func__, "no memory, history jobs left unsorted");
+		return;
+	}
+	i = 0;
+	while ((pjob = (job *)GET_NEXT(svr_histjobs)) != NULL) {
+		ents[i].he_job = pjob;
+		ents[i].he_set = (pjob->ji_wattr[(int)JOB_ATR_history_timestamp].at_flags & ATR_VFLAG_SET) ? 1 : 0;
+		ents[i].he_stamp = pjob->ji_wattr[(int)JOB_ATR_history_timestamp].at_val.at_long;
+		ents[i].he_seq = i;
+		delete_link(&pjob->ji_histjobs);
+		i++;
+	}
+	qsort(ents, ct, sizeof(struct histjob_ent), histjob_cmp);
+	for (i = 0; i < ct; i++)
+		append_link(&svr_histjobs, &ents[i].he_job->ji_histjobs, ents[i].he_job);
+	free(ents);
+}
+
+/*
+ * Attributes of a history job which are only needed to status the job
+ * and are packed by job_hist_pack().  They are the bulky ones (variable
+ * list, exec_vnode, resources_used, ...) and are not looked at by the
+ * server's walks of all jobs, which only use the attributes left as is.
+ */
+static const int jobhist_cold_attrs[] = {
+	JOB_ATR_resc_used,
+	JOB_ATR_resc_used_acct,
+	JOB_ATR_resc_used_update,
+	JOB_ATR_errpath,
+	JOB_ATR_outpath,
+	JOB_ATR_exec_host,
+	JOB_ATR_exec_host2,
+	JOB_ATR_exec_host_acct,
+	JOB_ATR_exec_host_orig,
+	JOB_ATR_exec_vnode,
+	JOB_ATR_exec_vnode_acct,
+	JOB_ATR_exec_vnode_deallocated,
+	JOB_ATR_exec_vnode_orig,
+	JOB_ATR_resource_orig,
+	JOB_ATR_resource_acct,
+	JOB_ATR_SchedSelect_orig,
+	JOB_ATR_jobdir,
+	JOB_ATR_stagein,
+	JOB_ATR_stageout,
+	JOB_ATR_variables,
+	JOB_ATR_submit_arguments,
+	JOB_ATR_executable,
+	JOB_ATR_Arglist,
+	JOB_ATR_estimated,
+	JOB_ATR_resc_released,
+	JOB_ATR_resc_released_list
+};
+#define JOBHIST_COLD_CT (sizeof(jobhist_cold_attrs) / sizeof(jobhist_cold_attrs[0]))
+
+/**
+ * @brief
+ *		job_hist_is_cold - is an attribute one that job_hist_pack() packs
+ *
+ * @param[in]	idx	-	job attribute index
+ *
+ * @return	int
+ * @retval	1	: the attribute is packed in history jobs
+ * @retval	0	: it is not
+ */
+int
+job_hist_is_cold(int idx)
+{
+	int	i;
+
+	for (i = 0; i < (int)JOBHIST_COLD_CT; i++)
+		if (jobhist_cold_attrs[i] == idx)
+			return 1;
+	return 0;
+}
+
+/* records in ji_histpack start on this boundary */
+#define JOBHIST_ALIGN(n) (((n) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+/**
+ * @brief
+ *		job_hist_pack - pack the cold attributes of a history job into a
+ *		single buffer, ji_histpack, and free their values.  The buffer
+ *		holds the attributes as svrattrl records encoded for saving, as
+ *		save_attr_fs() writes them to a file.
+ *
+ *		A job whose attributes are packed must have them unpacked with
+ *		job_hist_unpack() before they are used; find_job() does so.
+ *
+ * @param[in,out]	pjob	-	history job
+ *
+ * @return	void
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+void
+job_hist_pack(job *pjob)
+{
+	pbs_list_head	 lhead;
+	svrattrl	*pal;
+	char		*buf;
+	int		 len = 0;
+	int		 off;
+	int		 i;
+	int		 idx;
+
+	if (pjob->ji_histpack != NULL)
+		return;
+
+	CLEAR_HEAD(lhead);
+	for (i = 0; i < JOBHIST_COLD_CT; i++) {
+		idx = jobhist_cold_attrs[i];
+		if ((pjob->ji_wattr[idx].at_flags & ATR_VFLAG_SET) == 0)
+			continue;
+		if (job_attr_def[idx].at_encode(&pjob->ji_wattr[idx], &lhead,
+			job_attr_def[idx].at_name, NULL, ATR_ENCODE_SAVE, NULL) < 0) {
+			free_attrlist(&lhead);
+			return;
+		}
+	}
+	for (pal = (svrattrl *)GET_NEXT(lhead); pal != NULL;
+		pal = (svrattrl *)GET_NEXT(pal->al_link))
+		len += JOBHIST_ALIGN(pal->al_tsize);
+
+	if (len > 0) {
+		if ((buf = malloc(len)) == NULL) {
+			free_attrlist(&lhead);
+			return;
+		}
+		off = 0;
+		while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL) {
+			memcpy(buf + off, pal, pal->al_tsize);
+			off += JOBHIST_ALIGN(pal->al_tsize);
+			delete_link(&pal->al_link);
+			free(pal);
+		}
+		pjob->ji_histpack = buf;
+		pjob->ji_histpacklen = len;
+
+		for (i = 0; i < JOBHIST_COLD_CT; i++) {
+			idx = jobhist_cold_attrs[i];
+			if (pjob->ji_wattr[idx].at_flags & ATR_VFLAG_SET) {
+				job_attr_def[idx].at_free(&pjob->ji_wattr[idx]);
+				clear_attr(&pjob->ji_wattr[idx], &job_attr_def[idx]);
+			}
+		}
+	}
+
+	if (pjob->ji_histwarm.ll_next != &pjob->ji_histwarm)
+		delete_link(&pjob->ji_histwarm);
+}
+
+/**
+ * @brief
+ *		job_hist_unpack - restore the attributes of a history job packed
+ *		by job_hist_pack().  The job goes back on svr_histwarm to be
+ *		packed again by svr_histjobs_pack().
+ *
+ * @param[in,out]	pjob	-	history job
+ *
+ * @return	int
+ * @retval	1	: the attributes were packed and have been restored
+ * @retval	0	: the attributes were not packed
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+int
+job_hist_unpack(job *pjob)
+{
+	svrattrl	*pal;
+	char		*buf = pjob->ji_histpack;
+	int		 off;
+	int		 idx;
+	int		 flags;
+	int		 perm;
+
+	if (buf == NULL)
+		return 0;
+
+	/* restore any resource, see decode_resc() */
+	perm = resc_access_perm;
+	resc_access_perm = ATR_DFLAG_ACCESS;
+
+	for (off = 0; off < pjob->ji_histpacklen; off += JOBHIST_ALIGN(pal->al_tsize)) {
+		pal = (svrattrl *)(buf + off);
+		pal->al_name = (char *)pal + sizeof(svrattrl);
+		if (pal->al_rescln)
+			pal->al_resc = pal->al_name + pal->al_nameln;
+		else
+			pal->al_resc = NULL;
+		if (pal->al_valln)
+			pal->al_value = pal->al_name + pal->al_nameln + pal->al_rescln;
+		else
+			pal->al_value = NULL;
+
+		idx = find_attr(job_attr_def, pal->al_name, JOB_ATR_LAST);
+		if (idx < 0)
+			continue;
+		/* keep the flags of the first (or only) record */
+		flags = pjob->ji_wattr[idx].at_flags & ATR_VFLAG_SET;
+		(void)job_attr_def[idx].at_decode(&pjob->ji_wattr[idx],
+			pal->al_name, pal->al_resc, pal->al_value);
+		if (flags == 0)
+			pjob->ji_wattr[idx].at_flags = pal->al_flags | ATR_VFLAG_SET;
+		pjob->ji_wattr[idx].at_flags |= ATR_VFLAG_MODCACHE;
+	}
+	resc_access_perm = perm;
+
+	free(buf);
+	pjob->ji_histpack = NULL;
+	pjob->ji_histpacklen = 0;
+
+	if (pjob->ji_histwarm.ll_next == &pjob->ji_histwarm)
+		append_link(&svr_histwarm, &pjob->ji_histwarm, pjob);
+	return 1;
+}
+
+/**
+ * @brief
+ *		svr_histjobs_pack - pack the history jobs waiting on svr_histwarm,
+ *		leaving those with work pending, until the time limit is hit.
+ *
+ * @param[in]	limit	-	time after which to stop
+ *
+ * @return	void
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+static void
+svr_histjobs_pack(time_t limit)
+{
+	job	*pjob;
+	job	*nxpjob;
+	int	 ct = 0;
+
+	for (pjob = (job *)GET_NEXT(svr_histwarm); pjob != NULL; pjob = nxpjob) {
+		nxpjob = (job *)GET_NEXT(pjob->ji_histwarm);
+		if (pjob->ji_modified || (GET_NEXT(pjob->ji_svrtask) != NULL))
+			continue;
+		job_hist_pack(pjob);
+		if (((++ct % 1000) == 0) && (time(NULL) > limit))
+			break;
+	}
+}
+
+/**
+ * @brief
+ *		svr_jobs_by_owner - return the list of jobs owned by a user.
+ *		Walk the list with GET_NEXT() on the returned head and then on
+ *		each job's ji_ownerjobs link.
+ *
+ * @param[in]	owner	-	user name, without the "@host" part
+ * @param[out]	ct	-	if not NULL, set to the number of jobs on the list
+ *
+ * @return	pbs_list_head *
+ * @retval	NULL	: the user owns no jobs
+ * @retval	!NULL	: head of the owner's job list
+ */
+pbs_list_head *
+svr_jobs_by_owner(char *owner, int *ct)
+{
+	struct jobidx_owner *poi = NULL;
+
+	if ((owner != NULL) && (jobidx_owner_tree != NULL))
+		poi = (struct jobidx_owner *)find_tree(jobidx_owner_tree, owner);
+
+	if (ct != NULL)
+		*ct = poi ? poi->oi_njobs : 0;
+	return (poi ? &poi->oi_jobs : NULL);
+}
+
 /**
  * @brief
  *	Look into a job's exec_host2 or exec_host attribute
@@ -75,6 +75,7 @@
 #endif
 
 #include "job.h"
+#include "acct.h"
 #include "reservation.h"
 #include "server.h"
 #include "rpp.h"
@@ -639,6 +640,7 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 	 */
 
 #ifndef WIN32
+	acct_sync();
 	mcpid = fork();
 	if (mcpid == -1) { /* Error on fork */
 		log_err(errno, __func__, "fork failed\n");
@@ -906,6 +908,7 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 	 */
 
 #ifndef WIN32
+	acct_sync();
 	mcpid = fork();
 	if (mcpid == -1) { /* Error on fork */
 		log_err(errno, __func__, "fork failed\n");
@@ -90,6 +90,7 @@
 #include "resv_node.h"
 #include "queue.h"
 #include "job.h"
+#include "acct.h"
 #include "reservation.h"
 #include "credential.h"
 #include "ticket.h"
@@ -939,6 +940,7 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 		jobp->ji_script = NULL;
 	}
 
+	acct_sync();
 	pid = fork();
 	if (pid == -1) {	/* Error on fork */
 		log_err(errno, __func__, "fork failed\n");
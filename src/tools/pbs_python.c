@@ -76,6 +76,13 @@
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 #include <pbs_python.h>
 #include <pbs_error.h>
 #include <pbs_entlim.h>
@@ -106,6 +113,10 @@
 
 struct python_interpreter_data  svr_interp_data;
 
+/* set in a process forked by the hook pool to run one hook */
+static int			pool_runner = 0;
+static struct python_script	*pool_script = NULL;
+
 extern 	char		*vnode_state_to_str(int state_bit);
 extern	char		*vnode_sharing_to_str(enum vnode_sharing vns);
 extern	char		*vnode_ntype_to_str(int type);
@@ -2149,6 +2160,331 @@ argv_list_to_str(pbs_list_head *argv_list)
 
 }
 
+#ifndef WIN32
+static struct python_script	**pool_scripts = NULL;	/* compiled hooks */
+static int			pool_nscripts = 0;
+static int			pool_chld_pipe[2] = {-1, -1};	/* SIGCHLD wakeup */
+
+/**
+ * @brief
+ *	Read exactly len bytes.
+ *
+ * @param[in]	fd - descriptor to read
+ * @param[out]	buf - where to put the data
+ * @param[in]	len - number of bytes
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	error or end of file first
+ *
+ */
+static int
+pool_read(int fd, void *buf, size_t len)
+{
+	char	*p = buf;
+	ssize_t	n;
+
+	while (len > 0) {
+		n = read(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Get the hook pool's copy of a hook script, compiled.
+ *
+ * @par
+ *	The script is compiled the first time it is asked for and again
+ *	whenever it changed on disk; runners forked afterwards inherit the
+ *	code object.  A script that fails to compile is left for the runner,
+ *	which reports the error as usual.
+ *
+ * @param[in]	path - hook script
+ *
+ * @return	struct python_script *
+ * @retval	the script	Success
+ * @retval	NULL		no such file or out of memory
+ *
+ */
+static struct python_script *
+pool_get_script(char *path)
+{
+	struct python_script	*ps = NULL;
+	struct python_script	**tmp;
+	int			i;
+
+	for (i = 0; i < pool_nscripts; i++) {
+		if (strcmp(pool_scripts[i]->path, path) == 0) {
+			ps = pool_scripts[i];
+			break;
+		}
+	}
+	if (ps == NULL) {
+		if (pbs_python_ext_alloc_python_script(path, &ps) == -1)
+			return NULL;
+		tmp = realloc(pool_scripts, (pool_nscripts + 1) * sizeof(*tmp));
+		if (tmp == NULL) {
+			pbs_python_ext_free_python_script(ps);
+			free(ps);
+			return NULL;
+		}
+		pool_scripts = tmp;
+		pool_scripts[pool_nscripts++] = ps;
+	}
+	(void)pbs_python_check_and_compile_script(&svr_interp_data, ps);
+	return ps;
+}
+
+/**
+ * @brief
+ *	SIGCHLD handler of a pool worker: wake up pool_serve.
+ *
+ * @param[in]	sig - signal number
+ *
+ * @return	Void
+ *
+ */
+static void
+pool_chld(int sig)
+{
+	int	save = errno;
+
+	(void)write(pool_chld_pipe[1], "", 1);
+	errno = save;
+}
+
+/**
+ * @brief
+ *	Wait for a runner and send its wait status back to the requester.
+ *
+ * @par
+ *	Sleeps until either the runner exits, which pool_chld signals on
+ *	pool_chld_pipe, or the requester goes away first, e.g. MoM killed it
+ *	when the hook alarm went off; in that case the runner's session is
+ *	killed.
+ *
+ * @param[in]	conn - connection from the requester
+ * @param[in]	runner - pid of the runner
+ *
+ * @return	Void, never returns
+ *
+ */
+static void
+pool_serve(int conn, pid_t runner)
+{
+	struct pollfd	pfd[2];
+	int		status = 255 << 8;
+	char		buf[64];
+	pid_t		pid;
+
+	pfd[0].fd = conn;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = pool_chld_pipe[0];
+	pfd[1].events = POLLIN;
+	for (;;) {
+		pid = waitpid(runner, &status, WNOHANG);
+		if (pid == runner)
+			break;
+		if (pid == -1 && errno != EINTR)
+			break;
+		pfd[0].revents = 0;
+		pfd[1].revents = 0;
+		if (poll(pfd, 2, -1) <= 0)
+			continue;
+		if (pfd[0].revents != 0) {
+			(void)kill(-runner, SIGKILL);
+			(void)kill(runner, SIGKILL);
+			(void)waitpid(runner, &status, 0);
+			_exit(0);
+		}
+		while (read(pool_chld_pipe[0], buf, sizeof(buf)) > 0)
+			;
+	}
+	(void)write(conn, &status, sizeof(status));
+	_exit(0);
+}
+
+/**
+ * @brief
+ *	Run as MoM's hook pool: start the interpreter once, then fork a
+ *	runner for each hook request that arrives on sockpath.
+ *
+ * @par
+ *	Each request is served by a forked worker, which forks the runner
+ *	and reports its exit status, so the pool itself never blocks on a
+ *	hook.  The runner is a copy of the pool with the interpreter already
+ *	started and the hook already compiled; it returns from here with
+ *	the request's arguments and goes on as pbs_python --hook would.
+ *	The pool exits when MoM, its parent, does.
+ *
+ * @param[in]	sockpath - unix socket to listen on
+ * @param[out]	pargc - argument count of the request, in a runner
+ * @param[out]	pargv - arguments of the request, in a runner
+ *
+ * @return	Void, only returns in a runner
+ *
+ */
+static void
+hook_pool(char *sockpath, int *pargc, char ***pargv)
+{
+	extern void pbs_python_svr_initialize_interpreter_data(
+		struct python_interpreter_data *interp_data);
+	extern void pbs_python_svr_destroy_interpreter_data(
+		struct python_interpreter_data *interp_data);
+	struct sockaddr_un	addr;
+	struct sigaction	act;
+	struct stat		sbuf;
+	struct stat		sbuf2;
+	struct pollfd		pfd;
+	struct python_script	*ps;
+	pid_t			ppid;
+	pid_t			pid;
+	int			lfd;
+	int			conn;
+	int			len;
+	int			n;
+	int			i;
+	int			status;
+	char			*req;
+	char			*p;
+	char			*cwd;
+	char			*config;
+	char			**av;
+
+	ppid = getppid();
+	(void)signal(SIGPIPE, SIG_IGN);
+
+	svr_interp_data.data_initialized = 0;
+	svr_interp_data.init_interpreter_data =
+		pbs_python_svr_initialize_interpreter_data;
+	svr_interp_data.destroy_interpreter_data =
+		pbs_python_svr_destroy_interpreter_data;
+	svr_interp_data.daemon_name = strdup("pbs_python");
+	if (svr_interp_data.daemon_name == NULL)
+		exit(1);
+	pbs_python_ext_start_interpreter(&svr_interp_data);
+	if (!svr_interp_data.interp_started)
+		exit(1);
+
+	if (strlen(sockpath) >= sizeof(addr.sun_path))
+		exit(2);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, sockpath);
+	if ((lfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		exit(1);
+	(void)unlink(sockpath);
+	if ((bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) ||
+		(chmod(sockpath, 0600) == -1) || (listen(lfd, 64) == -1) ||
+		(stat(sockpath, &sbuf) == -1))
+		exit(1);
+
+	pfd.fd = lfd;
+	pfd.events = POLLIN;
+	for (;;) {
+		while (waitpid(-1, NULL, WNOHANG) > 0)
+			;
+		if (getppid() != ppid) {
+			/* a restarted MoM's pool may have bound the name again */
+			if ((stat(sockpath, &sbuf2) == 0) &&
+				(sbuf2.st_dev == sbuf.st_dev) &&
+				(sbuf2.st_ino == sbuf.st_ino))
+				(void)unlink(sockpath);
+			exit(0);
+		}
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 5000) <= 0)
+			continue;
+		if ((conn = accept(lfd, NULL, NULL)) == -1)
+			continue;
+
+		req = NULL;
+		av = NULL;
+		if ((pool_read(conn, &len, sizeof(len)) == -1) ||
+			(len <= 0) || (len > HOOK_POOL_MAXREQ) ||
+			((req = malloc(len + 1)) == NULL) ||
+			(pool_read(conn, req, len) == -1))
+			goto next;
+		req[len] = '\0';
+
+		/* cwd, config, then at least pbs_python and the script */
+		n = 0;
+		for (p = req; p < req + len; p += strlen(p) + 1)
+			n++;
+		if ((n < 4) || ((av = malloc((n - 1) * sizeof(char *))) == NULL))
+			goto next;
+		cwd = req;
+		config = cwd + strlen(cwd) + 1;
+		i = 0;
+		for (p = config + strlen(config) + 1; p < req + len;
+			p += strlen(p) + 1)
+			av[i++] = p;
+		av[i] = NULL;
+		ps = pool_get_script(av[i - 1]);
+
+		pid = fork();
+		if (pid == 0) {
+			(void)close(lfd);
+			if (pipe(pool_chld_pipe) == -1) {
+				status = 255 << 8;
+				(void)write(conn, &status, sizeof(status));
+				_exit(0);
+			}
+			for (n = 0; n < 2; n++) {
+				(void)fcntl(pool_chld_pipe[n], F_SETFL,
+					fcntl(pool_chld_pipe[n], F_GETFL) | O_NONBLOCK);
+				(void)fcntl(pool_chld_pipe[n], F_SETFD, FD_CLOEXEC);
+			}
+			memset(&act, 0, sizeof(act));
+			sigemptyset(&act.sa_mask);
+			act.sa_handler = pool_chld;
+			act.sa_flags = SA_NOCLDSTOP;
+			(void)sigaction(SIGCHLD, &act, NULL);
+			pid = fork();
+			if (pid == 0) {
+				PyOS_AfterFork();
+				act.sa_handler = SIG_DFL;
+				act.sa_flags = 0;
+				(void)sigaction(SIGCHLD, &act, NULL);
+				(void)close(pool_chld_pipe[0]);
+				(void)close(pool_chld_pipe[1]);
+				(void)close(conn);
+				(void)setsid();
+				(void)signal(SIGPIPE, SIG_DFL);
+				if (chdir(cwd) == -1)
+					exit(2);
+				if (*config != '\0')
+					(void)setenv(PBS_HOOK_CONFIG_FILE, config, 1);
+				else
+					(void)unsetenv(PBS_HOOK_CONFIG_FILE);
+				pool_runner = 1;
+				pool_script = ps;
+				*pargc = i;
+				*pargv = av;
+				return;
+			}
+			if (pid == -1) {
+				status = 255 << 8;
+				(void)write(conn, &status, sizeof(status));
+				_exit(0);
+			}
+			pool_serve(conn, pid);
+		}
+next:
+		(void)close(conn);
+		free(av);
+		free(req);
+	}
+}
+#endif	/* !WIN32 */
+
 /**
  *
  * @brief
@@ -2228,6 +2564,17 @@ main(int argc, char *argv[], char *envp[])
 		svr_resc_def[i].rs_next = &svr_resc_def[i+1];
 	/* last entry is left with null pointer */
 
+#ifndef WIN32
+	if ((argv[1] != NULL) && (strcmp(argv[1], HOOK_POOL_MODE) == 0)) {
+		if (argv[2] == NULL) {
+			fprintf(stderr, "%s %s <socket>\n", argv[0],
+				HOOK_POOL_MODE);
+			exit(2);
+		}
+		hook_pool(argv[2], &argc, &argv);
+	}
+#endif
+
 	if ((argv[1] == NULL) || (strcmp(argv[1], HOOK_MODE) != 0)) {
 #ifdef WIN32
 		/* If this is 64-bit Windows, use 64-bit Python */
@@ -2739,22 +3086,28 @@ main(int argc, char *argv[], char *envp[])
 			strncpy(logname, full_logname, sizeof(logname)-1);
 		}
 
-		/* set python interp data */
-		svr_interp_data.data_initialized = 0;
-		svr_interp_data.init_interpreter_data =
-			pbs_python_svr_initialize_interpreter_data;
-		svr_interp_data.destroy_interpreter_data =
-			pbs_python_svr_destroy_interpreter_data;
+		/* set python interp data, already done in a pool runner */
+		if (!pool_runner) {
+			svr_interp_data.data_initialized = 0;
+			svr_interp_data.init_interpreter_data =
+				pbs_python_svr_initialize_interpreter_data;
+			svr_interp_data.destroy_interpreter_data =
+				pbs_python_svr_destroy_interpreter_data;
 
-		svr_interp_data.daemon_name = strdup("pbs_python");
+			svr_interp_data.daemon_name = strdup("pbs_python");
 
-		if (svr_interp_data.daemon_name == NULL) { /* should not happen */
-			fprintf(stderr, "strdup failed");
-			exit(1);
+			if (svr_interp_data.daemon_name == NULL) { /* should not happen */
+				fprintf(stderr, "strdup failed");
+				exit(1);
+			}
 		}
 
-		(void)pbs_python_ext_alloc_python_script(hook_script,
-			(struct python_script **) &py_script);
+		if ((pool_script != NULL) &&
+			(strcmp(pool_script->path, hook_script) == 0))
+			py_script = pool_script;
+		else
+			(void)pbs_python_ext_alloc_python_script(hook_script,
+				(struct python_script **) &py_script);
 
 		pbs_python_ext_start_interpreter(&svr_interp_data);
 		hook_input_param_init(&req_params);
@@ -45,6 +45,8 @@
  * 	get_cols()
  * 	main()
  * 	parse_log()
+ * 	parse_log_indexed()
+ * 	build_index()
  * 	sort_by_date()
  * 	sort_by_message()
  * 	strip_path()
@@ -63,7 +65,10 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <errno.h>
 #include <termios.h>
+#include <sys/types.h>
+#include <sys/param.h>
 #if defined(HAVE_SYS_IOCTL_H)
 #include <sys/ioctl.h>
 #endif
@@ -84,6 +89,11 @@ int ll_cur_amm;
 int ll_max_amm;
 
 static char none[1] = { '\0' };
+
+#ifdef WIN32
+#define fseeko _fseeki64
+#define ftello _ftelli64
+#endif
 /**
  * @brief
  * 		returns columns, in characters from winsize struct.
@@ -147,6 +157,8 @@ main(int argc, char *argv[])
 	struct stat sbuf;
 #endif /* localmod 022 */
 	int unknw_job = 0;
+	char use_index = 1;
+	char make_index = 0;
 
 	/*the real deal or output pbs_version and exit?*/
 	execution_mode(argc, argv);
@@ -161,12 +173,20 @@ main(int argc, char *argv[])
 
 	pbs_loadconf(0);
 
-	while ((c = getopt(argc, argv, "zvamslw:p:n:f:c:-:")) != EOF) {
+	while ((c = getopt(argc, argv, "zvamslxIw:p:n:f:c:-:")) != EOF) {
 		switch (c) {
 			case 'v':
 				verbose = 1;
 				break;
 
+			case 'x':
+				use_index = 0;
+				break;
+
+			case 'I':
+				make_index = 1;
+				break;
+
 			case 'a':
 				no_acct = 1;
 				break;
@@ -252,9 +272,12 @@ main(int argc, char *argv[])
 
 
 	/* no jobs */
-	if (error || argc == optind) {
+	if (error || (argc == optind && !make_index) || (argc != optind && make_index)) {
 		printf(
-			"USAGE: %s [-a|s|l|m|v] [-w size] [-p path] [-n days] [-f filter_type] job_identifier...\n",
+			"USAGE: %s [-a|s|l|m|v|x] [-w size] [-p path] [-n days] [-f filter_type] job_identifier...\n",
+			strip_path(argv[0]));
+		printf(
+			"       %s -I [-a|s|l|m|v] [-p path] [-n days]\n",
 			strip_path(argv[0]));
 
 		printf(
@@ -270,7 +293,9 @@ main(int argc, char *argv[])
 			"   -s : don't use server log files\n"
 			"   -l : don't use scheduler log files\n"
 			"   -m : don't use mom log files\n"
-			"   -v : verbose mode - show more error messages\n");
+			"   -v : verbose mode - show more error messages\n"
+			"   -x : don't use log file job indexes, read the whole files\n"
+			"   -I : (re)build the job indexes of the log files of past days\n");
 
 		printf("\n       %s --version\n", strip_path(argv[0]));
 		printf("   --version : display PBSPro version only\n\n");
@@ -290,6 +315,30 @@ main(int argc, char *argv[])
 	time(&t);
 	t_save = t;
 
+	if (make_index) {
+		/* today's files are still being written, start with yesterday */
+		for (i = 1, t = t_save - SECONDS_IN_DAY; i <= number_of_days; i++, t -= SECONDS_IN_DAY) {
+			tm_ptr = localtime(&t);
+			for (j = 0; j < 4; j++) {
+				if ((j == IND_ACCT && no_acct) || (j == IND_SERVER && no_svr) ||
+					(j == IND_MOM && no_mom)   || (j == IND_SCHED && no_schd))
+					continue;
+#ifdef NAS /* localmod 022 */
+				filename = log_path(prefix_path, j, 0, tm_ptr->tm_mon, tm_ptr->tm_mday, tm_ptr->tm_year);
+#else
+				filename = log_path(prefix_path, j, tm_ptr->tm_mon, tm_ptr->tm_mday, tm_ptr->tm_year);
+#endif /* localmod 022 */
+				if (build_index(filename, j) != 0) {
+					if (verbose || errno != ENOENT)
+						perror(filename);
+					if (errno != ENOENT)
+						error = 1;
+				}
+			}
+		}
+		return (error ? 1 : 0);
+	}
+
 	for (opt = optind; opt < argc; opt++) {
 		ll_cur_amm = 0;	/* reset line count to zero */
 		for (i = 0, t = t_save; i < number_of_days; i++, t -= SECONDS_IN_DAY) {
@@ -318,7 +367,8 @@ main(int argc, char *argv[])
 					continue;
 				}
 
-				parse_log(fp, argv[opt], j);
+				if (!use_index || parse_log_indexed(fp, filename, argv[opt], j) != 0)
+					parse_log(fp, argv[opt], j);
 
 				fclose(fp);
 			}
@@ -364,6 +414,205 @@ main(int argc, char *argv[])
 	return 0;
 }
 
+/**
+ * @brief
+ *		read_log_line - read one whole line of a log file, growing the
+ *		    buffer as needed
+ *
+ * @param[in]		fp	-	the log file
+ * @param[in,out]	pbuf	-	the buffer, may be reallocated
+ * @param[in,out]	pbuf_size -	the size of the buffer
+ *
+ * @return	int
+ * @retval	length of the line, including the newline if there is one
+ * @retval	-1 : end of file or out of memory
+ */
+static int
+read_log_line(FILE *fp, char **pbuf, int *pbuf_size)
+{
+	char *tbuf;		/* temporarily hold realloc's for main buffer */
+	int len;
+
+	if (fgets(*pbuf, *pbuf_size, fp) == NULL)
+		return -1;
+	len = strlen(*pbuf);
+	while (*pbuf_size == len + 1 && (*pbuf)[len - 1] != '\n') {
+		*pbuf_size *= 2;
+		tbuf = (char*)realloc(*pbuf, (*pbuf_size + 1) * sizeof(char));
+		if (!tbuf)
+			return -1;
+		*pbuf = tbuf;
+		if (fgets(*pbuf + len, *pbuf_size/2 + 1, fp) == NULL)
+			break;
+		len += strlen(*pbuf + len);
+	}
+	return len;
+}
+
+/**
+ * @brief
+ *		job_name_match - does log record name 'name' belong to job 'job'?
+ *		    A job id given without a server suffix matches the record
+ *		    name up to its first '.'.
+ *
+ * @param[in]	job	-	the job id asked for
+ * @param[in]	name	-	the object name of a log record
+ *
+ * @return	int
+ * @retval	1 : match
+ * @retval	0 : no match
+ */
+static int
+job_name_match(char *job, char *name)
+{
+	int slen;
+	int tlen;
+
+	if (name == NULL)
+		return 0;
+	if (strchr(job, (int)'.') == NULL) {
+		tlen = strlen(job);
+		slen = strcspn(name, ".");
+		if (tlen > slen)
+			slen = tlen;
+	} else
+		slen = strlen(job);
+
+	return (strncmp(job, name, slen) == 0);
+}
+
+/**
+ * @brief
+ *		parse_line - split one log line and, if it is about the job,
+ *		    add it to the log_entry array
+ *
+ * @param[in,out]	buf	-	the line, without its newline; it is modified
+ * @param[in]	job	-	the name of the job
+ * @param[in]	ind	-	which log file - index in enum index
+ * @param[in]	lineno	-	position of the line, to stabilize the sort
+ *
+ * @return	int
+ * @retval	1 : the line was about the job and was added
+ * @retval	0 : it was not
+ *
+ * @note
+ *		modifies global variables: loglines, ll_cur_amm, ll_max_amm
+ *
+ * @par MT-safe: No
+ */
+static int
+parse_line(char *buf, char *job, int ind, int lineno)
+{
+	struct log_entry tmp;	/* temporary log entry */
+	char *p;		/* pointer to use for strtok */
+	int field_count;	/* which field in log entry */
+	struct tm tms;		/* used to convert date to unix date */
+
+	tms.tm_isdst = -1;	/* mktime() will attempt to figure it out */
+
+	p = strtok(buf, ";");
+	field_count = 0;
+	memset(&tmp, 0, sizeof(struct log_entry));
+
+	for (field_count = 0; field_count < 6 && p != NULL; field_count++) {
+		switch (field_count) {
+			case FLD_DATE:
+				tmp.date = p;
+				if (ind == IND_ACCT)
+					field_count = 2;
+				break;
+
+			case FLD_EVENT:
+				tmp.event = p;
+				break;
+
+			case FLD_OBJ:
+				tmp.obj = p;
+				break;
+
+			case FLD_TYPE:
+				tmp.type = p;
+				break;
+
+			case FLD_NAME:
+				tmp.name = p;
+				break;
+
+			case FLD_MSG:
+				tmp.msg = p;
+				break;
+
+			default:
+				printf("Field count too big!\n");
+				printf("%s\n", p);
+		}
+
+		p = strtok(NULL, ";");
+	}
+
+	if (!job_name_match(job, tmp.name))
+		return 0;
+
+	if (ll_cur_amm >= ll_max_amm)
+		alloc_more_space();
+
+	free_log_entry(&log_lines[ll_cur_amm]);
+
+	if (tmp.date != NULL) {
+		log_lines[ll_cur_amm].date = strdup(tmp.date);
+		if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d", &tms.tm_mon, &tms.tm_mday, &tms.tm_year, &tms.tm_hour, &tms.tm_min, &tms.tm_sec) != 6)
+			log_lines[ll_cur_amm].date_time = -1;	/* error in date field */
+		else {
+			if (tms.tm_year > 1900)
+				tms.tm_year -= 1900;
+			tms.tm_mon--;         /* The number of months since January, in the range 0 to 11 for mktime */
+			log_lines[ll_cur_amm].date_time = mktime(&tms);
+		}
+	}
+	if (tmp.event != NULL)
+		log_lines[ll_cur_amm].event = strdup(tmp.event);
+	else
+		log_lines[ll_cur_amm].event = none;
+	if (tmp.obj != NULL)
+		log_lines[ll_cur_amm].obj = strdup(tmp.obj);
+	else
+		log_lines[ll_cur_amm].obj = none;
+	if (tmp.type != NULL)
+		log_lines[ll_cur_amm].type = strdup(tmp.type);
+	else
+		log_lines[ll_cur_amm].type = none;
+	if (tmp.name != NULL)
+		log_lines[ll_cur_amm].name = strdup(tmp.name);
+	else
+		log_lines[ll_cur_amm].name = none;
+	if (tmp.msg != NULL)
+		log_lines[ll_cur_amm].msg = strdup(tmp.msg);
+	else
+		log_lines[ll_cur_amm].msg = none;
+	switch (ind) {
+		case IND_SERVER:
+			log_lines[ll_cur_amm].log_file = 'S';
+			break;
+
+		case IND_SCHED:
+			log_lines[ll_cur_amm].log_file = 'L';
+			break;
+
+		case IND_ACCT:
+			log_lines[ll_cur_amm].log_file = 'A';
+			break;
+
+		case IND_MOM:
+			log_lines[ll_cur_amm].log_file = 'M';
+			break;
+		default:
+			log_lines[ll_cur_amm].log_file = 'U';	/* undefined */
+	}
+	log_lines[ll_cur_amm].lineno = lineno;
+	ll_cur_amm++;
+	return 1;
+}
+
 /**
  * @brief
  *		parse_log - parse out entires of a log file for a specific job
@@ -382,158 +631,215 @@ main(int argc, char *argv[])
 void
 parse_log(FILE *fp, char *job, int ind)
 {
-	struct log_entry tmp;	/* temporary log entry */
 	char *buf;		/* buffer to read in from file */
-	char *tbuf;		/* temporarily hold realloc's for main buffer */
-	char job_buf[128];	/* hold the jobid and the . */
-	char *p;		/* pointer to use for strtok */
-	int field_count;	/* which field in log entry */
-	int j = 0;
-	struct tm tms;		/* used to convert date to unix date */
 	int lineno = 0;
-	int slen;
-	char *pdot;
+	int len;
 	int buf_size = 16384;	/* initial buffer size */
-	int break_fl = 0;
 
 	buf = (char*)calloc(buf_size, sizeof(char));
 	if (!buf)
 		return;
 
-	tms.tm_isdst = -1;	/* mktime() will attempt to figure it out */
+	while ((len = read_log_line(fp, &buf, &buf_size)) > 0) {
+		lineno++;
+		buf[len-1] = '\0';
+		parse_line(buf, job, ind, lineno);
+	}
+	free(buf);
+}
+
+/**
+ * @brief
+ *		compare function for qsort of log file offsets
+ */
+static int
+cmp_offset(const void *v1, const void *v2)
+{
+	long long o1 = *(const long long *)v1;
+	long long o2 = *(const long long *)v2;
 
-	strcpy(job_buf, job);
+	return ((o1 < o2) ? -1 : ((o1 > o2) ? 1 : 0));
+}
 
-	while (fgets(buf, buf_size, fp) != NULL) {
-		while (buf_size == (strlen(buf) + 1)) {
-			buf_size *= 2;
-			tbuf = (char*)realloc(buf, (buf_size + 1) * sizeof(char));
-			if (!tbuf) {
-				break_fl = 1;
-				break;
-			}
-			buf = tbuf;
-			if(fgets(buf + strlen(buf), buf_size/2 + 1, fp) == NULL) {
-				break_fl = 1;
-				break;
+/**
+ * @brief
+ *		parse_log_indexed - like parse_log(), but read only the records
+ *		    that the job index of the log file, "<file>.idx", lists for
+ *		    the job.  See log_index_open().
+ *
+ * @param[in]	fp	-	the log file
+ * @param[in]	filename -	path of the log file
+ * @param[in]	job	-	the name of the job
+ * @param[in]	ind	-	which log file - index in enum index
+ *
+ * @return	int
+ * @retval	0 : the records of the job were read through the index
+ * @retval	-1 : there is no usable index, the whole file must be read
+ *
+ * @note
+ *		modifies global variables: loglines, ll_cur_amm, ll_max_amm
+ *
+ * @par MT-safe: No
+ */
+int
+parse_log_indexed(FILE *fp, char *filename, char *job, int ind)
+{
+	char idxname[MAXPATHLEN+1];
+	char idline[PBS_MAXSVRJOBID + 64];
+	char *key;
+	FILE *idx;
+	long long off;
+	long long *offs = NULL;
+	long long *toffs;
+	int noffs = 0;
+	int maxoffs = 0;
+	int first = ll_cur_amm;
+	char *buf;
+	int buf_size = 16384;
+	int len;
+	int i;
+	int rc = 0;
+
+	if (snprintf(idxname, sizeof(idxname), "%s%s", filename, LOG_INDEX_SUFFIX) >= sizeof(idxname))
+		return -1;
+	if ((idx = fopen(idxname, "r")) == NULL)
+		return -1;
+
+	while (fgets(idline, sizeof(idline), idx) != NULL) {
+		/* "<offset> <id>" */
+		off = strtoll(idline, &key, 10);
+		if (key == idline || *key != ' ')
+			continue;
+		key++;
+		key[strcspn(key, "\n")] = '\0';
+		if (!job_name_match(job, key))
+			continue;
+		if (noffs == maxoffs) {
+			maxoffs = maxoffs ? maxoffs * 2 : 64;
+			toffs = realloc(offs, maxoffs * sizeof(long long));
+			if (toffs == NULL) {
+				free(offs);
+				fclose(idx);
+				return -1;
 			}
+			offs = toffs;
 		}
-		if (break_fl)
-			break;
-		lineno++;
-		j++;
-		buf[strlen(buf)-1] = '\0';
-		p = strtok(buf, ";");
-		field_count = 0;
-		memset(&tmp, 0, sizeof(struct log_entry));
-
-		for (field_count = 0; field_count < 6 && p != NULL; field_count++) {
-			switch (field_count) {
-				case FLD_DATE:
-					tmp.date = p;
-					if (ind == IND_ACCT)
-						field_count = 2;
-					break;
-
-				case FLD_EVENT:
-					tmp.event = p;
-					break;
-
-				case FLD_OBJ:
-					tmp.obj = p;
-					break;
-
-				case FLD_TYPE:
-					tmp.type = p;
-					break;
-
-				case FLD_NAME:
-					tmp.name = p;
-					break;
-
-				case FLD_MSG:
-					tmp.msg = p;
-					break;
-
-				default:
-					printf("Field count too big!\n");
-					printf("%s\n", p);
-			}
+		offs[noffs++] = off;
+	}
+	fclose(idx);
+
+	if (noffs == 0)
+		return 0;
+
+	if ((buf = (char*)calloc(buf_size, sizeof(char))) == NULL) {
+		free(offs);
+		return -1;
+	}
 
-			p = strtok(NULL, ";");
+	qsort(offs, noffs, sizeof(long long), cmp_offset);
+	for (i = 0; i < noffs; i++) {
+		if (i > 0 && offs[i] == offs[i-1])
+			continue;
+		/* an indexed record must start right after a newline */
+		if (fseeko(fp, offs[i] > 0 ? offs[i] - 1 : 0, SEEK_SET) != 0 ||
+			(offs[i] > 0 && getc(fp) != '\n')) {
+			rc = -1;
+			break;
+		}
+		len = read_log_line(fp, &buf, &buf_size);
+		if (len <= 0 || buf[len-1] != '\n')
+			continue;	/* record not completely written yet */
+		buf[len-1] = '\0';
+		if (parse_line(buf, job, ind, i + 1) == 0) {
+			rc = -1;	/* index does not match the file */
+			break;
 		}
+	}
+	free(buf);
+	free(offs);
 
-		pdot = strchr(job_buf, (int)'.');
-		if (pdot == NULL && tmp.name != NULL) {
-			int	tlen = strlen(job_buf);
-
-			slen = strcspn(tmp.name, ".");
-			if (tlen > slen)
-				slen = tlen;
-		} else
-			slen = strlen(job_buf);
-
-		if (tmp.name != NULL && strncmp(job_buf, tmp.name, slen) == 0) {
-			if (ll_cur_amm >= ll_max_amm)
-				alloc_more_space();
-
-			free_log_entry(&log_lines[ll_cur_amm]);
-
-			if (tmp.date != NULL) {
-				log_lines[ll_cur_amm].date = strdup(tmp.date);
-				if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d", &tms.tm_mon, &tms.tm_mday, &tms.tm_year, &tms.tm_hour, &tms.tm_min, &tms.tm_sec) != 6)
-					log_lines[ll_cur_amm].date_time = -1;	/* error in date field */
-				else {
-					if (tms.tm_year > 1900)
-						tms.tm_year -= 1900;
-					tms.tm_mon--;         /* The number of months since January, in the range 0 to 11 for mktime */
-					log_lines[ll_cur_amm].date_time = mktime(&tms);
-				}
-			}
-			if (tmp.event != NULL)
-				log_lines[ll_cur_amm].event = strdup(tmp.event);
-			else
-				log_lines[ll_cur_amm].event = none;
-			if (tmp.obj != NULL)
-				log_lines[ll_cur_amm].obj = strdup(tmp.obj);
-			else
-				log_lines[ll_cur_amm].obj = none;
-			if (tmp.type != NULL)
-				log_lines[ll_cur_amm].type = strdup(tmp.type);
-			else
-				log_lines[ll_cur_amm].type = none;
-			if (tmp.name != NULL)
-				log_lines[ll_cur_amm].name = strdup(tmp.name);
-			else
-				log_lines[ll_cur_amm].name = none;
-			if (tmp.msg != NULL)
-				log_lines[ll_cur_amm].msg = strdup(tmp.msg);
-			else
-				log_lines[ll_cur_amm].msg = none;
-			switch (ind) {
-				case IND_SERVER:
-					log_lines[ll_cur_amm].log_file = 'S';
-					break;
-
-				case IND_SCHED:
-					log_lines[ll_cur_amm].log_file = 'L';
-					break;
-
-				case IND_ACCT:
-					log_lines[ll_cur_amm].log_file = 'A';
-					break;
-
-				case IND_MOM:
-					log_lines[ll_cur_amm].log_file = 'M';
-					break;
-				default:
-					log_lines[ll_cur_amm].log_file = 'U';	/* undefined */
-			}
-			log_lines[ll_cur_amm].lineno = lineno;
-			ll_cur_amm++;
+	if (rc != 0) {
+		/* drop what was read through the stale index */
+		while (ll_cur_amm > first)
+			free_log_entry(&log_lines[--ll_cur_amm]);
+		rewind(fp);
+	}
+	return rc;
+}
+
+/**
+ * @brief
+ *		build_index - (re)build the job index of a log file, the same
+ *		    index the daemons keep with PBS_LOG_INDEX set in pbs.conf
+ *
+ * @param[in]	filename -	path of the log file
+ * @param[in]	ind	-	which log file - index in enum index
+ *
+ * @return	int
+ * @retval	0 : success
+ * @retval	-1 : failure, errno is set
+ */
+int
+build_index(char *filename, int ind)
+{
+	char idxname[MAXPATHLEN+1];
+	char tmpname[MAXPATHLEN+1];
+	FILE *fp;
+	FILE *idx;
+	char *buf;
+	char *fields[5];
+	char *p;
+	int buf_size = 16384;
+	int len;
+	int nf;
+	int name_fld = (ind == IND_ACCT) ? 2 : FLD_NAME;
+	long long off;
+	int rc = 0;
+
+	if ((snprintf(idxname, sizeof(idxname), "%s%s", filename, LOG_INDEX_SUFFIX) >= sizeof(idxname)) ||
+		(snprintf(tmpname, sizeof(tmpname), "%s.tmp", idxname) >= sizeof(tmpname))) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if ((fp = fopen(filename, "r")) == NULL)
+		return -1;
+	if ((buf = (char*)calloc(buf_size, sizeof(char))) == NULL) {
+		fclose(fp);
+		return -1;
+	}
+	if ((idx = fopen(tmpname, "w")) == NULL) {
+		free(buf);
+		fclose(fp);
+		return -1;
+	}
+
+	for (off = ftello(fp); (len = read_log_line(fp, &buf, &buf_size)) > 0; off = ftello(fp)) {
+		if (buf[len-1] != '\n')
+			break;
+		buf[len-1] = '\0';
+		/* date;event;obj;type;name;... or, for accounting, date;type;name;... */
+		for (nf = 0, p = buf; nf < 5 && p != NULL; nf++) {
+			fields[nf] = p;
+			if ((p = strchr(p, ';')) != NULL)
+				*p++ = '\0';
 		}
+		if (nf <= name_fld)
+			continue;
+		if (ind != IND_ACCT && strcmp(fields[FLD_TYPE], "Job") != 0 &&
+			strcmp(fields[FLD_TYPE], "Resv") != 0 &&
+			!isdigit((int)(unsigned char)fields[FLD_NAME][0]))
+			continue;
+		fprintf(idx, "%lld %s\n", off, fields[name_fld]);
 	}
+	if (ferror(fp) || fclose(idx) != 0)
+		rc = -1;
+	if (rc == 0 && rename(tmpname, idxname) != 0)
+		rc = -1;
+	if (rc != 0)
+		(void)unlink(tmpname);
 	free(buf);
+	fclose(fp);
+	return rc;
 }
 
 /**
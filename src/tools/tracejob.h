@@ -108,6 +108,8 @@ struct log_entry
 /* prototypes */
 int sort_by_date(const void *v1, const void *v2);
 void parse_log(FILE *fp, char *job, int act);
+int parse_log_indexed(FILE *fp, char *filename, char *job, int act);
+int build_index(char *filename, int act);
 char *strip_path(char *path);
 void free_log_entry(struct log_entry *lg);
 void line_wrap(char *line, int start, int end);
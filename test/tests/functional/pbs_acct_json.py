@@ -0,0 +1,102 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+import json
+import time
+from tests.functional import *
+
+
+class TestAcctJson(TestFunctional):
+    """
+    Test the JSON lines accounting records written with
+    PBS_ACCT_FORMAT in pbs.conf
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.du.set_pbs_config(self.server.hostname,
+                               confs={'PBS_ACCT_FORMAT': 'both'})
+        self.server.restart()
+
+    def json_records(self, jid):
+        """
+        Return the JSON accounting records of job jid
+        """
+        fname = os.path.join(self.server.pbs_conf['PBS_HOME'],
+                             'server_priv', 'accounting',
+                             time.strftime('%Y%m%d') + '.json')
+        ret = self.du.cat(self.server.hostname, fname, sudo=True)
+        recs = []
+        for line in ret['out']:
+            rec = json.loads(line)
+            if rec['id'] == jid:
+                recs.append(rec)
+        return recs
+
+    def test_acct_json_queue_record(self):
+        """
+        Test that a queued job gets the same Q record in the text and
+        in the JSON accounting file
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.server.accounting_match('Q;%s;queue=workq' % jid)
+        recs = [r for r in self.json_records(jid) if r['type'] == 'Q']
+        self.assertEqual(len(recs), 1)
+        self.assertEqual(recs[0]['record']['queue'], 'workq')
+
+    def test_acct_json_end_record(self):
+        """
+        Test that the E record of a job carries its exec_vnode and
+        resources_used values in the JSON accounting file
+        """
+        j = Job(TEST_USER)
+        j.set_sleep_time(1)
+        jid = self.server.submit(j)
+        self.server.accounting_match('E;%s;' % jid, max_attempts=30)
+        recs = [r for r in self.json_records(jid) if r['type'] == 'E']
+        self.assertEqual(len(recs), 1)
+        self.assertIn('exec_vnode', recs[0]['record'])
+        self.assertIn('resources_used.walltime', recs[0]['record'])
+        self.assertEqual(recs[0]['record']['user'], str(TEST_USER))
+
+    def tearDown(self):
+        self.du.unset_pbs_config(self.server.hostname,
+                                 confs=['PBS_ACCT_FORMAT'])
+        self.server.restart()
+        TestFunctional.tearDown(self)
@@ -0,0 +1,101 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+from tests.functional import *
+
+
+class TestArrayBatch(TestFunctional):
+    """
+    Test running subjobs of a job array in batches with the
+    array_batch_size scheduler parameter
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 8}
+        self.server.create_vnodes('vnode', a, 1, self.mom, usenatvnode=True)
+        self.scheduler.set_sched_config({'log_filter': 2048})
+        self.t = int(time.time())
+
+    def submit_array(self, indices):
+        """
+        Submit a job array with scheduling turned off and return its id
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        a = {'Resource_List.select': '1:ncpus=1', ATTR_J: indices}
+        j = Job(TEST_USER, attrs=a)
+        jid = self.server.submit(j)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        return jid
+
+    def test_array_batch(self):
+        """
+        Test that subjobs are run in batches of array_batch_size, that
+        identical subjobs reuse the placement of the previous one and
+        that the array stops at the available ncpus
+        """
+        self.scheduler.set_sched_config({'array_batch_size': 4})
+        jid = self.submit_array('1-10')
+        a = {'array_state_count': 'Queued:2 Running:8 Exiting:0 Expired:0 ',
+             'array_indices_remaining': '9-10'}
+        self.server.expect(JOB, a, id=jid)
+        self.scheduler.log_match(jid + ";Ran 4 subjobs in one batch, "
+                                 "3 placements reused", starttime=self.t)
+
+    def test_array_batch_unused_sort(self):
+        """
+        Test that placements are not reused when the node order depends
+        on the unused resources of the vnodes
+        """
+        self.scheduler.set_sched_config({'array_batch_size': 4,
+                                         'node_sort_key':
+                                         '\"ncpus HIGH unused\" ALL'})
+        jid = self.submit_array('1-4')
+        a = {'array_state_count': 'Queued:0 Running:4 Exiting:0 Expired:0 '}
+        self.server.expect(JOB, a, id=jid)
+        self.scheduler.log_match(jid + ";Ran 4 subjobs in one batch, "
+                                 "0 placements reused", starttime=self.t)
+
+    def test_array_batch_default(self):
+        """
+        Test that subjobs are run one at a time by default
+        """
+        jid = self.submit_array('1-4')
+        a = {'array_state_count': 'Queued:0 Running:4 Exiting:0 Expired:0 '}
+        self.server.expect(JOB, a, id=jid)
+        self.scheduler.log_match(jid + ";Ran",
+                                 starttime=self.t, existence=False,
+                                 max_attempts=2)
@@ -0,0 +1,76 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestHookServerJobsFilter(TestFunctional):
+    """
+    Test the username and state filters of pbs.server().jobs()
+    """
+    hook_script = """
+import pbs
+e = pbs.event()
+n = 0
+for j in pbs.server().jobs(username=e.requestor,
+                           state=pbs.JOB_STATE_QUEUED):
+    n += 1
+pbs.logmsg(pbs.LOG_DEBUG, "queued jobs of %s=%d" % (e.requestor, n))
+e.accept()
+"""
+
+    def test_jobs_by_user_and_state(self):
+        """
+        Only the requestor's queued jobs are returned; a held job of the
+        requestor and another user's queued job are left out.
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jid1 = self.server.submit(Job(TEST_USER))
+        jid2 = self.server.submit(Job(TEST_USER))
+        self.server.submit(Job(TEST_USER1))
+        self.server.holdjob(jid2)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid1)
+        self.server.expect(JOB, {'job_state': 'H'}, id=jid2)
+
+        attrs = {'event': 'queuejob', 'enabled': 'True'}
+        rv = self.server.create_import_hook("jobs_filter", attrs,
+                                            self.hook_script,
+                                            overwrite=True)
+        self.assertTrue(rv)
+        self.server.submit(Job(TEST_USER))
+        self.server.log_match("queued jobs of %s=1" % (str(TEST_USER),),
+                              starttime=self.server.ctime)
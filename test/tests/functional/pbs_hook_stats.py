@@ -0,0 +1,92 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestHookStats(TestFunctional):
+    """
+    Test the read-only 'stats' attribute of server hooks
+    """
+    hook_script = """
+import pbs
+e = pbs.event()
+if e.job.Job_Name == "reject_me":
+    e.reject("rejected by hook")
+e.accept()
+"""
+
+    def test_queuejob_stats(self):
+        """
+        A queuejob hook that accepts one job and rejects another reports
+        two executions, one accept and one reject.
+        """
+        qmgr_path = os.path.join(self.server.pbs_conf["PBS_EXEC"], "bin",
+                                 "qmgr")
+        if not os.path.isfile(qmgr_path):
+            self.skipTest("qmgr binary not found!")
+
+        attrs = {'event': 'queuejob', 'enabled': 'True'}
+        rv = self.server.create_import_hook("stats_hook", attrs,
+                                            self.hook_script,
+                                            overwrite=True)
+        self.assertTrue(rv)
+
+        self.server.submit(Job(TEST_USER))
+        j = Job(TEST_USER, attrs={ATTR_N: 'reject_me'})
+        with self.assertRaises(PbsSubmitError) as e:
+            self.server.submit(j)
+        self.assertTrue("rejected by hook" in e.exception.msg[0])
+
+        if self.du.is_localhost(self.server.hostname) is True:
+            qmgr_cmd = [qmgr_path, "-c", "list hook stats_hook stats"]
+        else:
+            qmgr_cmd = [qmgr_path, "-c", "\'list hook stats_hook stats\'"]
+        ret = self.du.run_cmd(self.server.hostname, qmgr_cmd, sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        out = "".join([l.strip() for l in ret['out']])
+        self.assertTrue("queuejob:count=2;accept=1;reject=1" in out)
+
+        # Re-importing the script starts the statistics over
+        rv = self.server.create_import_hook("stats_hook", attrs,
+                                            self.hook_script,
+                                            overwrite=True)
+        self.assertTrue(rv)
+        ret = self.du.run_cmd(self.server.hostname, qmgr_cmd, sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        out = "".join([l.strip() for l in ret['out']])
+        self.assertFalse("queuejob:" in out)
@@ -0,0 +1,70 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+from tests.functional import *
+
+
+class TestNodeStatusCache(TestFunctional):
+    """
+    Test that node status stays current when the server reuses
+    the encoded values of node attributes between status requests
+    """
+
+    def test_comment_and_assigned_update(self):
+        """
+        Test that repeated node status picks up a changed comment and
+        the resources assigned to a job
+        """
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'comment': 'first'}, id=self.mom.shortname)
+        self.server.expect(NODE, {'comment': 'first'}, id=self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'comment': 'second'}, id=self.mom.shortname)
+        self.server.expect(NODE, {'comment': 'second'},
+                           id=self.mom.shortname, max_attempts=1)
+        self.server.manager(MGR_CMD_UNSET, NODE, 'comment',
+                            id=self.mom.shortname)
+        self.server.expect(NODE, 'comment', op=UNSET,
+                           id=self.mom.shortname, max_attempts=1)
+
+        j = Job(TEST_USER, {'Resource_List.select': '1:ncpus=1'})
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.expect(NODE, {'resources_assigned.ncpus': 1},
+                           id=self.mom.shortname)
+        self.server.delete(jid, wait=True)
+        self.server.expect(NODE, {'resources_assigned.ncpus': 0},
+                           id=self.mom.shortname)
@@ -0,0 +1,117 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+from tests.functional import *
+
+
+class TestQsubBatch(TestFunctional):
+    """
+    Test submission of several jobs in one request with qsub --batch
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.qsub_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                     'bin', 'qsub')
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def check_jobs(self, ret, names):
+        """
+        Verify that qsub printed one job id per name, in order, and
+        that the jobs are queued
+        """
+        self.assertEqual(ret['rc'], 0)
+        self.assertEqual(len(ret['out']), len(names))
+        for name, jid in zip(names, ret['out']):
+            self.server.expect(JOB, {'Job_Name': name,
+                                     'job_state': 'Q'}, id=jid)
+
+    def test_batch_submit(self):
+        """
+        Submit a batch of jobs with per-line options from a file and
+        verify that they are created by a single request
+        """
+        names = ['batch%d' % i for i in range(10)]
+        lines = ['# comment line', '']
+        lines += ['-N %s -- /bin/sleep 100' % n for n in names]
+        fn = self.du.create_temp_file(asuser=TEST_USER,
+                                      body='\n'.join(lines) + '\n')
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=[self.qsub_cmd, '--batch', fn],
+                              runas=TEST_USER)
+        self.check_jobs(ret, names)
+        self.server.log_match('10 jobs submitted in one request')
+
+    def test_batch_submit_shared_script(self):
+        """
+        Submit jobs sharing one script from standard input and verify
+        that each job gets the script and its own variables
+        """
+        script = self.du.create_temp_file(asuser=TEST_USER,
+                                          body='#!/bin/sh\nsleep 100\n')
+        names = ['shared%d' % i for i in range(5)]
+        lines = ['-N %s -v IDX=%d %s' % (n, i, script)
+                 for i, n in enumerate(names)]
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=[self.qsub_cmd, '--batch', '-'],
+                              input='\n'.join(lines) + '\n',
+                              runas=TEST_USER)
+        self.check_jobs(ret, names)
+        for i, jid in enumerate(ret['out']):
+            job = self.server.status(JOB, 'Variable_List', id=jid)
+            self.assertIn('IDX=%d' % i, job[0]['Variable_List'])
+
+    def test_batch_submit_all_or_none(self):
+        """
+        Verify that no job is created when one line cannot be parsed
+        or when the server rejects one of the jobs
+        """
+        for bad in ['-l nosuchresource=1 -- /bin/sleep 100',
+                    '-q nosuchqueue -- /bin/sleep 100']:
+            lines = ['-N good1 -- /bin/sleep 100', bad,
+                     '-N good2 -- /bin/sleep 100']
+            fn = self.du.create_temp_file(asuser=TEST_USER,
+                                          body='\n'.join(lines) + '\n')
+            ret = self.du.run_cmd(self.server.hostname,
+                                  cmd=[self.qsub_cmd, '--batch', fn],
+                                  runas=TEST_USER)
+            self.assertNotEqual(ret['rc'], 0)
+            self.assertEqual(len(ret['out']), 0)
+            jobs = self.server.status(JOB)
+            self.assertEqual(len(jobs), 0)